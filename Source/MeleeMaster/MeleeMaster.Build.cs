@@ -43,7 +43,9 @@ public class MeleeMaster : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
-				"NetCore"
+				"NetCore",
+				"Niagara",
+				"Json"
 				// ... add private dependencies that you statically link with here ...	
 			}
 		);
@@ -55,5 +57,8 @@ public class MeleeMaster : ModuleRules
 				// ... add any modules that your module loads dynamically here ...
 			}
 		);
+
+		// Weapons are registered subobjects, so the module can run under the Iris replication system
+		SetupIrisSupport(Target);
 	}
 }
\ No newline at end of file
@@ -27,6 +27,16 @@ void AArrowVisual::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
+void AArrowVisual::OnAcquiredFromPool_Implementation()
+{
+	Show();
+}
+
+void AArrowVisual::OnReleasedToPool_Implementation()
+{
+	Hide();
+}
+
 void AArrowVisual::SetSkeletal(USkeletalMesh* InMesh)
 {
 	SkeletalMeshComponent->SetSkeletalMesh(InMesh);
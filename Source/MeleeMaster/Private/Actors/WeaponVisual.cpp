@@ -3,9 +3,11 @@
 
 #include "Actors/WeaponVisual.h"
 #include "Components/AdvancedWeaponManager.h"
+#include "Components/StaticMeshComponent.h"
 #include "Net/UnrealNetwork.h"
 #include "Net/Core/PushModel/PushModel.h"
 #include "Objects/AbstractWeapon.h"
+#include "Subsystems/TrailSubsystem.h"
 
 // Sets default values
 AWeaponVisual::AWeaponVisual()
@@ -18,14 +20,26 @@ AWeaponVisual::AWeaponVisual()
 	SkeletalMeshComponent = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("SkeletalMesh"));
 	SkeletalMeshComponent->SetupAttachment(Base);
 	SkeletalMeshComponent->SetComponentTickEnabled(false);
+	ProxyMeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ProxyMesh"));
+	ProxyMeshComponent->SetupAttachment(Base);
+	ProxyMeshComponent->SetComponentTickEnabled(false);
+	ProxyMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProxyMeshComponent->SetGenerateOverlapEvents(false);
+	ProxyMeshComponent->CastShadow = false;
+	ProxyMeshComponent->SetVisibility(false);
 
 	bReplicates = true;
+	// Replicated state changes rarely (handle, attachment), wake up only via FlushNetDormancy
+	NetDormancy = DORM_DormantAll;
+	SetNetUpdateFrequency(1.0f);
 
 	HandSocket = FName(TEXT("None"));
 	BackSocket = FName(TEXT("None"));
+	TrailStartSocket = FName(TEXT("None"));
+	TrailEndSocket = FName(TEXT("None"));
 }
 
-void AWeaponVisual::OnRep_Guid()
+void AWeaponVisual::OnRep_WeaponHandle()
 {
 }
 
@@ -34,13 +48,18 @@ void AWeaponVisual::BeginPlay()
 {
 	Super::BeginPlay();
 
+	AttachToWeaponManager();
+}
+
+void AWeaponVisual::AttachToWeaponManager()
+{
 	if (AActor* owner = GetOwner())
 	{
-		if (UAdvancedWeaponManager* manager = owner->FindComponentByClass<UAdvancedWeaponManager>())
+		if (UAdvancedWeaponManager* manager = UAdvancedWeaponManager::FindForActor(owner))
 		{
 			UAbstractWeapon* currentWeapon = manager->GetCurrentWeapon();
 
-			if (IsValid(currentWeapon) && currentWeapon->GetGUIDString() == WeaponGuid)
+			if (IsValid(currentWeapon) && currentWeapon->GetHandle() == WeaponHandle)
 			{
 				manager->AttachHand(this);
 			}
@@ -58,12 +77,28 @@ void AWeaponVisual::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
+void AWeaponVisual::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	if (CumulativeResourceSize.GetResourceSizeMode() != EResourceSizeMode::EstimatedTotal)
+		return;
+
+	if (SkeletalMeshComponent)
+	{
+		SkeletalMeshComponent->GetResourceSizeEx(CumulativeResourceSize);
+	}
+	if (ProxyMeshComponent)
+	{
+		ProxyMeshComponent->GetResourceSizeEx(CumulativeResourceSize);
+	}
+}
+
 void AWeaponVisual::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	FDoRepLifetimeParams Params;
 	Params.bIsPushBased = true;
-	DOREPLIFETIME_WITH_PARAMS_FAST(AWeaponVisual, WeaponGuid, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeaponVisual, WeaponHandle, Params);
 }
 
 bool AWeaponVisual::IsLocalPlayer() const
@@ -87,30 +122,109 @@ void AWeaponVisual::PlayAnim_Implementation(const FAnimPlayData& InData, bool bF
 
 void AWeaponVisual::Hide()
 {
-	HideTrail();
+	StopTrail();
 	SkeletalMeshComponent->CastShadow = false;
 	SkeletalMeshComponent->bCastHiddenShadow = false;
 	SkeletalMeshComponent->SetVisibility(false);
 	SkeletalMeshComponent->SetHiddenInGame(true);
+	ProxyMeshComponent->SetVisibility(false);
+	ProxyMeshComponent->SetHiddenInGame(true);
 	this->SetHidden(true);
 }
 
 void AWeaponVisual::Show()
 {
-	SkeletalMeshComponent->CastShadow = true;
-	SkeletalMeshComponent->bCastHiddenShadow = true;
-	SkeletalMeshComponent->SetVisibility(true);
 	SkeletalMeshComponent->SetHiddenInGame(false);
+	ProxyMeshComponent->SetHiddenInGame(false);
 	this->SetHidden(false);
+	ApplyVisualLOD();
+}
+
+void AWeaponVisual::SetVisualLOD(EWeaponVisualLOD InLOD)
+{
+	if (VisualLOD == InLOD)
+		return;
+
+	VisualLOD = InLOD;
+	// Hidden visual (local player back, pool) gets it on Show
+	if (!IsHidden())
+	{
+		ApplyVisualLOD();
+	}
+}
+
+void AWeaponVisual::SetAttachedToBack(bool bInBack)
+{
+	if (bAttachedToBack == bInBack)
+		return;
+
+	bAttachedToBack = bInBack;
+	if (!IsHidden() && VisualLOD == EWeaponVisualLOD::Proxy)
+	{
+		ApplyVisualLOD();
+	}
+}
+
+bool AWeaponVisual::ShouldUseProxyMesh() const
+{
+	return VisualLOD == EWeaponVisualLOD::Proxy
+		&& bAttachedToBack
+		&& !SkeletalMeshComponent->IsSimulatingPhysics()
+		&& IsValid(ProxyMeshComponent->GetStaticMesh());
+}
+
+void AWeaponVisual::ApplyVisualLOD()
+{
+	const bool bFull = VisualLOD == EWeaponVisualLOD::Full;
+	const bool bProxy = ShouldUseProxyMesh();
+	SkeletalMeshComponent->SetCastShadow(bFull);
+	SkeletalMeshComponent->SetCastHiddenShadow(bFull);
+	SkeletalMeshComponent->SetVisibility(!bProxy);
+	ProxyMeshComponent->SetVisibility(bProxy);
+	if (!bFull)
+	{
+		StopTrail();
+	}
+}
+
+void AWeaponVisual::StartTrail()
+{
+	if (BatchedTrailId != INDEX_NONE)
+		return;
+
+	if (!TrailStartSocket.IsNone() && !TrailEndSocket.IsNone())
+	{
+		UTrailSubsystem* trails = UTrailSubsystem::Get(this);
+		if (trails && trails->IsAvailable())
+		{
+			// INDEX_NONE if the budget is taken by closer trails, no trail is drawn then
+			BatchedTrailId = trails->BeginTrail(SkeletalMeshComponent, TrailStartSocket, TrailEndSocket);
+			return;
+		}
+	}
+	ShowTrail();
+}
+
+void AWeaponVisual::StopTrail()
+{
+	if (BatchedTrailId != INDEX_NONE)
+	{
+		if (UTrailSubsystem* trails = UTrailSubsystem::Get(this))
+		{
+			trails->EndTrail(BatchedTrailId);
+		}
+		BatchedTrailId = INDEX_NONE;
+	}
+	HideTrail();
 }
 
 int32 AWeaponVisual::GetVisualIndex() const
 {
 	if (AActor* owner = GetOwner())
 	{
-		if (UAdvancedWeaponManager* manager = owner->FindComponentByClass<UAdvancedWeaponManager>())
+		if (UAdvancedWeaponManager* manager = UAdvancedWeaponManager::FindForActor(owner))
 		{
-			if (UAbstractWeapon* weapon = manager->WeaponByGuid(this->WeaponGuid))
+			if (UAbstractWeapon* weapon = manager->WeaponByHandle(this->WeaponHandle))
 			{
 				return weapon->GetVisualIndex(this);
 			}
@@ -119,19 +233,53 @@ int32 AWeaponVisual::GetVisualIndex() const
 	return INDEX_NONE;
 }
 
-void AWeaponVisual::SetGuidString(FString InGuid)
+void AWeaponVisual::SetWeaponHandle(FWeaponHandle InHandle)
 {
-	this->WeaponGuid = InGuid;
-	MARK_PROPERTY_DIRTY_FROM_NAME(AWeaponVisual, WeaponGuid, this);
+	this->WeaponHandle = InHandle;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AWeaponVisual, WeaponHandle, this);
+	FlushNetDormancy();
 }
 
 void AWeaponVisual::ActivatePhysics()
 {
 	SkeletalMeshComponent->SetCollisionEnabled(ECollisionEnabled::Type::PhysicsOnly);
 	SkeletalMeshComponent->SetSimulatePhysics(true);
+	// Dropped, proxy is for the back only
+	bAttachedToBack = false;
+	if (!IsHidden())
+	{
+		ApplyVisualLOD();
+	}
 	BP_PhysicsActivated();
 }
 
+void AWeaponVisual::ResetPhysics()
+{
+	const AWeaponVisual* defaultVisual = GetClass()->GetDefaultObject<AWeaponVisual>();
+	if (SkeletalMeshComponent->IsSimulatingPhysics())
+	{
+		// Simulation detaches the mesh from the root
+		SkeletalMeshComponent->SetSimulatePhysics(false);
+		SkeletalMeshComponent->AttachToComponent(Base, FAttachmentTransformRules::SnapToTargetIncludingScale);
+		SkeletalMeshComponent->SetRelativeTransform(defaultVisual->SkeletalMeshComponent->GetRelativeTransform());
+	}
+	SkeletalMeshComponent->SetCollisionEnabled(defaultVisual->SkeletalMeshComponent->GetCollisionEnabled());
+}
+
+void AWeaponVisual::OnAcquiredFromPool_Implementation()
+{
+	Show();
+}
+
+void AWeaponVisual::OnReleasedToPool_Implementation()
+{
+	Hide();
+	ResetPhysics();
+	SetWeaponHandle(FWeaponHandle());
+	VisualLOD = EWeaponVisualLOD::Full;
+	bAttachedToBack = false;
+}
+
 void AWeaponVisual::HideShadow()
 {
 	SkeletalMeshComponent->CastShadow = false;
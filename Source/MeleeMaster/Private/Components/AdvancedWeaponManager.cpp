@@ -6,6 +6,9 @@
 #include "MathUtil.h"
 #include "MeleeMaster.h"
 #include "GameFramework/PlayerState.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
 #include "Actors/WeaponVisual.h"
 #include "Data/MeleeWeaponAnimDataAsset.h"
 #include "Data/MeleeWeaponDataAsset.h"
@@ -18,19 +21,106 @@
 #include "Data/Interfaces/DamageManagerInterface.h"
 #include "Data/Interfaces/WeaponManagerOwner.h"
 #include "Engine/ActorChannel.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/GameStateBase.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Libs/MeleeCombatMath.h"
+#include "Libs/MeleeCounters.h"
+#include "Libs/MeleeStateMachine.h"
+#include "Libs/WeaponLib.h"
 #include "Net/UnrealNetwork.h"
 #include "Net/Core/PushModel/PushModel.h"
 #include "Objects/AbstractWeapon.h"
 #include "Objects/MeleeWeapon.h"
+#include "Subsystems/CombatRecorderSubsystem.h"
 #include "Subsystems/LoggerLib.h"
+#include "Subsystems/MeleeNetProfilerSubsystem.h"
+#include "Subsystems/MeleeRpcLimiterSubsystem.h"
+#include "Subsystems/ProjectileSubsystem.h"
+#include "Subsystems/VisualPoolSubsystem.h"
 
 #include "Math/UnrealMathUtility.h"
 #include "Objects/LongRangeWeapon.h"
 #include "Objects/WeaponModifierManager.h"
 
+static TAutoConsoleVariable<int32> CVarMeleeModifierSignificance(
+	TEXT("melee.Modifier.Significance"),
+	1,
+	TEXT("1 - throttle client modifier charging updates by owner significance, 0 - update every frame."));
+
+/**
+ * @brief Owner to manager registry (game thread), see FindForActor.
+ */
+static TMap<TObjectKey<AActor>, TWeakObjectPtr<UAdvancedWeaponManager>> GWeaponManagerRegistry;
+
+static bool IsChargingFightingStatus(EWeaponFightingStatus InStatus)
+{
+	return InStatus == EWeaponFightingStatus::PreAttack
+		|| InStatus == EWeaponFightingStatus::AttackCharging
+		|| InStatus == EWeaponFightingStatus::BlockCharging
+		|| InStatus == EWeaponFightingStatus::RangeCharging;
+}
+
+static void CollectMontagePaths(const UStruct* InStruct, const void* InContainer, TSet<FSoftObjectPath>& OutPaths);
+
+static void CollectMontagePathsFromValue(const FProperty* InProperty, const void* InValue,
+	TSet<FSoftObjectPath>& OutPaths)
+{
+	if (const FStructProperty* structProperty = CastField<FStructProperty>(InProperty))
+	{
+		if (structProperty->Struct == FAnimMontageSingleData::StaticStruct())
+		{
+			const FSoftObjectPath& path = static_cast<const FAnimMontageSingleData*>(InValue)->Value.
+				ToSoftObjectPath();
+			if (!path.IsNull())
+			{
+				OutPaths.Add(path);
+			}
+		}
+		else
+		{
+			CollectMontagePaths(structProperty->Struct, InValue, OutPaths);
+		}
+	}
+	else if (const FArrayProperty* arrayProperty = CastField<FArrayProperty>(InProperty))
+	{
+		FScriptArrayHelper helper(arrayProperty, InValue);
+		for (int32 i = 0; i < helper.Num(); ++i)
+		{
+			CollectMontagePathsFromValue(arrayProperty->Inner, helper.GetRawPtr(i), OutPaths);
+		}
+	}
+	else if (const FMapProperty* mapProperty = CastField<FMapProperty>(InProperty))
+	{
+		FScriptMapHelper helper(mapProperty, InValue);
+		for (int32 i = 0; i < helper.GetMaxIndex(); ++i)
+		{
+			if (helper.IsValidIndex(i))
+			{
+				CollectMontagePathsFromValue(mapProperty->ValueProp, helper.GetValuePtr(i), OutPaths);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Walks reflected properties and collects every FAnimMontageSingleData montage,
+ * so all phases and directions of any anim data asset subclass are found.
+ */
+static void CollectMontagePaths(const UStruct* InStruct, const void* InContainer, TSet<FSoftObjectPath>& OutPaths)
+{
+	for (TFieldIterator<FProperty> it(InStruct); it; ++it)
+	{
+		const FProperty* property = *it;
+		for (int32 i = 0; i < property->ArrayDim; ++i)
+		{
+			CollectMontagePathsFromValue(property, property->ContainerPtrToValuePtr<void>(InContainer, i), OutPaths);
+		}
+	}
+}
+
 
 FAnimPlayData::FAnimPlayData()
 	: bUseSection(false) {}
@@ -56,13 +146,19 @@ FAnimPlayData::FAnimPlayData(UAbstractWeapon* InWeapon,
 	this->SectionName = InSectionName;
 }
 
+FOnMeleeDamageDealt UAdvancedWeaponManager::OnDamageDealt;
+
 // Sets default values for this component's properties
 UAdvancedWeaponManager::UAdvancedWeaponManager()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
+	// Tick only matters while charging, see UpdateChargingTick
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 	SetIsReplicatedByDefault(true);
+	// Weapons are registered in AddNewWeapon, legacy ReplicateSubobjects is kept for owners without the list
+	bReplicateUsingRegisteredSubObjectList = true;
 	ManagingStatus = EWeaponManagingStatus::NoWeapon;
 	FightingStatus = EWeaponFightingStatus::Idle;
 	CurrentDirection = EWeaponDirection::Forward;
@@ -75,11 +171,16 @@ void UAdvancedWeaponManager::SetCurrentWeaponPtr(UAbstractWeapon* InNewWeapon)
 {
 	this->CurrentWeapon = InNewWeapon;
 	MARK_PROPERTY_DIRTY_FROM_NAME(UAdvancedWeaponManager, CurrentWeapon, this);
+	CacheWeaponMontages(InNewWeapon);
 
 	if (GetWorld()->GetNetMode() == NM_Standalone)
 	{
 		OnRep_CurrentWeapon();
 	}
+	else if (GetWorld()->GetNetMode() == NM_ListenServer)
+	{
+		UpdateModifierCharging();
+	}
 }
 
 void UAdvancedWeaponManager::SetHasBlocked(bool bInFlag)
@@ -129,6 +230,7 @@ void UAdvancedWeaponManager::SetAttackComboExpireTime(float InValue)
 
 void UAdvancedWeaponManager::SetManagingStatus(EWeaponManagingStatus InStatus)
 {
+	FMeleeStateMachine::NotifyTransition(this, this->ManagingStatus, InStatus);
 	this->ManagingStatus = InStatus;
 	MARK_PROPERTY_DIRTY_FROM_NAME(UAdvancedWeaponManager, ManagingStatus, this);
 	if (GetWorld()->GetNetMode() == NM_Standalone)
@@ -140,13 +242,82 @@ void UAdvancedWeaponManager::SetManagingStatus(EWeaponManagingStatus InStatus)
 void UAdvancedWeaponManager::SetFightingStatus(EWeaponFightingStatus InStatus)
 {
 	EWeaponFightingStatus previous = this->FightingStatus;
+	FMeleeStateMachine::NotifyTransition(this, previous, InStatus);
 	this->FightingStatus = InStatus;
 	MARK_PROPERTY_DIRTY_FROM_NAME(UAdvancedWeaponManager, FightingStatus, this);
+	UpdateOwnerNetUpdateFrequency(previous);
 
 	if (GetWorld()->GetNetMode() == NM_Standalone)
 	{
 		OnRep_FightingStatus(previous);
 	}
+	else
+	{
+		UpdateChargingTick(previous);
+	}
+}
+
+void UAdvancedWeaponManager::UpdateChargingTick(EWeaponFightingStatus InPrevious)
+{
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+		return;
+
+	const bool bCharging = IsChargingFightingStatus(GetFightingStatus());
+	if (bCharging && !IsComponentTickEnabled())
+	{
+		// Re-evaluate significance on the first tick
+		ModifierUpdateAccumulator = ModifierReducedInterval;
+		SetComponentTickEnabled(true);
+	}
+	else if (!bCharging && IsChargingFightingStatus(InPrevious))
+	{
+		SetComponentTickEnabled(false);
+		UpdateModifierCharging();
+	}
+}
+
+void UAdvancedWeaponManager::UpdateOwnerNetUpdateFrequency(EWeaponFightingStatus InPrevious)
+{
+	if (!bAdaptiveNetUpdateFrequency)
+		return;
+
+	AActor* owner = GetOwner();
+	if (!IsValid(owner) || !owner->HasAuthority() || GetWorld()->GetNetMode() == NM_Standalone)
+		return;
+
+	// Not captured yet (status is set before BeginPlay)
+	if (OwnerNetUpdateFrequency <= 0.0f)
+		return;
+
+	auto isCombatPhase = [](EWeaponFightingStatus InStatus) {
+		return InStatus == EWeaponFightingStatus::PreAttack
+			|| InStatus == EWeaponFightingStatus::AttackCharging
+			|| InStatus == EWeaponFightingStatus::BlockCharging
+			|| InStatus == EWeaponFightingStatus::RangeCharging
+			|| InStatus == EWeaponFightingStatus::Attacking;
+	};
+
+	const EWeaponFightingStatus status = GetFightingStatus();
+	if (isCombatPhase(status))
+	{
+		const float combatFrequency = FMath::Max(CombatNetUpdateFrequency, OwnerNetUpdateFrequency);
+		owner->SetNetUpdateFrequency(combatFrequency);
+		owner->SetMinNetUpdateFrequency(combatFrequency);
+		if (!isCombatPhase(InPrevious))
+		{
+			// Do not wait for the next (possibly throttled) update to send phase start
+			owner->ForceNetUpdate();
+		}
+	}
+	else
+	{
+		// Idle keeps the owner rate for movement, only the adaptive floor is lowered.
+		// Without net.UseAdaptiveNetUpdateFrequency the floor is unused and idle replicates at the owner rate
+		owner->SetNetUpdateFrequency(OwnerNetUpdateFrequency);
+		owner->SetMinNetUpdateFrequency(status == EWeaponFightingStatus::Idle
+			? FMath::Min(IdleMinNetUpdateFrequency, OwnerNetUpdateFrequency)
+			: OwnerMinNetUpdateFrequency);
+	}
 }
 
 void UAdvancedWeaponManager::SetDirection(EWeaponDirection InDirection)
@@ -160,9 +331,9 @@ void UAdvancedWeaponManager::SetDirection(EWeaponDirection InDirection)
 	}
 }
 
-void UAdvancedWeaponManager::SetSavedGuid(FString Value)
+void UAdvancedWeaponManager::SetSavedHandle(FWeaponHandle Value)
 {
-	this->SavedGuid = Value;
+	this->SavedHandle = Value;
 }
 
 void UAdvancedWeaponManager::SetChargingCurve(UCurveFloat* InCurve)
@@ -204,27 +375,225 @@ void UAdvancedWeaponManager::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (AActor* owner = GetOwner())
+	{
+		OwnerNetUpdateFrequency = owner->GetNetUpdateFrequency();
+		OwnerMinNetUpdateFrequency = owner->GetMinNetUpdateFrequency();
+
+		if (owner->GetLocalRole() == ROLE_SimulatedProxy && SimulatedProxyTickInterval > 0.0f)
+		{
+			SetComponentTickInterval(SimulatedProxyTickInterval);
+		}
+	}
+
+	// Lag compensated arrow hits (server)
+	ACharacter* character = GetOwner<ACharacter>();
+	if (IsValid(character) && character->HasAuthority() && GetWorld()->GetNetMode() != NM_Standalone)
+	{
+		if (UProjectileSubsystem* projectiles = UProjectileSubsystem::Get(this))
+		{
+			UCapsuleComponent* capsule = character->GetCapsuleComponent();
+			projectiles->RegisterRewindTarget(character, capsule, capsule->GetScaledCapsuleRadius(),
+				capsule->GetScaledCapsuleHalfHeight());
+		}
+	}
+
 	if (GetWorld()->GetNetMode() == NM_DedicatedServer || GetWorld()->GetNetMode() == NM_Standalone)
 	{
 		SetFightingStatus(EWeaponFightingStatus::Idle);
 		SetManagingStatus(EWeaponManagingStatus::NoWeapon);
 	}
+
+	if (bVisualLOD && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		// Random first delay spreads fighters over frames
+		GetWorld()->GetTimerManager().SetTimer(VisualLODTimerHandle, this, &UAdvancedWeaponManager::UpdateVisualLOD,
+			VisualLODInterval, true, FMath::FRandRange(0.0f, VisualLODInterval));
+	}
+}
+
+void UAdvancedWeaponManager::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	SIZE_T localVisualsSize = LocalVisualMap.GetAllocatedSize();
+	for (const TPair<TObjectKey<UAbstractWeapon>, TArray<TWeakObjectPtr<AWeaponVisual>>>& pair : LocalVisualMap)
+	{
+		localVisualsSize += pair.Value.GetAllocatedSize();
+	}
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(WeaponList.GetAllocatedSize()
+		+ WeaponHandleMap.GetAllocatedSize()
+		+ MontageCache.GetAllocatedSize()
+		+ MontagePathsByData.GetAllocatedSize()
+		+ DefaultWeapons.GetAllocatedSize()
+		+ localVisualsSize);
+}
+
+bool UAdvancedWeaponManager::CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms,
+	FFrame* Stack)
+{
+	FMeleeCounters::AddRpc();
+	UMeleeNetProfilerSubsystem* profiler = UMeleeNetProfilerSubsystem::IsEnabled()
+		? UMeleeNetProfilerSubsystem::Get(this)
+		: nullptr;
+	if (!profiler)
+		return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+
+	profiler->BeginRpc(this, Function);
+	const bool bProcessed = Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+	profiler->EndRpc(Function, Parameters);
+	return bProcessed;
+}
+
+void UAdvancedWeaponManager::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	if (UMeleeNetProfilerSubsystem::IsEnabled())
+	{
+		if (UMeleeNetProfilerSubsystem* profiler = UMeleeNetProfilerSubsystem::Get(this))
+		{
+			profiler->SampleManagerProperties(this);
+		}
+	}
+}
+
+void UAdvancedWeaponManager::OnRegister()
+{
+	Super::OnRegister();
+
+	if (AActor* owner = GetOwner())
+	{
+		GWeaponManagerRegistry.Add(owner, this);
+	}
+}
+
+void UAdvancedWeaponManager::OnUnregister()
+{
+	if (AActor* owner = GetOwner())
+	{
+		const TWeakObjectPtr<UAdvancedWeaponManager>* registered = GWeaponManagerRegistry.Find(owner);
+		if (registered && (!registered->IsValid() || registered->Get() == this))
+		{
+			GWeaponManagerRegistry.Remove(owner);
+		}
+	}
+	Super::OnUnregister();
+}
+
+UAdvancedWeaponManager* UAdvancedWeaponManager::FindForActor(const AActor* InActor)
+{
+	if (!InActor)
+		return nullptr;
+
+	if (const TWeakObjectPtr<UAdvancedWeaponManager>* registered = GWeaponManagerRegistry.Find(InActor))
+	{
+		return registered->Get();
+	}
+	return nullptr;
+}
+
+void UAdvancedWeaponManager::ForEachRegistered(TFunctionRef<void(UAdvancedWeaponManager*)> InFunction)
+{
+	for (const TPair<TObjectKey<AActor>, TWeakObjectPtr<UAdvancedWeaponManager>>& pair : GWeaponManagerRegistry)
+	{
+		if (UAdvancedWeaponManager* manager = pair.Value.Get())
+		{
+			InFunction(manager);
+		}
+	}
+}
+
+int32 UAdvancedWeaponManager::GetActiveTimerNum(bool bInCombatOnly) const
+{
+	const UWorld* world = GetWorld();
+	if (!world)
+		return 0;
+
+	const FTimerManager& timerManager = world->GetTimerManager();
+	int32 num = 0;
+	for (const FTimerHandle* handle : {&EquippingTimerHandle, &FightTimerHandle, &HittingTimerHandle})
+	{
+		num += timerManager.TimerExists(*handle) ? 1 : 0;
+	}
+	if (!bInCombatOnly)
+	{
+		num += timerManager.TimerExists(VisualLODTimerHandle) ? 1 : 0;
+		// Shield durability loops while the shield is held or regenerates
+		for (const UAbstractWeapon* weapon : WeaponList)
+		{
+			if (const UMeleeWeapon* meleeWeapon = Cast<UMeleeWeapon>(weapon))
+			{
+				num += timerManager.TimerExists(meleeWeapon->GetShieldDurabilityTimerHandle()) ? 1 : 0;
+			}
+		}
+	}
+	return num;
+}
+
+UAdvancedWeaponManager* UAdvancedWeaponManager::FindOrAddForActor(AActor* InActor)
+{
+	if (!IsValid(InActor))
+		return nullptr;
+
+	if (UAdvancedWeaponManager* manager = FindForActor(InActor))
+		return manager;
+
+	UAdvancedWeaponManager* manager = NewObject<UAdvancedWeaponManager>(InActor, TEXT("WeaponManager"));
+	manager->RegisterComponent();
+	return manager;
 }
 
 void UAdvancedWeaponManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	GetWorld()->GetTimerManager().ClearTimer(EquippingTimerHandle);
+	GetWorld()->GetTimerManager().ClearTimer(VisualLODTimerHandle);
+
+	if (UProjectileSubsystem* projectiles = UProjectileSubsystem::Get(this))
+	{
+		projectiles->UnregisterRewindTarget(GetOwner());
+	}
+
+	// Local visuals are not destroyed by the server
+	TArray<TObjectKey<UAbstractWeapon>> localKeys;
+	LocalVisualMap.GetKeys(localKeys);
+	for (const TObjectKey<UAbstractWeapon>& key : localKeys)
+	{
+		ReleaseLocalVisuals(key);
+	}
 	Super::EndPlay(EndPlayReason);
 }
 
-void UAdvancedWeaponManager::OnRep_CurrentWeapon() {}
+void UAdvancedWeaponManager::OnRep_CurrentWeapon()
+{
+	CacheWeaponMontages(CurrentWeapon);
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		// Tick is off outside of charging, new weapon gets its idle state here
+		UpdateModifierCharging();
+	}
+}
 
-void UAdvancedWeaponManager::OnRep_WeaponList() {}
+void UAdvancedWeaponManager::OnRep_WeaponList()
+{
+	bWeaponHandleMapDirty = true;
+	for (UAbstractWeapon* weapon : WeaponList)
+	{
+		if (IsValid(weapon))
+		{
+			weapon->SetWeaponManager(this);
+		}
+	}
+	UpdateMontageCache();
+	SyncLocalVisuals();
+}
 
 void UAdvancedWeaponManager::OnRep_ManagingStatus() {}
 
 void UAdvancedWeaponManager::OnRep_FightingStatus(EWeaponFightingStatus PreviousState)
 {
+	UpdateChargingTick(PreviousState);
 	OnClientFightingStatusChanged.Broadcast(PreviousState, FightingStatus);
 }
 
@@ -266,30 +635,160 @@ void UAdvancedWeaponManager::TickComponent(float DeltaTime, ELevelTick TickType,
 
 	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
 	{
-		UpdateModifierCharging();
+		TickModifierCharging(DeltaTime);
 	}
 }
 
-bool UAdvancedWeaponManager::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+void UAdvancedWeaponManager::TickModifierCharging(float DeltaTime)
 {
-	bool sup = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+	if (!bModifierSignificance || CVarMeleeModifierSignificance.GetValueOnGameThread() <= 0)
+	{
+		ModifierSignificance = EWeaponModifierSignificance::Full;
+		UpdateModifierCharging();
+		return;
+	}
 
-	if (IsValid(CurrentWeapon))
+	ModifierUpdateAccumulator += DeltaTime;
+	const bool bDue = ModifierUpdateAccumulator >= ModifierReducedInterval;
+	if (bDue)
 	{
-		sup |= Channel->ReplicateSubobject(CurrentWeapon, *Bunch, *RepFlags);
-		sup |= CurrentWeapon->ReplicateSubobjects(Channel, Bunch, RepFlags);
+		ModifierUpdateAccumulator = 0.0f;
+		ModifierSignificance = EvaluateModifierSignificance();
 	}
-	if (WeaponList.Num() > 0)
+
+	switch (ModifierSignificance)
 	{
-		for (UAbstractWeapon* el : WeaponList)
+	case EWeaponModifierSignificance::Full:
+		UpdateModifierCharging();
+		break;
+	case EWeaponModifierSignificance::Reduced:
+		// Curve is evaluated from server time, skipped frames do not change the result
+		if (bDue || !IsChargingFightingStatus(GetFightingStatus()))
+		{
+			UpdateModifierCharging();
+		}
+		break;
+	case EWeaponModifierSignificance::Insignificant:
+		// Still deliver idle transition, so the modifier does not stay charged
+		if (!IsChargingFightingStatus(GetFightingStatus()))
 		{
-			if (IsValid(el))
+			UpdateModifierCharging();
+		}
+		break;
+	}
+}
+
+EWeaponModifierSignificance UAdvancedWeaponManager::EvaluateModifierSignificance() const
+{
+	const AActor* owner = GetOwner();
+	if (!IsValid(owner))
+		return EWeaponModifierSignificance::Insignificant;
+
+	const APawn* pawn = Cast<APawn>(owner);
+	if (IsValid(pawn) && pawn->IsLocallyControlled())
+		return EWeaponModifierSignificance::Full;
+
+	if (!owner->WasRecentlyRendered(0.2f))
+		return EWeaponModifierSignificance::Insignificant;
+
+	FVector viewLocation;
+	if (!GetLocalViewLocation(viewLocation))
+		return EWeaponModifierSignificance::Reduced;
+
+	const float distSq = FVector::DistSquared(viewLocation, owner->GetActorLocation());
+	return distSq <= FMath::Square(ModifierCullDistance)
+		? EWeaponModifierSignificance::Reduced
+		: EWeaponModifierSignificance::Insignificant;
+}
+
+EWeaponVisualLOD UAdvancedWeaponManager::EvaluateVisualLOD() const
+{
+	const AActor* owner = GetOwner();
+	if (!IsValid(owner))
+		return EWeaponVisualLOD::Full;
+
+	// Local player keeps first person setup (see AttachBack, HideShadow)
+	const APawn* pawn = Cast<APawn>(owner);
+	if (IsValid(pawn) && pawn->IsLocallyControlled())
+		return EWeaponVisualLOD::Full;
+
+	FVector viewLocation;
+	if (!GetLocalViewLocation(viewLocation))
+		return EWeaponVisualLOD::Full;
+
+	const float distSq = FVector::DistSquared(viewLocation, owner->GetActorLocation());
+	if (distSq <= FMath::Square(VisualShadowDistance))
+		return EWeaponVisualLOD::Full;
+	if (distSq <= FMath::Square(VisualProxyDistance))
+		return EWeaponVisualLOD::Reduced;
+	return EWeaponVisualLOD::Proxy;
+}
+
+void UAdvancedWeaponManager::UpdateVisualLOD()
+{
+	const EWeaponVisualLOD lod = EvaluateVisualLOD();
+	TArray<AWeaponVisual*> visuals;
+	for (UAbstractWeapon* weapon : WeaponList)
+	{
+		if (!IsValid(weapon))
+			continue;
+
+		weapon->GetVisual(visuals);
+		for (AWeaponVisual* visual : visuals)
+		{
+			if (IsValid(visual))
 			{
-				sup |= Channel->ReplicateSubobject(el, *Bunch, *RepFlags);
-				sup |= el->ReplicateSubobjects(Channel, Bunch, RepFlags);
+				visual->SetVisualLOD(lod);
 			}
 		}
 	}
+}
+
+bool UAdvancedWeaponManager::GetLocalViewLocation(FVector& OutLocation) const
+{
+	const APlayerController* pc = GetWorld()->GetFirstPlayerController();
+	if (!IsValid(pc))
+		return false;
+
+	FRotator viewRotation;
+	pc->GetPlayerViewPoint(OutLocation, viewRotation);
+	return true;
+}
+
+bool UAdvancedWeaponManager::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+{
+	MELEE_SCOPE_CYCLE(ReplicateSubobjects);
+	bool sup = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+
+	UMeleeNetProfilerSubsystem* profiler = UMeleeNetProfilerSubsystem::IsEnabled()
+		? UMeleeNetProfilerSubsystem::Get(this)
+		: nullptr;
+
+	// Engine changelists decide what is sent, a clean weapon costs only the compare
+	auto replicateWeapon = [&](UAbstractWeapon* InWeapon) {
+		const int64 bunchBits = Bunch->GetNumBits();
+		sup |= Channel->ReplicateSubobject(InWeapon, *Bunch, *RepFlags);
+		sup |= InWeapon->ReplicateSubobjects(Channel, Bunch, RepFlags);
+		if (profiler)
+		{
+			profiler->RecordProperty(InWeapon->GetClass()->GetFName(), Channel->Connection,
+				Bunch->GetNumBits() - bunchBits);
+		}
+		INC_DWORD_STAT(STAT_MeleeSubobjectsReplicated);
+	};
+
+	// Current weapon is one of the list entries, it is visited once
+	for (UAbstractWeapon* el : WeaponList)
+	{
+		if (IsValid(el))
+		{
+			replicateWeapon(el);
+		}
+	}
+	if (IsValid(CurrentWeapon) && !WeaponList.Contains(CurrentWeapon))
+	{
+		replicateWeapon(CurrentWeapon);
+	}
 	return sup;
 }
 
@@ -371,6 +870,7 @@ bool UAdvancedWeaponManager::IsShieldEquipped() const
 
 float UAdvancedWeaponManager::EvaluateCurrentCurve() const
 {
+	MELEE_SCOPE_CYCLE(EvaluateCurrentCurve);
 	EWeaponFightingStatus fightStatus = GetFightingStatus();
 
 	if (fightStatus == EWeaponFightingStatus::BlockCharging
@@ -403,17 +903,8 @@ float UAdvancedWeaponManager::EvaluateCurrentCurve() const
 		const float startTime = GetChargingStartTime();
 		if (currentServerTime <= finishTime)
 		{
-			// Duration of full curve
-			const float duration = FMath::Abs(finishTime - startTime);
-
-			// Time to end curve
-			const float secondsLeft = finishTime - currentServerTime;
-
-			// Time from start
-			const float curveActualTime = duration - secondsLeft;
-
-			// Eval
-			return GetChargingCurve()->GetFloatValue(curveActualTime);
+			return GetChargingCurve()->GetFloatValue(
+				FMeleeCombatMath::GetChargingCurveTime(startTime, finishTime, currentServerTime));
 		}
 		// Eval last curve item
 		return GetChargingCurve()->GetFloatValue(GetChargingCurve()->FloatCurve.GetLastKey().Time);
@@ -451,7 +942,7 @@ float UAdvancedWeaponManager::EvaluateAttackComboDamage(float InActualDamage) co
 	{
 		return InActualDamage;
 	}
-	return InActualDamage + CurrentAttackComboSum * InActualDamage;
+	return FMeleeCombatMath::EvaluateComboDamage(InActualDamage, CurrentAttackComboSum);
 }
 
 int32 UAdvancedWeaponManager::AddNewWeapon(UWeaponDataAsset* InWeaponAsset)
@@ -462,13 +953,18 @@ int32 UAdvancedWeaponManager::AddNewWeapon(UWeaponDataAsset* InWeaponAsset)
 	if (!InWeaponAsset->IsValidToCreate())
 		return INDEX_NONE;
 
+	LLM_SCOPE_BYTAG(MeleeMaster);
 	UAbstractWeapon* weaponInstance = NewObject<UAbstractWeapon>(GetOwner(), InWeaponAsset->WeaponClass, NAME_None,
 		RF_Transient);
 	weaponInstance->SetData(InWeaponAsset);
 	weaponInstance->SetGuidString(weaponInstance->MakeRandomGuidString());
+	weaponInstance->SetHandle(MakeWeaponHandle());
 	weaponInstance->SetWeaponManager(this);
 
 	const int32 index = WeaponList.Add(weaponInstance);
+	bWeaponHandleMapDirty = true;
+	AddReplicatedSubObject(weaponInstance);
+	CacheWeaponMontages(weaponInstance);
 	CreateVisuals(weaponInstance);
 	MARK_PROPERTY_DIRTY_FROM_NAME(UAdvancedWeaponManager, WeaponList, this);
 
@@ -477,12 +973,24 @@ int32 UAdvancedWeaponManager::AddNewWeapon(UWeaponDataAsset* InWeaponAsset)
 
 void UAdvancedWeaponManager::CreateVisuals(UAbstractWeapon* InAbstractWeapon)
 {
+	MELEE_SCOPE_CYCLE(CreateVisuals);
+	LLM_SCOPE_BYTAG(MeleeMaster);
 	if (!IsValid(InAbstractWeapon))
 		return;
 
 	if (!InAbstractWeapon->IsValidData())
 		return;
 
+	if (bClientSideVisuals)
+	{
+		// Dedicated server keeps no visual actors, clients spawn them on OnRep_WeaponList
+		if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+		{
+			CreateLocalVisuals(InAbstractWeapon);
+		}
+		return;
+	}
+
 	const UWeaponDataAsset* data = InAbstractWeapon->GetData();
 	if (data->Visuals.Num() <= 0)
 	{
@@ -492,7 +1000,7 @@ void UAdvancedWeaponManager::CreateVisuals(UAbstractWeapon* InAbstractWeapon)
 	AActor* owner = GetOwner();
 	const FVector ownerLoc = owner->GetActorLocation();
 	actors.Reserve(data->Visuals.Num());
-	const FString weaponGuid = InAbstractWeapon->GetGUIDString();
+	const FWeaponHandle weaponHandle = InAbstractWeapon->GetHandle();
 	for (TSubclassOf<AWeaponVisual> visualClass : data->Visuals)
 	{
 		FVector loc = ownerLoc;
@@ -504,30 +1012,188 @@ void UAdvancedWeaponManager::CreateVisuals(UAbstractWeapon* InAbstractWeapon)
 		spawnParameters.ObjectFlags = RF_Transient;
 		AWeaponVisual* visualActor = GetWorld()->SpawnActor<AWeaponVisual>(visualClass, loc, rot, spawnParameters);
 
-		if (GetOwner()->GetLocalRole() == ROLE_AutonomousProxy)
+		if (GetOwner()->GetLocalRole() == ROLE_AutonomousProxy)
+		{
+			visualActor->HideShadow();
+		}
+		if (IsValid(visualActor))
+		{
+			visualActor->SetWeaponHandle(weaponHandle);
+			actors.Add(visualActor);
+		}
+	}
+	InAbstractWeapon->SetVisual(actors);
+
+	if (GetWorld()->GetNetMode() != NM_Standalone)
+	{
+		// Attach to owner (on server)
+		for (int32 i = 0; i < actors.Num(); ++i)
+		{
+			actors[i]->AttachToActor(GetOwner(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+			actors[i]->FlushNetDormancy();
+		}
+	}
+}
+
+void UAdvancedWeaponManager::CreateLocalVisuals(UAbstractWeapon* InAbstractWeapon)
+{
+	if (!IsValid(InAbstractWeapon))
+		return;
+
+	if (!InAbstractWeapon->IsValidData())
+		return;
+
+	const TObjectKey<UAbstractWeapon> weaponKey(InAbstractWeapon);
+	if (LocalVisualMap.Contains(weaponKey))
+		return;
+
+	const UWeaponDataAsset* data = InAbstractWeapon->GetData();
+	TArray<TWeakObjectPtr<AWeaponVisual>>& localVisuals = LocalVisualMap.Add(weaponKey);
+	if (data->Visuals.Num() <= 0)
+	{
+		return;
+	}
+
+	TArray<AWeaponVisual*> actors;
+	AActor* owner = GetOwner();
+	const FTransform spawnTransform(owner->GetActorLocation());
+	UVisualPoolSubsystem* pool = UVisualPoolSubsystem::Get(this);
+	actors.Reserve(data->Visuals.Num());
+	localVisuals.Reserve(data->Visuals.Num());
+	const FWeaponHandle weaponHandle = InAbstractWeapon->GetHandle();
+	for (TSubclassOf<AWeaponVisual> visualClass : data->Visuals)
+	{
+		AWeaponVisual* visualActor;
+		if (pool)
+		{
+			// Pooled actors are not replicated and have already begun play
+			visualActor = pool->Acquire<AWeaponVisual>(visualClass, spawnTransform, owner);
+		}
+		else
+		{
+			visualActor = GetWorld()->SpawnActorDeferred<AWeaponVisual>(visualClass, spawnTransform,
+				owner, Cast<APawn>(owner), ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (IsValid(visualActor))
+			{
+				// Cosmetic only, never opens an actor channel
+				visualActor->SetReplicates(false);
+			}
+		}
+		if (!IsValid(visualActor))
+			continue;
+
+		visualActor->SetWeaponHandle(weaponHandle);
+		if (GetOwner()->GetLocalRole() == ROLE_AutonomousProxy)
+		{
+			visualActor->HideShadow();
+		}
+		actors.Add(visualActor);
+		localVisuals.Add(visualActor);
+	}
+	// Weapon must know its visuals before they are attached
+	InAbstractWeapon->SetLocalVisual(actors);
+
+	for (AWeaponVisual* visualActor : actors)
+	{
+		if (visualActor->IsActorInitialized())
+		{
+			visualActor->AttachToWeaponManager();
+		}
+		else
+		{
+			// Attached on BeginPlay
+			visualActor->FinishSpawning(spawnTransform);
+		}
+	}
+}
+
+void UAdvancedWeaponManager::SyncLocalVisuals()
+{
+	if (!bClientSideVisuals)
+		return;
+
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+		return;
+
+	TSet<TObjectKey<UAbstractWeapon>> aliveWeapons;
+	aliveWeapons.Reserve(WeaponList.Num());
+	for (UAbstractWeapon* weapon : WeaponList)
+	{
+		if (!IsValid(weapon))
+			continue;
+
+		aliveWeapons.Add(weapon);
+		// Skipped if data is not resolved yet, see NotifyWeaponDataReplicated
+		CreateLocalVisuals(weapon);
+	}
+
+	TArray<TObjectKey<UAbstractWeapon>> removedWeapons;
+	for (const TPair<TObjectKey<UAbstractWeapon>, TArray<TWeakObjectPtr<AWeaponVisual>>>& pair : LocalVisualMap)
+	{
+		if (!aliveWeapons.Contains(pair.Key))
+		{
+			removedWeapons.Add(pair.Key);
+		}
+	}
+	for (const TObjectKey<UAbstractWeapon>& key : removedWeapons)
+	{
+		ReleaseLocalVisuals(key);
+	}
+}
+
+void UAdvancedWeaponManager::ReleaseLocalVisuals(const TObjectKey<UAbstractWeapon>& InWeaponKey)
+{
+	TArray<TWeakObjectPtr<AWeaponVisual>> localVisuals;
+	if (!LocalVisualMap.RemoveAndCopyValue(InWeaponKey, localVisuals))
+		return;
+
+	UVisualPoolSubsystem* pool = UVisualPoolSubsystem::Get(this);
+	for (const TWeakObjectPtr<AWeaponVisual>& visual : localVisuals)
+	{
+		if (!visual.IsValid())
+			continue;
+
+		if (pool)
 		{
-			visualActor->HideShadow();
+			pool->Release(visual.Get());
 		}
-		if (IsValid(visualActor))
+		else
 		{
-			visualActor->SetGuidString(weaponGuid);
-			actors.Add(visualActor);
+			visual->Destroy();
 		}
 	}
-	InAbstractWeapon->SetVisual(actors);
-
-	if (GetWorld()->GetNetMode() != NM_Standalone)
+	if (UAbstractWeapon* weapon = InWeaponKey.ResolveObjectPtr())
 	{
-		// Attach to owner (on server)
-		for (int32 i = 0; i < actors.Num(); ++i)
-		{
-			actors[i]->AttachToActor(GetOwner(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
-		}
+		weapon->ClearVisual();
 	}
 }
 
+void UAdvancedWeaponManager::NotifyWeaponDataReplicated(UAbstractWeapon* InWeapon)
+{
+	// Wait for OnRep_WeaponList, weapon may not be in the list yet
+	if (!WeaponList.Contains(InWeapon))
+		return;
+
+	// Data was not there when the list arrived
+	CacheWeaponMontages(InWeapon);
+
+	if (!bClientSideVisuals)
+		return;
+
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+		return;
+
+	CreateLocalVisuals(InWeapon);
+}
+
+void UAdvancedWeaponManager::NotifyWeaponHandleReplicated(UAbstractWeapon* InWeapon)
+{
+	bWeaponHandleMapDirty = true;
+}
+
 void UAdvancedWeaponManager::ProcessHits(UAbstractWeapon* InWeapon, const TArray<FHitResult>& InHits)
 {
+	MELEE_SCOPE_CYCLE(ProcessHits);
 	if (InHits.Num() <= 0)
 		return;
 
@@ -546,6 +1212,10 @@ void UAdvancedWeaponManager::ProcessHits(UAbstractWeapon* InWeapon, const TArray
 	}
 	TMap<AActor*, FHitResult> hitMap;
 
+	const UMeleeWeapon* swingWeapon = Cast<UMeleeWeapon>(InWeapon);
+	const UMeleeWeaponDataAsset* swingData = swingWeapon ? swingWeapon->GetMeleeData() : nullptr;
+	const bool bDamageOncePerSwing = swingData && swingData->bDamageOncePerSwing;
+
 	// Make hitmap
 
 	bool bWasWallHit = false;
@@ -559,9 +1229,15 @@ void UAdvancedWeaponManager::ProcessHits(UAbstractWeapon* InWeapon, const TArray
 				{
 					if (hitActor->Implements<UDamageableEntity>())
 					{
-						if (IDamageableEntity::Execute_IsAlive(hitActor))
+						if (IDamageableEntity::Execute_IsAlive(hitActor)
+							&& !(bDamageOncePerSwing && SwingHitActors.Contains(hitActor)))
 						{
 							hitMap.Add(hitActor, hit);
+							if (bDamageOncePerSwing)
+							{
+								// Next hit path elements of the same swing skip the victim
+								SwingHitActors.Add(hitActor);
+							}
 						}
 					}
 					else
@@ -573,6 +1249,7 @@ void UAdvancedWeaponManager::ProcessHits(UAbstractWeapon* InWeapon, const TArray
 		}
 	}
 
+	FMeleeCounters::AddTraceTargets(hitMap.Num());
 	UWeaponDataAsset* data = InWeapon->GetData();
 
 	TArray<FMeleeHitDebugData> debugArr;
@@ -620,6 +1297,8 @@ void UAdvancedWeaponManager::ProcessHits(UAbstractWeapon* InWeapon, const TArray
 				/* EDamageReturn& OutDamageReturn */ dmgReturn,
 				/* float& OutDamage */ totalDmg);
 
+			OnDamageDealt.Broadcast(this, el.Key, dmgReturn, totalDmg);
+
 			if (dmgReturn != EDamageReturn::Failed)
 			{
 				// Update melee combo
@@ -668,6 +1347,7 @@ void UAdvancedWeaponManager::ProcessHits(UAbstractWeapon* InWeapon, const TArray
 
 void UAdvancedWeaponManager::Multi_DebugHit_Implementation(const TArray<FMeleeHitDebugData>& InData)
 {
+	MELEE_SCOPE_RPC(Multi_DebugHit);
 	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
 		return;
 	if (bDebugMeleeHits)
@@ -827,6 +1507,7 @@ void UAdvancedWeaponManager::EquipFinished()
 
 void UAdvancedWeaponManager::MeleeHitProcedure()
 {
+	MELEE_SCOPE_CYCLE(HitProcedure);
 	UAbstractWeapon* weapon = GetCurrentWeapon();
 	if (!IsValid(weapon))
 		return;
@@ -864,6 +1545,7 @@ void UAdvancedWeaponManager::MeleeHitProcedure()
 			CurrentDirection);
 		if (!attackData.HitPath)
 		{
+			FMeleeCounters::AddTraceSkipped();
 			TRACEERROR(LogWeapon, "%s hit path of %s is null",
 				*UEnum::GetValueAsString(CurrentDirection),
 				*meleeWeaponData->GetFName().ToString());
@@ -872,6 +1554,7 @@ void UAdvancedWeaponManager::MeleeHitProcedure()
 		UWeaponHitPathAsset* hitPath = attackData.HitPath;
 		if (!hitPath->Data.Elements.IsValidIndex(HitNum))
 		{
+			FMeleeCounters::AddTraceSkipped();
 			TRACEWARN(LogWeapon, "Invalid %d index of %s %s",
 				HitNum,
 				*UEnum::GetValueAsString(CurrentDirection),
@@ -886,24 +1569,13 @@ void UAdvancedWeaponManager::MeleeHitProcedure()
 		actorsToIgnore.Append(visual);
 
 		// Calculate offsets
-		FRotator controlRot = FRotator::ZeroRotator;
-		if (IsValid(pawnOwner))
-		{
-			controlRot = pawnOwner->GetControlRotation();
-		}
-		controlRot.Pitch = 0.0f;
-		controlRot.Add(0.0f, -90.0f, 0.0f);
-		FVector ownerLoc = pawnOwner->GetActorLocation();
-		ownerLoc.Z += hitPath->ZOffset;
-
-		const FVector localStart = hitPath->Data.Elements[HitNum].Start;
-		const FVector startRotated = controlRot.RotateVector(localStart);
-		const FVector localEnd = hitPath->Data.Elements[HitNum].End;
-		const FVector endRotated = controlRot.RotateVector(localEnd);
-
-		const FVector start = startRotated + ownerLoc;
-		const FVector end = endRotated + ownerLoc;
+		FVector start;
+		FVector end;
+		FRotator controlRot;
+		FMeleeCombatMath::TransformHitSegment(pawnOwner->GetControlRotation(), pawnOwner->GetActorLocation(),
+			hitPath->ZOffset, hitPath->Data.Elements[HitNum], start, end, controlRot);
 		TArray<FHitResult> hits;
+		FMeleeCounters::AddTrace();
 		UKismetSystemLibrary::BoxTraceMulti(GetWorld(), start, end,
 			FVector(hitPath->Radius), controlRot,
 			hitPath->TraceQuery,
@@ -930,6 +1602,9 @@ void UAdvancedWeaponManager::MeleeHitProcedure()
 
 void UAdvancedWeaponManager::Server_Attack_Implementation()
 {
+	MELEE_SCOPE_SERVER_RPC(Server_Attack);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::Attack)))
+		return;
 	if (!CanAttack())
 		return;
 
@@ -1001,6 +1676,7 @@ void UAdvancedWeaponManager::AttackMelee_Internal(UMeleeWeapon* InMeleeWeapon)
 
 	// Looped line-trace method
 	HitNum = 0;
+	SwingHitActors.Reset();
 
 	const float frequency = attackData.HittingTime / FMath::Clamp(hitPath->Data.Elements.Num(), 1,
 		TNumericLimits<int32>::Max() - 1);
@@ -1154,6 +1830,9 @@ void UAdvancedWeaponManager::StartParry(EWeaponDirection InDirection)
 
 void UAdvancedWeaponManager::Server_Block_Implementation(EWeaponDirection InDirection)
 {
+	MELEE_SCOPE_SERVER_RPC(Server_Block);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::Block, INDEX_NONE, InDirection)))
+		return;
 	if (!CanBlock())
 		return;
 
@@ -1239,6 +1918,9 @@ void UAdvancedWeaponManager::Server_Block_Implementation(EWeaponDirection InDire
 
 void UAdvancedWeaponManager::Server_CancelCharge_Implementation()
 {
+	MELEE_SCOPE_SERVER_RPC(Server_CancelCharge);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::CancelCharge)))
+		return;
 	if (!CanCancelCharge())
 		return;
 
@@ -1262,6 +1944,9 @@ void UAdvancedWeaponManager::Server_CancelCharge_Implementation()
 
 void UAdvancedWeaponManager::Server_UnBlock_Implementation()
 {
+	MELEE_SCOPE_SERVER_RPC(Server_UnBlock);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::UnBlock)))
+		return;
 	if (!CanUnBlock())
 		return;
 
@@ -1300,6 +1985,9 @@ void UAdvancedWeaponManager::Server_UnBlock_Implementation()
 
 void UAdvancedWeaponManager::Server_Change_Implementation(int32 InIndex)
 {
+	MELEE_SCOPE_SERVER_RPC(Server_Change);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::Change, InIndex)))
+		return;
 	if (!CanChange(InIndex))
 		return;
 
@@ -1312,6 +2000,9 @@ void UAdvancedWeaponManager::Server_Change_Implementation(int32 InIndex)
 
 void UAdvancedWeaponManager::Server_GetShield_Implementation()
 {
+	MELEE_SCOPE_SERVER_RPC(Server_GetShield);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::GetShield)))
+		return;
 	if (!CanGetShield())
 		return;
 
@@ -1404,6 +2095,9 @@ bool UAdvancedWeaponManager::HasEquippedWeapon() const
 
 void UAdvancedWeaponManager::Server_RemoveShield_Implementation()
 {
+	MELEE_SCOPE_SERVER_RPC(Server_RemoveShield);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::RemoveShield)))
+		return;
 	if (!CanRemoveShield())
 		return;
 
@@ -1465,9 +2159,9 @@ void UAdvancedWeaponManager::EquipNextWeapon_Internal()
 void UAdvancedWeaponManager::DeEquipFinished()
 {
 	UAbstractWeapon* curWeapon = GetCurrentWeapon();
-	FString guid = curWeapon->GetGUIDString();
-	SetSavedGuid(guid);
-	Multi_AttachBack(guid);
+	const FWeaponHandle handle = curWeapon->GetHandle();
+	SetSavedHandle(handle);
+	Multi_AttachBack(handle);
 	SetCurrentWeaponPtr(nullptr);
 	SetManagingStatus(EWeaponManagingStatus::NoWeapon);
 	SetFightingStatus(EWeaponFightingStatus::Idle);
@@ -1520,6 +2214,9 @@ void UAdvancedWeaponManager::DeEquip_Internal(int32 InIndex)
 
 void UAdvancedWeaponManager::Server_DeEquip_Implementation(int32 InIndex)
 {
+	MELEE_SCOPE_SERVER_RPC(Server_DeEquip);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::DeEquip, InIndex)))
+		return;
 	DeEquip_Internal(InIndex);
 }
 
@@ -1603,11 +2300,17 @@ float UAdvancedWeaponManager::GetShieldDurability() const
 
 void UAdvancedWeaponManager::Server_Equip_Implementation(int32 InIndex)
 {
+	MELEE_SCOPE_SERVER_RPC(Server_Equip);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::Equip, InIndex)))
+		return;
 	Equip_Internal(InIndex);
 }
 
 void UAdvancedWeaponManager::Server_StartAttack_Implementation(EWeaponDirection InDirection)
 {
+	MELEE_SCOPE_SERVER_RPC(Server_StartAttack);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::StartAttack, INDEX_NONE, InDirection)))
+		return;
 	if (!CanStartAttack())
 		return;
 
@@ -1664,6 +2367,9 @@ void UAdvancedWeaponManager::Server_StartAttack_Implementation(EWeaponDirection
 
 void UAdvancedWeaponManager::Server_StartAttackSimple_Implementation()
 {
+	MELEE_SCOPE_SERVER_RPC(Server_StartAttackSimple);
+	if (!AcceptInput_Internal(FMeleeInputCommand(EMeleeInputType::StartAttackSimple)))
+		return;
 	if (!CanStartAttack())
 		return;
 
@@ -1721,7 +2427,8 @@ void UAdvancedWeaponManager::Multi_PlayAnim_Implementation(
 	bool bUseSection,
 	const FName& Section)
 {
-	SetSavedGuid(InWeapon->GetGUIDString());
+	MELEE_SCOPE_RPC(Multi_PlayAnim);
+	SetSavedHandle(InWeapon->GetHandle());
 	FAnimPlayData data;
 	if (bUseSection)
 	{
@@ -1731,6 +2438,7 @@ void UAdvancedWeaponManager::Multi_PlayAnim_Implementation(
 	{
 		data = FAnimPlayData(InWeapon, InAnimSet, InTimeLen);
 	}
+	ResolveAnimPlayData(data);
 
 	// Always play third person animation for root motion
 	OnTpAnim.Broadcast(data);
@@ -1746,11 +2454,173 @@ void UAdvancedWeaponManager::Multi_PlayAnim_Implementation(
 	}*/
 }
 
+void UAdvancedWeaponManager::CacheWeaponMontages(UAbstractWeapon* InWeapon)
+{
+	if (!IsValid(InWeapon) || !InWeapon->IsValidData())
+		return;
+
+	// Montages are played by listeners on clients only
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_MeleeCacheMontages);
+	LLM_SCOPE_BYTAG(MeleeMaster);
+	const UWeaponDataAsset* data = InWeapon->GetData();
+	const TObjectKey<UWeaponDataAsset> dataKey(data);
+	const TArray<FSoftObjectPath>* dataPaths = MontagePathsByData.Find(dataKey);
+	if (!dataPaths)
+	{
+		TSet<FSoftObjectPath> paths;
+		CollectMontagePaths(data->GetClass(), data, paths);
+		if (IsValid(data->Animations))
+		{
+			CollectMontagePaths(data->Animations->GetClass(), data->Animations, paths);
+		}
+		dataPaths = &MontagePathsByData.Add(dataKey, paths.Array());
+	}
+
+	TArray<FSoftObjectPath> loadPaths;
+	for (const FSoftObjectPath& path : *dataPaths)
+	{
+		if (MontageCache.Contains(path))
+			continue;
+
+		UAnimMontage* montage = Cast<UAnimMontage>(path.ResolveObject());
+		// Null until the async load completes, GetCachedMontage falls back to the path meanwhile
+		MontageCache.Add(path, montage);
+		if (!IsValid(montage))
+		{
+			loadPaths.Add(path);
+		}
+	}
+	if (loadPaths.Num() <= 0)
+		return;
+
+	const FString dataName = data->GetName();
+	TSharedPtr<FStreamableHandle> handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(loadPaths,
+		FStreamableDelegate::CreateWeakLambda(this, [this, loadPaths, dataName]()
+		{
+			LLM_SCOPE_BYTAG(MeleeMaster);
+			for (const FSoftObjectPath& path : loadPaths)
+			{
+				UAnimMontage* montage = Cast<UAnimMontage>(path.ResolveObject());
+				if (!IsValid(montage))
+				{
+					TRACEWARN(LogWeapon, "Failed to load montage '%s' of '%s'", *path.ToString(), *dataName);
+					// Next CacheWeaponMontages requests it again
+					MontageCache.Remove(path);
+					continue;
+				}
+				if (UAnimMontage** cached = MontageCache.Find(path))
+				{
+					*cached = montage;
+				}
+			}
+			MontageLoadHandles.RemoveAll([](const TSharedPtr<FStreamableHandle>& InHandle)
+			{
+				return !InHandle.IsValid() || InHandle->HasLoadCompleted();
+			});
+		}));
+	if (handle.IsValid() && !handle->HasLoadCompleted())
+	{
+		MontageLoadHandles.Add(handle);
+	}
+}
+
+void UAdvancedWeaponManager::UpdateMontageCache()
+{
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+		return;
+
+	TSet<TObjectKey<UWeaponDataAsset>> ownedData;
+	for (const UAbstractWeapon* weapon : WeaponList)
+	{
+		if (IsValid(weapon) && weapon->IsValidData())
+		{
+			ownedData.Add(weapon->GetData());
+		}
+	}
+
+	bool bDataRemoved = false;
+	for (auto it = MontagePathsByData.CreateIterator(); it; ++it)
+	{
+		if (!ownedData.Contains(it.Key()))
+		{
+			it.RemoveCurrent();
+			bDataRemoved = true;
+		}
+	}
+	if (bDataRemoved)
+	{
+		// Removed montages stay loaded until GC
+		TSet<FSoftObjectPath> usedPaths;
+		for (const TPair<TObjectKey<UWeaponDataAsset>, TArray<FSoftObjectPath>>& pair : MontagePathsByData)
+		{
+			usedPaths.Append(pair.Value);
+		}
+		for (auto it = MontageCache.CreateIterator(); it; ++it)
+		{
+			if (!usedPaths.Contains(it.Key()))
+			{
+				it.RemoveCurrent();
+			}
+		}
+	}
+
+	for (UAbstractWeapon* weapon : WeaponList)
+	{
+		if (IsValid(weapon) && weapon->IsValidData() && !MontagePathsByData.Contains(weapon->GetData()))
+		{
+			CacheWeaponMontages(weapon);
+		}
+	}
+}
+
+void UAdvancedWeaponManager::ResetMontageCache()
+{
+	for (const TSharedPtr<FStreamableHandle>& handle : MontageLoadHandles)
+	{
+		if (handle.IsValid())
+		{
+			handle->CancelHandle();
+		}
+	}
+	MontageLoadHandles.Reset();
+	MontageCache.Reset();
+	MontagePathsByData.Reset();
+}
+
+UAnimMontage* UAdvancedWeaponManager::GetCachedMontage(const TSoftObjectPtr<UAnimMontage>& InMontage) const
+{
+	if (InMontage.IsNull())
+		return nullptr;
+
+	if (UAnimMontage* const* cached = MontageCache.Find(InMontage.ToSoftObjectPath()))
+	{
+		if (*cached)
+		{
+			return *cached;
+		}
+	}
+	return InMontage.Get();
+}
+
+void UAdvancedWeaponManager::ResolveAnimPlayData(FAnimPlayData& InOutData) const
+{
+	InOutData.FirstPersonMontage = GetCachedMontage(InOutData.AnimSet.FirstPerson.Value);
+	InOutData.ThirdPersonMontage = GetCachedMontage(InOutData.AnimSet.ThirdPerson.Value);
+	InOutData.FirstPersonPlayRate = UWeaponLib::CalculatePlayRate(InOutData.AnimSet.FirstPerson.Length,
+		InOutData.Time);
+	InOutData.ThirdPersonPlayRate = UWeaponLib::CalculatePlayRate(InOutData.AnimSet.ThirdPerson.Length,
+		InOutData.Time);
+}
+
 void UAdvancedWeaponManager::Multi_PlayVisualAnim_Implementation(UAbstractWeapon* InWeapon,
 	const FAnimMontageFullData& InAnimSet, float InTimeLen,
 	int32 VisualIndex, bool bUseSection,
 	const FName& Section)
 {
+	MELEE_SCOPE_RPC(Multi_PlayVisualAnim);
 	FAnimPlayData data;
 	if (bUseSection)
 	{
@@ -1760,6 +2630,7 @@ void UAdvancedWeaponManager::Multi_PlayVisualAnim_Implementation(UAbstractWeapon
 	{
 		data = FAnimPlayData(InWeapon, InAnimSet, InTimeLen);
 	}
+	ResolveAnimPlayData(data);
 
 	AWeaponVisual* wpnVisual;
 	bool bVisual = InWeapon->GetVisualActor(VisualIndex, wpnVisual);
@@ -1772,6 +2643,7 @@ void UAdvancedWeaponManager::Multi_PlayVisualAnim_Implementation(UAbstractWeapon
 
 void UAdvancedWeaponManager::Multi_AttachHand_Implementation()
 {
+	MELEE_SCOPE_RPC(Multi_AttachHand);
 	// Skip servers, it is already attached to actor
 	// Do not skip NM_Standalone
 	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
@@ -1786,17 +2658,18 @@ void UAdvancedWeaponManager::Multi_AttachHand_Implementation()
 	const int32 n = current->VisualNum();
 	for (int32 i = 0; i < n; ++i)
 	{
-		AttachHand(current->GetGUIDString(), n);
+		AttachHand(current->GetHandle(), n);
 	}
 }
 
-void UAdvancedWeaponManager::Multi_AttachBack_Implementation(const FString& InWeaponGuid)
+void UAdvancedWeaponManager::Multi_AttachBack_Implementation(FWeaponHandle InWeaponHandle)
 {
+	MELEE_SCOPE_RPC(Multi_AttachBack);
 	// Skip servers, it is already attached to actor
 	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
 		return;
 
-	UAbstractWeapon* wpn = WeaponByGuid(InWeaponGuid);
+	UAbstractWeapon* wpn = WeaponByHandle(InWeaponHandle);
 	if (!IsValid(wpn))
 		return;
 	if (!wpn->IsValidData())
@@ -1805,12 +2678,35 @@ void UAdvancedWeaponManager::Multi_AttachBack_Implementation(const FString& InWe
 	const int32 n = wpn->VisualNum();
 	for (int32 i = 0; i < n; ++i)
 	{
-		AttachBack(InWeaponGuid, n);
+		AttachBack(InWeaponHandle, n);
+	}
+}
+
+void UAdvancedWeaponManager::NotifyArrowLaunched(FWeaponHandle InWeaponHandle, const FArrowLaunchRecord& InRecord)
+{
+	if (GetWorld()->GetNetMode() == NM_Standalone)
+		return;
+
+	Multi_ArrowLaunched(InWeaponHandle, InRecord);
+}
+
+void UAdvancedWeaponManager::Multi_ArrowLaunched_Implementation(FWeaponHandle InWeaponHandle,
+	const FArrowLaunchRecord& InRecord)
+{
+	MELEE_SCOPE_RPC(Multi_ArrowLaunched);
+	// Server arrow is already launched
+	if (GetOwner()->HasAuthority())
+		return;
+
+	if (ULongRangeWeapon* rangeWeapon = Cast<ULongRangeWeapon>(WeaponByHandle(InWeaponHandle)))
+	{
+		rangeWeapon->LaunchArrowFromRecord(InRecord, false);
 	}
 }
 
 void UAdvancedWeaponManager::Multi_CancelCurrentAnim_Implementation()
 {
+	MELEE_SCOPE_RPC(Multi_CancelCurrentAnim);
 	if (IsLocalCustomPlayer())
 	{
 		OnCancelCurrentFpAnim.Broadcast();
@@ -1822,13 +2718,14 @@ void UAdvancedWeaponManager::Multi_CancelCurrentAnim_Implementation()
 }
 
 
-void UAdvancedWeaponManager::Multi_DropWeaponVisual_Implementation(const FString& InWeaponGuid)
+void UAdvancedWeaponManager::Multi_DropWeaponVisual_Implementation(FWeaponHandle InWeaponHandle)
 {
+	MELEE_SCOPE_RPC(Multi_DropWeaponVisual);
 	// Skip server
 	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
 		return;
 
-	if (UAbstractWeapon* weapon = WeaponByGuid(InWeaponGuid))
+	if (UAbstractWeapon* weapon = WeaponByHandle(InWeaponHandle))
 	{
 		TArray<AWeaponVisual*> weaponVisuals;
 		weapon->GetVisual(weaponVisuals);
@@ -1850,6 +2747,7 @@ void UAdvancedWeaponManager::Multi_DropWeaponVisual_Implementation(const FString
 
 void UAdvancedWeaponManager::Client_BlockRuined_Implementation(const FMeleeBlockData& Block)
 {
+	MELEE_SCOPE_RPC(Client_BlockRuined);
 	UE_LOG(LogWeapon, Error, TEXT("%hs OnClientBlockRuined.Broadcast"),
 		__FUNCTION__);
 	OnClientBlockRuined.Broadcast(EWeaponDirection::Forward, Block);
@@ -1858,20 +2756,26 @@ void UAdvancedWeaponManager::Client_BlockRuined_Implementation(const FMeleeBlock
 void UAdvancedWeaponManager::Client_Blocked_Implementation(EWeaponDirection InDirection,
 	const FMeleeBlockData& InBlockData)
 {
+	MELEE_SCOPE_RPC(Client_Blocked);
 	OnClientBlocked.Broadcast(InDirection, InBlockData);
 }
 
 void UAdvancedWeaponManager::Client_ParryStun_Implementation(EWeaponDirection InDirection,
 	const FMeleeAttackData& InAttackData)
 {
+	MELEE_SCOPE_RPC(Client_ParryStun);
 	OnClientParryStunned.Broadcast(InDirection, InAttackData);
 }
 
 
-void UAdvancedWeaponManager::Client_HitFinished_Implementation() {}
+void UAdvancedWeaponManager::Client_HitFinished_Implementation()
+{
+	MELEE_SCOPE_RPC(Client_HitFinished);
+}
 
 void UAdvancedWeaponManager::Multi_MeleeChargeFinished_Implementation()
 {
+	MELEE_SCOPE_RPC(Multi_MeleeChargeFinished);
 	if (IsValid(CurrentWeapon) && ClientWeaponModifierManager.IsValid())
 	{
 		ClientWeaponModifierManager->MeleeAttack(CurrentWeapon);
@@ -1880,6 +2784,7 @@ void UAdvancedWeaponManager::Multi_MeleeChargeFinished_Implementation()
 
 void UAdvancedWeaponManager::Multi_RangeChargingFinished_Implementation()
 {
+	MELEE_SCOPE_RPC(Multi_RangeChargingFinished);
 	if (IsValid(CurrentWeapon) && ClientWeaponModifierManager.IsValid())
 	{
 		ClientWeaponModifierManager->RangeAttack(CurrentWeapon);
@@ -1888,36 +2793,48 @@ void UAdvancedWeaponManager::Multi_RangeChargingFinished_Implementation()
 
 void UAdvancedWeaponManager::Multi_RangeCanceled_Implementation()
 {
+	MELEE_SCOPE_RPC(Multi_RangeCanceled);
 	if (IsValid(CurrentWeapon) && ClientWeaponModifierManager.IsValid())
 	{
 		ClientWeaponModifierManager->RangeCanceledAttack(CurrentWeapon);
 	}
 }
 
-void UAdvancedWeaponManager::Client_BlockChargingFinished_Implementation() {}
+void UAdvancedWeaponManager::Client_BlockChargingFinished_Implementation()
+{
+	MELEE_SCOPE_RPC(Client_BlockChargingFinished);
+}
 
 
 void UAdvancedWeaponManager::UpdateModifierCharging()
 {
 	if (IsValid(CurrentWeapon) && ClientWeaponModifierManager.IsValid())
 	{
+		const bool bWeaponChanged = LastModifierWeapon.Get() != CurrentWeapon;
+		LastModifierWeapon = CurrentWeapon;
+
 		EWeaponFightingStatus fightStatus = GetFightingStatus();
 		if (fightStatus == EWeaponFightingStatus::PreAttack)
 		{
 			ClientWeaponModifierManager->AttackCharging(CurrentWeapon, MinimalCurveValue);
+			bModifierCharging = true;
 		}
 		else if (fightStatus == EWeaponFightingStatus::AttackCharging
 			|| fightStatus == EWeaponFightingStatus::RangeCharging)
 		{
 			ClientWeaponModifierManager->AttackCharging(CurrentWeapon, EvaluateCurrentCurve());
+			bModifierCharging = true;
 		}
 		else if (fightStatus == EWeaponFightingStatus::BlockCharging)
 		{
 			ClientWeaponModifierManager->BlockCharging(CurrentWeapon, EvaluateCurrentCurve());
+			bModifierCharging = true;
 		}
-		else
+		else if (bModifierCharging || bWeaponChanged)
 		{
+			// Idle is sent once per transition, not every frame
 			ClientWeaponModifierManager->IdleState(CurrentWeapon);
+			bModifierCharging = false;
 		}
 	}
 }
@@ -1925,6 +2842,7 @@ void UAdvancedWeaponManager::UpdateModifierCharging()
 
 void UAdvancedWeaponManager::Multi_UpdateWeaponModifier_Implementation()
 {
+	MELEE_SCOPE_RPC(Multi_UpdateWeaponModifier);
 	// Skip server
 	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
 		return;
@@ -1979,6 +2897,7 @@ void UAdvancedWeaponManager::AttachBack(AWeaponVisual* InVisual)
 	FName backSocket = InVisual->GetBackSocket();
 	InVisual->AttachToComponent(attachComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale,
 		backSocket);
+	InVisual->SetAttachedToBack(true);
 
 	if (IsLocalCustomPlayer())
 	{
@@ -2011,8 +2930,8 @@ void UAdvancedWeaponManager::AttachHand(AWeaponVisual* InVisual)
 	const FName handSocket = InVisual->GetHandSocket();
 	InVisual->AttachToComponent(attachComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale,
 		handSocket);
-	FString wpn = InVisual->GetGUIDString();
-	//TRACE(LogWeapon, "Visual '%s' was attached to hand. Saved Guid: '%s'", *wpn, *SavedGuid);
+	InVisual->SetAttachedToBack(false);
+	//TRACE(LogWeapon, "Visual '%d' was attached to hand. Saved handle: '%d'", InVisual->GetWeaponHandle().Value, SavedHandle.Value);
 
 	// Manipulate visibility for local player (camera case)
 	if (IsLocalCustomPlayer())
@@ -2021,9 +2940,9 @@ void UAdvancedWeaponManager::AttachHand(AWeaponVisual* InVisual)
 	}
 }
 
-void UAdvancedWeaponManager::AttachBack(const FString& WeaponGuid, int32 VisualIndex)
+void UAdvancedWeaponManager::AttachBack(FWeaponHandle InWeaponHandle, int32 VisualIndex)
 {
-	UAbstractWeapon* weapon = WeaponByGuid(WeaponGuid);
+	UAbstractWeapon* weapon = WeaponByHandle(InWeaponHandle);
 	if (!IsValid(weapon))
 		return;
 	if (!weapon->IsValidData())
@@ -2036,9 +2955,9 @@ void UAdvancedWeaponManager::AttachBack(const FString& WeaponGuid, int32 VisualI
 }
 
 
-void UAdvancedWeaponManager::AttachHand(const FString& WeaponGuid, int32 InVisualIndex)
+void UAdvancedWeaponManager::AttachHand(FWeaponHandle InWeaponHandle, int32 InVisualIndex)
 {
-	UAbstractWeapon* weapon = WeaponByGuid(WeaponGuid);
+	UAbstractWeapon* weapon = WeaponByHandle(InWeaponHandle);
 	if (!IsValid(weapon))
 		return;
 	if (!weapon->IsValidData())
@@ -2070,7 +2989,11 @@ void UAdvancedWeaponManager::ShowWeaponTrail(int32 InVisualIndex)
 	if (!IsValid(wpnVisual))
 		return;
 
-	wpnVisual->ShowTrail();
+	// Distant fighters draw no trails
+	if (wpnVisual->GetVisualLOD() != EWeaponVisualLOD::Full)
+		return;
+
+	wpnVisual->StartTrail();
 }
 
 void UAdvancedWeaponManager::HideWeaponTrail(int32 InVisualIndex)
@@ -2093,7 +3016,11 @@ void UAdvancedWeaponManager::HideWeaponTrail(int32 InVisualIndex)
 	if (!IsValid(wpnVisual))
 		return;
 
-	wpnVisual->HideTrail();
+	// Already hidden when LOD was lowered
+	if (wpnVisual->GetVisualLOD() != EWeaponVisualLOD::Full)
+		return;
+
+	wpnVisual->StopTrail();
 }
 
 void UAdvancedWeaponManager::NotifyPlayWeaponAnim(UAbstractWeapon* InWeapon, const FAnimMontageFullData& InMontageData,
@@ -2187,7 +3114,7 @@ void UAdvancedWeaponManager::NotifyBlocked()
 
 void UAdvancedWeaponManager::NotifyShieldDurabilityLost()
 {
-	Server_UnBlock();
+	ExecuteInput(FMeleeInputCommand(EMeleeInputType::UnBlock));
 }
 
 void UAdvancedWeaponManager::NotifyShieldRuined()
@@ -2344,12 +3271,17 @@ void UAdvancedWeaponManager::ClearBeforeDestroy()
 	{
 		if (WeaponList[i])
 		{
+			RemoveReplicatedSubObject(WeaponList[i]);
+			ReleaseLocalVisuals(WeaponList[i]);
 			WeaponList[i]->DestroyVisuals();
 			WeaponList[i]->ConditionalBeginDestroy();
 			WeaponList[i] = nullptr;
 		}
 	}
 	WeaponList.Empty();
+	WeaponHandleMap.Empty();
+	bWeaponHandleMapDirty = false;
+	ResetMontageCache();
 	MARK_PROPERTY_DIRTY_FROM_NAME(UAdvancedWeaponManager, WeaponList, this);
 }
 
@@ -2363,10 +3295,10 @@ void UAdvancedWeaponManager::StopWork()
 	timerManager.ClearTimer(HittingTimerHandle);
 }
 
-void UAdvancedWeaponManager::DropWeaponVisual(const FString& InWeaponGuid)
+void UAdvancedWeaponManager::DropWeaponVisual(FWeaponHandle InWeaponHandle)
 {
 	// Should be server side call or single player 
-	Multi_DropWeaponVisual(InWeaponGuid);
+	Multi_DropWeaponVisual(InWeaponHandle);
 }
 
 bool UAdvancedWeaponManager::RemoveWeapon(int32 InIndex)
@@ -2375,7 +3307,26 @@ bool UAdvancedWeaponManager::RemoveWeapon(int32 InIndex)
 	{
 		return false;
 	}
-	// TODO: Remove and destroy weapon 
+
+	UAbstractWeapon* weapon = WeaponList[InIndex];
+	// Current weapon must be de-equipped first
+	if (IsValid(weapon) && weapon == GetCurrentWeapon())
+	{
+		return false;
+	}
+
+	WeaponList.RemoveAt(InIndex);
+	MARK_PROPERTY_DIRTY_FROM_NAME(UAdvancedWeaponManager, WeaponList, this);
+
+	if (IsValid(weapon))
+	{
+		bWeaponHandleMapDirty = true;
+		RemoveReplicatedSubObject(weapon);
+		ReleaseLocalVisuals(weapon);
+		weapon->DestroyVisuals();
+		weapon->ConditionalBeginDestroy();
+	}
+	UpdateMontageCache();
 	return true;
 }
 
@@ -2392,6 +3343,7 @@ bool UAdvancedWeaponManager::IsChargingMeleeAttack() const
 
 EBlockResult UAdvancedWeaponManager::CanBlockIncomingDamage(UAdvancedWeaponManager* Causer)
 {
+	MELEE_SCOPE_CYCLE(CanBlockIncomingDamage);
 	if (!IsValid(Causer))
 		return EBlockResult::Invalid;
 
@@ -2412,33 +3364,13 @@ EBlockResult UAdvancedWeaponManager::CanBlockIncomingDamage(UAdvancedWeaponManag
 	const auto attackDir = Causer->GetCurrentDirection();
 	const auto blockDir = GetCurrentDirection();
 
-	auto checkBlockDir = [](EWeaponDirection attack, EWeaponDirection block) {
-		switch (attack)
-		{
-			case EWeaponDirection::Forward:
-			case EWeaponDirection::Backward:
-				// Block direction must match for Forward and Backward attacks
-				return attack == block;
-
-			case EWeaponDirection::Right:
-				// Block direction must be Left for a Right attack
-				return block == EWeaponDirection::Left;
-
-			case EWeaponDirection::Left:
-				// Block direction must be Right for a Left attack
-				return block == EWeaponDirection::Right;
-			default:
-				// If WeaponDir is invalid, return false
-				return false;
-		}
-	};
 	const bool bShield = meleeWpn->IsShieldEquipped();
 
 	// Only without shield we should check direction
 	if (!bShield)
 	{
 		// Check direction
-		if (!checkBlockDir(attackDir, blockDir))
+		if (!FMeleeCombatMath::IsBlockDirectionMatched(attackDir, blockDir))
 		{
 			return EBlockResult::FullDamage;
 		}
@@ -2458,40 +3390,11 @@ EBlockResult UAdvancedWeaponManager::CanBlockIncomingDamage(UAdvancedWeaponManag
 	if (Causer->GetFightingStatus() != EWeaponFightingStatus::Attacking)
 		return EBlockResult::Invalid;
 
-	const float blockValue = EvaluateCurrentCurve();
-	const float attackValue = Causer->GetCurrentHitPower();
-
-	const uint8 blockTier = static_cast<uint8>(meleeWpn->GetData()->WeaponTier);
-	const uint8 attackTier = static_cast<uint8>(meleeCauserWeapon->GetData()->WeaponTier);
-
-	/*
-	* We can only parry weapons of the same class or lower.
-	* So 'High' can parry all
-	* 'Medium' can only parry itself and 'Light'
-	* 'Light' only itself
-	 */
-	const bool bIsAbleToParry = blockTier >= attackTier;
-
-	if (bShield)
-	{
-		return EBlockResult::ShieldBlock;
-	}
-
-	if (attackValue >= 1.0)
-	{
-		return EBlockResult::Block;
-	}
-
-	if (attackValue >= blockValue)
-	{
-		return EBlockResult::Block;
-	}
-
-	if (attackValue < blockValue)
-	{
-		return bIsAbleToParry ? EBlockResult::Parry : EBlockResult::Block;
-	}
-	return EBlockResult::FullDamage;
+	return FMeleeCombatMath::ResolveBlock(bShield,
+		meleeWpn->GetData()->WeaponTier,
+		meleeCauserWeapon->GetData()->WeaponTier,
+		Causer->GetCurrentHitPower(),
+		EvaluateCurrentCurve());
 }
 
 EBlockResult UAdvancedWeaponManager::CanBlockIncomingProjectileDamage()
@@ -2568,27 +3471,9 @@ bool UAdvancedWeaponManager::CanBlockSide(const FVector& DamageSourceLocation)
 	if (!IsValid(meleeWpn))
 		return false;
 
-	// Direction the actor is facing (forward vector)
-	FVector actorForward = GetOwner()->GetActorForwardVector();
-	actorForward.Z = 0.0f; // Ignore vertical component (Z-axis)
-	actorForward.Normalize();
-
-	// Direction to the damage source
-	FVector toDamageSource = DamageSourceLocation - GetOwner()->GetActorLocation();
-	toDamageSource.Z = 0.0f; // Ignore vertical component (Z-axis)
-	toDamageSource.Normalize();
-
-	// Angle between the two vectors
-	const float dotProduct = FVector::DotProduct(actorForward, toDamageSource);
-
-	//float AngleDegrees = FMath::Acos(DotProduct) * (180.0f / PI);
-	const float angleDegrees = FMath::Acos(dotProduct) * (FMathd::RadToDeg);
-
-	const float blockAngle = meleeWpn->GetCurrentMeleeCombinedData().BlockAngle;
-
-	//TRACE(LogWeapon, "Block angle: %.1f", angleDegrees);
-
-	return angleDegrees <= blockAngle / 2.0f;
+	return FMeleeCombatMath::IsInBlockAngle(GetOwner()->GetActorForwardVector(),
+		DamageSourceLocation - GetOwner()->GetActorLocation(),
+		meleeWpn->GetCurrentMeleeCombinedData().BlockAngle);
 }
 
 UAbstractWeapon* UAdvancedWeaponManager::Weapon(int32 InIndex) const
@@ -2623,6 +3508,50 @@ UAbstractWeapon* UAdvancedWeaponManager::WeaponByGuid(FString InGuid)
 	return nullptr;
 }
 
+UAbstractWeapon* UAdvancedWeaponManager::WeaponByHandle(FWeaponHandle InHandle) const
+{
+	if (!InHandle.IsValid())
+		return nullptr;
+
+	if (bWeaponHandleMapDirty)
+	{
+		RebuildWeaponHandleMap();
+	}
+
+	if (const TWeakObjectPtr<UAbstractWeapon>* found = WeaponHandleMap.Find(InHandle))
+	{
+		UAbstractWeapon* weapon = found->Get();
+		if (IsValid(weapon) && weapon->GetHandle() == InHandle)
+		{
+			return weapon;
+		}
+	}
+	return nullptr;
+}
+
+FWeaponHandle UAdvancedWeaponManager::MakeWeaponHandle()
+{
+	// Zero is reserved for invalid handle
+	if (++LastWeaponHandle == 0)
+	{
+		++LastWeaponHandle;
+	}
+	return FWeaponHandle(LastWeaponHandle);
+}
+
+void UAdvancedWeaponManager::RebuildWeaponHandleMap() const
+{
+	bWeaponHandleMapDirty = false;
+	WeaponHandleMap.Reset();
+	for (UAbstractWeapon* el : WeaponList)
+	{
+		if (IsValid(el) && el->GetHandle().IsValid())
+		{
+			WeaponHandleMap.Add(el->GetHandle(), el);
+		}
+	}
+}
+
 int32 UAdvancedWeaponManager::WeaponNum() const
 {
 	return WeaponList.Num();
@@ -2847,10 +3776,11 @@ void UAdvancedWeaponManager::ProcessWeaponDamage(AActor* Causer, float Amount,
 	TSubclassOf<UDamageType> DamageType,
 	EDamageReturn& OutDamageReturn, float& OutDamage)
 {
+	MELEE_SCOPE_CYCLE(ProcessWeaponDamage);
 	OutDamageReturn = EDamageReturn::Failed;
 	OutDamage = 0.0f;
 
-	UAdvancedWeaponManager* causerWpnManager = Causer->FindComponentByClass<UAdvancedWeaponManager>();
+	UAdvancedWeaponManager* causerWpnManager = UAdvancedWeaponManager::FindForActor(Causer);
 	EBlockResult blockResult = this->CanBlockIncomingDamage(causerWpnManager);
 
 	if (blockResult == EBlockResult::Invalid)
@@ -2874,8 +3804,10 @@ void UAdvancedWeaponManager::ProcessWeaponDamage(AActor* Causer, float Amount,
 	{
 		return;
 	}
+	FMeleeCounters::AddHit();
 	if (blockResult == EBlockResult::Parry)
 	{
+		FMeleeCounters::AddParry();
 		causerWpnManager->ApplyParryStun();
 		this->StartParry(CurrentDirection);
 		OutDamageReturn = EDamageReturn::Alive;
@@ -2901,19 +3833,23 @@ void UAdvancedWeaponManager::ProcessWeaponDamage(AActor* Causer, float Amount,
 
 	if (blockResult != EBlockResult::FullDamage)
 	{
+		FMeleeCounters::AddBlock();
 		realDmg = this->BlockIncomingDamage(Amount, causerWpnManager);
 	}
 
-	IWeaponManagerOwner::Execute_ApplyDamage(GetOwner(), Causer, realDmg, HitResult,
-		DamageType,
-		OutDamageReturn, OutDamage);
+	if (GetOwner()->Implements<UWeaponManagerOwner>())
+	{
+		IWeaponManagerOwner::Execute_ApplyDamage(GetOwner(), Causer, realDmg, HitResult,
+			DamageType,
+			OutDamageReturn, OutDamage);
+	}
 
 	if (bHasLostDurability)
 	{
 		// Sound, effect, etc
 		this->NotifyShieldRuined();
 		// Remove shield (unblock)
-		Server_UnBlock();
+		ExecuteInput(FMeleeInputCommand(EMeleeInputType::UnBlock));
 		return;
 	}
 	else if (blockResult == EBlockResult::Block
@@ -2972,7 +3908,7 @@ void UAdvancedWeaponManager::ProcessProjectileDamage(AActor* Causer, float Amoun
 	if (bHasLostShieldDurability)
 	{
 		// Remove shield (unblock)
-		Server_UnBlock();
+		ExecuteInput(FMeleeInputCommand(EMeleeInputType::UnBlock));
 		// Sound, effect, etc
 		this->NotifyShieldRuined();
 		return;
@@ -2999,15 +3935,140 @@ bool UAdvancedWeaponManager::CanChange(int32 InIndex)
 	return bDeEquip;
 }
 
+void UAdvancedWeaponManager::ExecuteInput(const FMeleeInputCommand& InCommand)
+{
+	if (!GetOwner()->HasAuthority())
+	{
+		TRACEERROR(LogWeapon, "ExecuteInput is server only");
+		return;
+	}
+
+	// Server decisions and released input are not limited again
+	TGuardValue<bool> executingGuard(bExecutingInput, true);
+	switch (InCommand.Type)
+	{
+	case EMeleeInputType::Equip:
+		Server_Equip_Implementation(InCommand.Index);
+		break;
+	case EMeleeInputType::DeEquip:
+		Server_DeEquip_Implementation(InCommand.Index);
+		break;
+	case EMeleeInputType::Change:
+		Server_Change_Implementation(InCommand.Index);
+		break;
+	case EMeleeInputType::StartAttack:
+		Server_StartAttack_Implementation(InCommand.Direction);
+		break;
+	case EMeleeInputType::StartAttackSimple:
+		Server_StartAttackSimple_Implementation();
+		break;
+	case EMeleeInputType::Attack:
+		Server_Attack_Implementation();
+		break;
+	case EMeleeInputType::Block:
+		Server_Block_Implementation(InCommand.Direction);
+		break;
+	case EMeleeInputType::UnBlock:
+		Server_UnBlock_Implementation();
+		break;
+	case EMeleeInputType::CancelCharge:
+		Server_CancelCharge_Implementation();
+		break;
+	case EMeleeInputType::GetShield:
+		Server_GetShield_Implementation();
+		break;
+	case EMeleeInputType::RemoveShield:
+		Server_RemoveShield_Implementation();
+		break;
+	}
+}
+
+void UAdvancedWeaponManager::RecordInput_Internal(const FMeleeInputCommand& InCommand)
+{
+	if (UCombatRecorderSubsystem* recorder = UCombatRecorderSubsystem::Get(this))
+	{
+		recorder->RecordInput(this, InCommand);
+	}
+}
+
+void UAdvancedWeaponManager::SendInput_Internal(const FMeleeInputCommand& InCommand)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		ExecuteInput(InCommand);
+		return;
+	}
+
+	switch (InCommand.Type)
+	{
+	case EMeleeInputType::Equip:
+		Server_Equip(InCommand.Index);
+		break;
+	case EMeleeInputType::DeEquip:
+		Server_DeEquip(InCommand.Index);
+		break;
+	case EMeleeInputType::Change:
+		Server_Change(InCommand.Index);
+		break;
+	case EMeleeInputType::StartAttack:
+		Server_StartAttack(InCommand.Direction);
+		break;
+	case EMeleeInputType::StartAttackSimple:
+		Server_StartAttackSimple();
+		break;
+	case EMeleeInputType::Attack:
+		Server_Attack();
+		break;
+	case EMeleeInputType::Block:
+		Server_Block(InCommand.Direction);
+		break;
+	case EMeleeInputType::UnBlock:
+		Server_UnBlock();
+		break;
+	case EMeleeInputType::CancelCharge:
+		Server_CancelCharge();
+		break;
+	case EMeleeInputType::GetShield:
+		Server_GetShield();
+		break;
+	case EMeleeInputType::RemoveShield:
+		Server_RemoveShield();
+		break;
+	}
+}
+
+bool UAdvancedWeaponManager::AcceptInput_Internal(const FMeleeInputCommand& InCommand)
+{
+	if (!bExecutingInput)
+	{
+		// Listen server host, AI and standalone have no connection
+		UNetConnection* connection = GetOwner()->GetNetConnection();
+		UMeleeRpcLimiterSubsystem* limiter = connection ? UMeleeRpcLimiterSubsystem::Get(this) : nullptr;
+		if (limiter && !limiter->AcceptInput(this, connection, InCommand))
+			return false;
+	}
+
+	RecordInput_Internal(InCommand);
+	return true;
+}
+
+bool UAdvancedWeaponManager::IsRemoteRpc_Internal(bool bInServerRpc) const
+{
+	if (GetOwnerRole() != ROLE_Authority)
+		return true;
+
+	return bInServerRpc && !bExecutingInput && GetOwner()->GetNetConnection() != nullptr;
+}
+
 void UAdvancedWeaponManager::TryEquipProxy(int32 InIndex)
 {
 	if (CanChange(InIndex))
 	{
-		Server_Change(InIndex);
+		SendInput_Internal(FMeleeInputCommand(EMeleeInputType::Change, InIndex));
 	}
 	else if (CanEquip(InIndex))
 	{
-		Server_Equip(InIndex);
+		SendInput_Internal(FMeleeInputCommand(EMeleeInputType::Equip, InIndex));
 	}
 }
 
@@ -3016,7 +4077,7 @@ void UAdvancedWeaponManager::TryDeEquipProxy(int32 InIndex)
 	if (!CanDeEquip(InIndex))
 		return;
 
-	Server_DeEquip(InIndex);
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::DeEquip, InIndex));
 }
 
 void UAdvancedWeaponManager::TryRemoveShieldProxy()
@@ -3024,7 +4085,7 @@ void UAdvancedWeaponManager::TryRemoveShieldProxy()
 	if (!CanRemoveShield())
 		return;
 
-	Server_RemoveShield();
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::RemoveShield));
 }
 
 void UAdvancedWeaponManager::TryGetShieldProxy()
@@ -3032,18 +4093,18 @@ void UAdvancedWeaponManager::TryGetShieldProxy()
 	if (!CanGetShield())
 		return;
 
-	Server_GetShield();
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::GetShield));
 }
 
 void UAdvancedWeaponManager::TrySwapShieldProxy()
 {
 	if (CanGetShield())
 	{
-		Server_GetShield();
+		SendInput_Internal(FMeleeInputCommand(EMeleeInputType::GetShield));
 	}
 	else if (CanRemoveShield())
 	{
-		Server_RemoveShield();
+		SendInput_Internal(FMeleeInputCommand(EMeleeInputType::RemoveShield));
 	}
 }
 
@@ -3051,40 +4112,40 @@ void UAdvancedWeaponManager::RequestDirectedAttackProxy(EWeaponDirection InDirec
 {
 	if (!CanStartAttack())
 		return;
-	Server_StartAttack(InDirection);
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::StartAttack, INDEX_NONE, InDirection));
 }
 
 void UAdvancedWeaponManager::RequestSimpleAttackProxy()
 {
 	if (!CanStartAttack())
 		return;
-	Server_StartAttackSimple();
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::StartAttackSimple));
 }
 
 void UAdvancedWeaponManager::RequestAttackReleasedProxy()
 {
 	if (!CanAttack())
 		return;
-	Server_Attack();
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::Attack));
 }
 
 void UAdvancedWeaponManager::RequestBlockProxy(EWeaponDirection InDirection)
 {
 	if (!CanBlock())
 		return;
-	Server_Block(InDirection);
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::Block, INDEX_NONE, InDirection));
 }
 
 void UAdvancedWeaponManager::RequestCancelChargeProxy()
 {
 	if (!CanCancelCharge())
 		return;
-	Server_CancelCharge();
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::CancelCharge));
 }
 
 void UAdvancedWeaponManager::RequestBlockReleasedProxy()
 {
 	if (!CanUnBlock())
 		return;
-	Server_UnBlock();
+	SendInput_Internal(FMeleeInputCommand(EMeleeInputType::UnBlock));
 }
\ No newline at end of file
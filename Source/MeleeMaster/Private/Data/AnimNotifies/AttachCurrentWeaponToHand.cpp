@@ -15,9 +15,9 @@ void UAttachCurrentWeaponToHand::Notify(USkeletalMeshComponent* MeshComp, UAnimS
 
 	if (AActor* owner = MeshComp->GetOwner())
 	{
-		if (UAdvancedWeaponManager* weaponManager = owner->FindComponentByClass<UAdvancedWeaponManager>())
+		if (UAdvancedWeaponManager* weaponManager = UAdvancedWeaponManager::FindForActor(owner))
 		{
-			weaponManager->AttachHand(weaponManager->SavedGuid, VisualIndex);
+			weaponManager->AttachHand(weaponManager->SavedHandle, VisualIndex);
 		}
 	}
 }
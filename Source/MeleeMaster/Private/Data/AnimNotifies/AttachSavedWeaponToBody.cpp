@@ -17,9 +17,9 @@ void UAttachSavedWeaponToBody::Notify(USkeletalMeshComponent* MeshComp, UAnimSeq
 
 	if (AActor* owner = MeshComp->GetOwner())
 	{
-		if (UAdvancedWeaponManager* weaponManager = owner->FindComponentByClass<UAdvancedWeaponManager>())
+		if (UAdvancedWeaponManager* weaponManager = UAdvancedWeaponManager::FindForActor(owner))
 		{
-			weaponManager->AttachBack(weaponManager->SavedGuid, VisualIndex);
+			weaponManager->AttachBack(weaponManager->SavedHandle, VisualIndex);
 		}
 	}
 }
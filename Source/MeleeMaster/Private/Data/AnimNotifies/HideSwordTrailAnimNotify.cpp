@@ -14,7 +14,7 @@ void UHideSwordTrailAnimNotify::Notify(USkeletalMeshComponent* MeshComp, UAnimSe
 
 	if (AActor* owner = MeshComp->GetOwner())
 	{
-		if (UAdvancedWeaponManager* weaponManager = owner->FindComponentByClass<UAdvancedWeaponManager>())
+		if (UAdvancedWeaponManager* weaponManager = UAdvancedWeaponManager::FindForActor(owner))
 		{
 			weaponManager->HideWeaponTrail(VisualIndex);
 		}
@@ -11,7 +11,7 @@ void UShowSwordTrailAnimNotify::Notify(USkeletalMeshComponent* MeshComp, UAnimSe
 	Super::Notify(MeshComp, Animation, EventReference);
 	if (AActor* owner = MeshComp->GetOwner())
 	{
-		if (UAdvancedWeaponManager* weaponManager = owner->FindComponentByClass<UAdvancedWeaponManager>())
+		if (UAdvancedWeaponManager* weaponManager = UAdvancedWeaponManager::FindForActor(owner))
 		{
 			weaponManager->ShowWeaponTrail(VisualIndex);
 		}
@@ -0,0 +1,34 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Data/AnimNotifies/WeaponTrailNotifyState.h"
+
+#include "Components/AdvancedWeaponManager.h"
+
+void UWeaponTrailNotifyState::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+                                          float TotalDuration, const FAnimNotifyEventReference& EventReference)
+{
+	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
+
+	if (UAdvancedWeaponManager* weaponManager = UAdvancedWeaponManager::FindForActor(MeshComp->GetOwner()))
+	{
+		weaponManager->ShowWeaponTrail(VisualIndex);
+	}
+}
+
+void UWeaponTrailNotifyState::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+                                        const FAnimNotifyEventReference& EventReference)
+{
+	Super::NotifyEnd(MeshComp, Animation, EventReference);
+
+	// Also called when the montage is interrupted, trail never stays on
+	if (UAdvancedWeaponManager* weaponManager = UAdvancedWeaponManager::FindForActor(MeshComp->GetOwner()))
+	{
+		weaponManager->HideWeaponTrail(VisualIndex);
+	}
+}
+
+FString UWeaponTrailNotifyState::GetNotifyName_Implementation() const
+{
+	return FString(TEXT("Weapon Trail"));
+}
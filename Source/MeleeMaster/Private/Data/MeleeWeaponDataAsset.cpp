@@ -81,4 +81,5 @@ UMeleeWeaponDataAsset::UMeleeWeaponDataAsset() : Super()
 {
 	AssetType = FName(TEXT("MeleeWeaponData"));
 	bHasShield = false;
+	bDamageOncePerSwing = false;
 }
@@ -7,3 +7,9 @@ UWeaponHitPathAsset::UWeaponHitPathAsset(): Radius(10), TraceQuery()
 {
 	AssetType = "HitPath";
 }
+
+void UWeaponHitPathAsset::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Data.Elements.GetAllocatedSize());
+}
@@ -0,0 +1,104 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeCombatMath.h"
+
+bool FMeleeCombatMath::IsBlockDirectionMatched(EWeaponDirection InAttack, EWeaponDirection InBlock)
+{
+	switch (InAttack)
+	{
+		case EWeaponDirection::Forward:
+		case EWeaponDirection::Backward:
+			// Block direction must match for Forward and Backward attacks
+			return InAttack == InBlock;
+
+		case EWeaponDirection::Right:
+			// Block direction must be Left for a Right attack
+			return InBlock == EWeaponDirection::Left;
+
+		case EWeaponDirection::Left:
+			// Block direction must be Right for a Left attack
+			return InBlock == EWeaponDirection::Right;
+		default:
+			// If WeaponDir is invalid, return false
+			return false;
+	}
+}
+
+EBlockResult FMeleeCombatMath::ResolveBlock(bool bInShield, EWeaponTier InBlockTier, EWeaponTier InAttackTier,
+	float InAttackValue, float InBlockValue)
+{
+	/*
+	* We can only parry weapons of the same class or lower.
+	* So 'High' can parry all
+	* 'Medium' can only parry itself and 'Light'
+	* 'Light' only itself
+	 */
+	const bool bIsAbleToParry = static_cast<uint8>(InBlockTier) >= static_cast<uint8>(InAttackTier);
+
+	if (bInShield)
+	{
+		return EBlockResult::ShieldBlock;
+	}
+
+	if (InAttackValue >= 1.0)
+	{
+		return EBlockResult::Block;
+	}
+
+	if (InAttackValue >= InBlockValue)
+	{
+		return EBlockResult::Block;
+	}
+
+	if (InAttackValue < InBlockValue)
+	{
+		return bIsAbleToParry ? EBlockResult::Parry : EBlockResult::Block;
+	}
+	return EBlockResult::FullDamage;
+}
+
+bool FMeleeCombatMath::IsInBlockAngle(FVector InForward, FVector InToSource, float InBlockAngle)
+{
+	InForward.Z = 0.0f; // Ignore vertical component (Z-axis)
+	InForward.Normalize();
+
+	InToSource.Z = 0.0f;
+	InToSource.Normalize();
+
+	// Angle between the two vectors
+	const float dotProduct = FVector::DotProduct(InForward, InToSource);
+	const float angleDegrees = FMath::Acos(dotProduct) * (FMathd::RadToDeg);
+
+	return angleDegrees <= InBlockAngle / 2.0f;
+}
+
+float FMeleeCombatMath::GetChargingCurveTime(float InStartTime, float InFinishTime, float InServerTime)
+{
+	// Duration of full curve
+	const float duration = FMath::Abs(InFinishTime - InStartTime);
+
+	// Time to end curve
+	const float secondsLeft = InFinishTime - InServerTime;
+
+	// Time from start
+	return duration - secondsLeft;
+}
+
+float FMeleeCombatMath::EvaluateComboDamage(float InDamage, float InComboSum)
+{
+	return InDamage + InComboSum * InDamage;
+}
+
+void FMeleeCombatMath::TransformHitSegment(FRotator InControlRotation, FVector InOwnerLocation, float InZOffset,
+	const FWeaponHitDataElement& InElement, FVector& OutStart, FVector& OutEnd, FRotator& OutRotation)
+{
+	// Hit paths are authored facing +Y
+	InControlRotation.Pitch = 0.0f;
+	InControlRotation.Add(0.0f, -90.0f, 0.0f);
+	InOwnerLocation.Z += InZOffset;
+
+	OutStart = InControlRotation.RotateVector(InElement.Start) + InOwnerLocation;
+	OutEnd = InControlRotation.RotateVector(InElement.End) + InOwnerLocation;
+	OutRotation = InControlRotation;
+}
@@ -0,0 +1,232 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeCounters.h"
+
+#include "MeleeMaster.h"
+#include <atomic>
+
+namespace MeleeCounters
+{
+	enum ECounter : int32
+	{
+		Traces,
+		TracesSkipped,
+		TraceTargets,
+		Hits,
+		Blocks,
+		Parries,
+		Rpcs,
+		CounterNum
+	};
+
+	constexpr int32 PhaseNum = static_cast<int32>(EMeleePhase::Num);
+
+	/**
+	 * @brief Counters of one thread. Only the owner thread writes (no read-modify-write between threads),
+	 * aggregation reads with relaxed loads. Blocks live until process exit, threads are pooled.
+	 */
+	struct FThreadBlock
+	{
+		std::atomic<int64> Counters[CounterNum]{};
+		std::atomic<uint64> PhaseCycles[PhaseNum]{};
+		std::atomic<uint64> PhaseHistograms[PhaseNum][FMeleeHistogram::BucketNum]{};
+	};
+
+	template <typename T>
+	FORCEINLINE void Increment(std::atomic<T>& InValue, T InAmount)
+	{
+		InValue.store(InValue.load(std::memory_order_relaxed) + InAmount, std::memory_order_relaxed);
+	}
+
+	/** Registration and aggregation only */
+	static FCriticalSection& GetBlocksLock()
+	{
+		static FCriticalSection lock;
+		return lock;
+	}
+
+	static TArray<FThreadBlock*>& GetBlocks()
+	{
+		static TArray<FThreadBlock*> blocks;
+		return blocks;
+	}
+
+	static FThreadBlock& GetThreadBlock()
+	{
+		static thread_local FThreadBlock* threadBlock = nullptr;
+		if (!threadBlock)
+		{
+			threadBlock = new FThreadBlock();
+			FScopeLock lock(&GetBlocksLock());
+			GetBlocks().Add(threadBlock);
+		}
+		return *threadBlock;
+	}
+
+	static void Add(ECounter InCounter, int64 InAmount = 1)
+	{
+		Increment(GetThreadBlock().Counters[InCounter], InAmount);
+	}
+}
+
+int32 FMeleeHistogram::GetBucket(uint64 InNanoseconds)
+{
+	if (InNanoseconds < SubBucketNum)
+		return static_cast<int32>(InNanoseconds);
+
+	const int32 exponent = FMath::FloorLog2_64(InNanoseconds);
+	const int32 subBucket = static_cast<int32>(InNanoseconds >> (exponent - SubBucketBits)) - SubBucketNum;
+	return FMath::Min(SubBucketNum + (exponent - SubBucketBits) * SubBucketNum + subBucket, BucketNum - 1);
+}
+
+uint64 FMeleeHistogram::GetBucketMin(int32 InBucket)
+{
+	if (InBucket < SubBucketNum)
+		return InBucket;
+
+	const int32 exponent = (InBucket - SubBucketNum) / SubBucketNum + SubBucketBits;
+	const uint64 subBucket = (InBucket - SubBucketNum) % SubBucketNum;
+	return (SubBucketNum + subBucket) << (exponent - SubBucketBits);
+}
+
+uint64 FMeleeHistogram::Num() const
+{
+	uint64 num = 0;
+	for (const uint64 count : Counts)
+	{
+		num += count;
+	}
+	return num;
+}
+
+double FMeleeHistogram::GetPercentile(float InPercent) const
+{
+	const uint64 num = Num();
+	if (num == 0)
+		return 0.0;
+
+	const uint64 rank = FMath::Max<uint64>(FMath::CeilToInt64(InPercent * num), 1);
+	uint64 seen = 0;
+	for (int32 i = 0; i < BucketNum; ++i)
+	{
+		seen += Counts[i];
+		if (seen >= rank)
+		{
+			const uint64 nextMin = i + 1 < BucketNum ? GetBucketMin(i + 1) : GetBucketMin(i) * 2;
+			return (GetBucketMin(i) + nextMin) * 0.5;
+		}
+	}
+	return GetBucketMin(BucketNum - 1);
+}
+
+FMeleeHistogram FMeleeHistogram::operator-(const FMeleeHistogram& InEarlier) const
+{
+	FMeleeHistogram result;
+	for (int32 i = 0; i < BucketNum; ++i)
+	{
+		result.Counts[i] = Counts[i] - InEarlier.Counts[i];
+	}
+	return result;
+}
+
+FMeleeCounters FMeleeCounters::Get()
+{
+	using namespace MeleeCounters;
+
+	FMeleeCounters result;
+	FScopeLock lock(&GetBlocksLock());
+	for (const FThreadBlock* block : GetBlocks())
+	{
+		result.Traces += block->Counters[ECounter::Traces].load(std::memory_order_relaxed);
+		result.TracesSkipped += block->Counters[ECounter::TracesSkipped].load(std::memory_order_relaxed);
+		result.TraceTargets += block->Counters[ECounter::TraceTargets].load(std::memory_order_relaxed);
+		result.Hits += block->Counters[ECounter::Hits].load(std::memory_order_relaxed);
+		result.Blocks += block->Counters[ECounter::Blocks].load(std::memory_order_relaxed);
+		result.Parries += block->Counters[ECounter::Parries].load(std::memory_order_relaxed);
+		result.Rpcs += block->Counters[ECounter::Rpcs].load(std::memory_order_relaxed);
+		for (int32 phase = 0; phase < PhaseNum; ++phase)
+		{
+			result.PhaseCycles[phase] += block->PhaseCycles[phase].load(std::memory_order_relaxed);
+			for (int32 bucket = 0; bucket < FMeleeHistogram::BucketNum; ++bucket)
+			{
+				result.PhaseHistograms[phase].Counts[bucket] +=
+					block->PhaseHistograms[phase][bucket].load(std::memory_order_relaxed);
+			}
+		}
+	}
+	return result;
+}
+
+void FMeleeCounters::AddTrace()
+{
+	MeleeCounters::Add(MeleeCounters::Traces);
+	INC_DWORD_STAT(STAT_MeleeTraces);
+	CSV_CUSTOM_STAT(MeleeMaster, Traces, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FMeleeCounters::AddTraceSkipped()
+{
+	MeleeCounters::Add(MeleeCounters::TracesSkipped);
+	INC_DWORD_STAT(STAT_MeleeTracesSkipped);
+}
+
+void FMeleeCounters::AddTraceTargets(int32 InNum)
+{
+	MeleeCounters::Add(MeleeCounters::TraceTargets, InNum);
+}
+
+void FMeleeCounters::AddHit()
+{
+	MeleeCounters::Add(MeleeCounters::Hits);
+	INC_DWORD_STAT(STAT_MeleeHits);
+	CSV_CUSTOM_STAT(MeleeMaster, Hits, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FMeleeCounters::AddBlock()
+{
+	MeleeCounters::Add(MeleeCounters::Blocks);
+	INC_DWORD_STAT(STAT_MeleeBlocks);
+	CSV_CUSTOM_STAT(MeleeMaster, Blocks, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FMeleeCounters::AddParry()
+{
+	MeleeCounters::Add(MeleeCounters::Parries);
+	INC_DWORD_STAT(STAT_MeleeParries);
+	CSV_CUSTOM_STAT(MeleeMaster, Parries, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FMeleeCounters::AddRpc()
+{
+	MeleeCounters::Add(MeleeCounters::Rpcs);
+	INC_DWORD_STAT(STAT_MeleeRpcsSent);
+	CSV_CUSTOM_STAT(MeleeMaster, Rpcs, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FMeleeCounters::AddPhase(EMeleePhase InPhase, uint64 InCycles)
+{
+	static const double nanosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1.0e9;
+
+	MeleeCounters::FThreadBlock& block = MeleeCounters::GetThreadBlock();
+	const int32 phase = static_cast<int32>(InPhase);
+	MeleeCounters::Increment(block.PhaseCycles[phase], InCycles);
+	const int32 bucket = FMeleeHistogram::GetBucket(static_cast<uint64>(InCycles * nanosecondsPerCycle));
+	MeleeCounters::Increment(block.PhaseHistograms[phase][bucket], static_cast<uint64>(1));
+}
+
+const TCHAR* FMeleeCounters::GetPhaseName(EMeleePhase InPhase)
+{
+	switch (InPhase)
+	{
+	case EMeleePhase::HitProcedure: return TEXT("MeleeHitProcedure");
+	case EMeleePhase::ProcessHits: return TEXT("ProcessHits");
+	case EMeleePhase::ProcessWeaponDamage: return TEXT("ProcessWeaponDamage");
+	case EMeleePhase::CanBlockIncomingDamage: return TEXT("CanBlockIncomingDamage");
+	case EMeleePhase::EvaluateCurrentCurve: return TEXT("EvaluateCurrentCurve");
+	case EMeleePhase::ReplicateSubobjects: return TEXT("ReplicateSubobjects");
+	case EMeleePhase::CreateVisuals: return TEXT("CreateVisuals");
+	case EMeleePhase::Rpc: return TEXT("Rpc");
+	default: return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,86 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeHarnessFixture.h"
+
+#include "Components/AdvancedWeaponManager.h"
+#include "Data/WeaponDataAsset.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Subsystems/LoggerLib.h"
+
+UWeaponDataAsset* FMeleeHarnessFixture::LoadWeapon() const
+{
+	return Weapon.IsNull() ? nullptr : Weapon.LoadSynchronous();
+}
+
+bool FMeleeHarnessFixture::SpawnFighters(UWorld* InWorld, int32 InSize,
+	TArray<UAdvancedWeaponManager*>& OutManagers) const
+{
+	UClass* pawnClass = PawnClass.IsNull() ? ACharacter::StaticClass() : PawnClass.LoadSynchronous();
+	if (!pawnClass)
+	{
+		TRACEERROR(LogWeapon, "Invalid harness pawn class '%s'", *PawnClass.ToString());
+		return false;
+	}
+
+	const int32 pairs = InSize / 2;
+	const int32 columns = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(static_cast<float>(pairs))));
+	OutManagers.Reserve(OutManagers.Num() + pairs * 2);
+	for (int32 pair = 0; pair < pairs; ++pair)
+	{
+		const FVector pairOrigin = Origin + FVector((pair / columns) * PairSpacing, (pair % columns) * PairSpacing,
+			0.0f);
+		for (int32 side = 0; side < 2; ++side)
+		{
+			// Opponents face each other, swings hit the other side
+			const FVector location = pairOrigin + FVector(side * PairDistance, 0.0f, 0.0f);
+			const FRotator rotation(0.0f, side == 0 ? 0.0f : 180.0f, 0.0f);
+			FActorSpawnParameters spawnParameters;
+			spawnParameters.SpawnCollisionHandlingOverride =
+				ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+			spawnParameters.ObjectFlags = RF_Transient;
+			APawn* pawn = InWorld->SpawnActor<APawn>(pawnClass, location, rotation, spawnParameters);
+			if (!IsValid(pawn))
+			{
+				TRACEERROR(LogWeapon, "Failed to spawn harness pawn %s", *pawnClass->GetName());
+				return false;
+			}
+
+			// Hits read the player state through the controller
+			if (!pawn->GetController())
+			{
+				pawn->SpawnDefaultController();
+			}
+
+			OutManagers.Add(UAdvancedWeaponManager::FindOrAddForActor(pawn));
+		}
+	}
+	return true;
+}
+
+FString FMeleeHarnessFixture::WriteResults(const TSharedRef<FJsonObject>& InJson, const TCHAR* InDirectory,
+	const FString& InName)
+{
+	FString output;
+	const TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&output);
+	FJsonSerializer::Serialize(InJson, writer);
+
+	const FString path = FPaths::Combine(FPaths::ProfilingDir(), InDirectory,
+		FString::Printf(TEXT("%s_%s.json"), *InName, *FDateTime::Now().ToString()));
+	if (!FFileHelper::SaveStringToFile(output, *path))
+	{
+		TRACEERROR(LogWeapon, "Failed to write melee results to %s", *path);
+	}
+	return path;
+}
+
+bool FMeleeHarnessFixture::DoesSupportWorldType(const EWorldType::Type InWorldType)
+{
+	return InWorldType == EWorldType::Game || InWorldType == EWorldType::PIE;
+}
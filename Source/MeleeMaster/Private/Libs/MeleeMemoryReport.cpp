@@ -0,0 +1,154 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeMemoryReport.h"
+
+#include "MeleeMaster.h"
+#include "EngineUtils.h"
+#include "Actors/WeaponVisual.h"
+#include "Animation/AnimMontage.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Data/WeaponDataAsset.h"
+#include "Data/WeaponHitPathAsset.h"
+#include "Objects/AbstractWeapon.h"
+#include "UObject/UObjectIterator.h"
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdMeleeMemReport(
+	TEXT("melee.Mem.Report"),
+	TEXT("Logs memory of weapon managers, weapons and visuals per pawn and per weapon type."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& InArgs, UWorld* InWorld, FOutputDevice& Ar) {
+			FMeleeMemoryReport::Dump(InWorld, Ar);
+		}));
+
+static double ToKB(SIZE_T InBytes)
+{
+	return InBytes / 1024.0;
+}
+
+void FMeleeMemoryReport::Dump(UWorld* InWorld, FOutputDevice& Ar)
+{
+	if (!InWorld)
+		return;
+
+	struct FTypeEntry
+	{
+		int32 Count{0};
+		SIZE_T WeaponBytes{0};
+		SIZE_T VisualBytes{0};
+	};
+	TMap<FString, FTypeEntry> types;
+	TSet<const UAbstractWeapon*> ownedWeapons;
+	TSet<const AWeaponVisual*> ownedVisuals;
+	TSet<UAnimMontage*> montages;
+	SIZE_T totalBytes = 0;
+	int32 pawnNum = 0;
+
+	Ar.Logf(TEXT("MeleeMaster memory, world %s"), *InWorld->GetName());
+	Ar.Logf(TEXT("%-40s %8s %12s %12s %12s %12s"), TEXT("Pawn"), TEXT("Weapons"), TEXT("Manager KB"),
+		TEXT("Weapons KB"), TEXT("Visuals KB"), TEXT("Total KB"));
+	for (TObjectIterator<UAdvancedWeaponManager> it; it; ++it)
+	{
+		UAdvancedWeaponManager* manager = *it;
+		if (manager->IsTemplate() || manager->GetWorld() != InWorld)
+			continue;
+
+		const SIZE_T managerBytes = manager->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		SIZE_T weaponBytes = 0;
+		SIZE_T visualBytes = 0;
+		const TArray<UAbstractWeapon*> weapons = manager->GetWeaponList();
+		for (UAbstractWeapon* weapon : weapons)
+		{
+			if (!IsValid(weapon))
+				continue;
+
+			ownedWeapons.Add(weapon);
+			const SIZE_T bytes = weapon->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+			SIZE_T weaponVisualBytes = 0;
+			TArray<AWeaponVisual*> visuals;
+			weapon->GetVisual(visuals);
+			for (AWeaponVisual* visual : visuals)
+			{
+				bool bAlreadyCounted = false;
+				ownedVisuals.Add(visual, &bAlreadyCounted);
+				if (IsValid(visual) && !bAlreadyCounted)
+				{
+					weaponVisualBytes += visual->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+				}
+			}
+
+			FTypeEntry& type = types.FindOrAdd(GetNameSafe(weapon->GetData()));
+			++type.Count;
+			type.WeaponBytes += bytes;
+			type.VisualBytes += weaponVisualBytes;
+			weaponBytes += bytes;
+			visualBytes += weaponVisualBytes;
+		}
+
+		for (const TPair<FSoftObjectPath, UAnimMontage*>& pair : manager->GetMontageCache())
+		{
+			if (pair.Value)
+			{
+				montages.Add(pair.Value);
+			}
+		}
+
+		const SIZE_T pawnBytes = managerBytes + weaponBytes + visualBytes;
+		totalBytes += pawnBytes;
+		++pawnNum;
+		Ar.Logf(TEXT("%-40s %8d %12.1f %12.1f %12.1f %12.1f"), *GetNameSafe(manager->GetOwner()), weapons.Num(),
+			ToKB(managerBytes), ToKB(weaponBytes), ToKB(visualBytes), ToKB(pawnBytes));
+	}
+
+	Ar.Logf(TEXT("%-40s %8s %12s %12s"), TEXT("Weapon type"), TEXT("Count"), TEXT("Weapons KB"), TEXT("Visuals KB"));
+	for (const TPair<FString, FTypeEntry>& pair : types)
+	{
+		Ar.Logf(TEXT("%-40s %8d %12.1f %12.1f"), *pair.Key, pair.Value.Count, ToKB(pair.Value.WeaponBytes),
+			ToKB(pair.Value.VisualBytes));
+	}
+
+	// Shared assets are counted once
+	SIZE_T montageBytes = 0;
+	for (UAnimMontage* montage : montages)
+	{
+		montageBytes += montage->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	int32 hitPathNum = 0;
+	SIZE_T hitPathBytes = 0;
+	for (TObjectIterator<UWeaponHitPathAsset> it; it; ++it)
+	{
+		if (it->IsTemplate())
+			continue;
+
+		++hitPathNum;
+		hitPathBytes += it->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	Ar.Logf(TEXT("Cached montages: %d, %.1f KB"), montages.Num(), ToKB(montageBytes));
+	Ar.Logf(TEXT("Loaded hit paths: %d, %.1f KB"), hitPathNum, ToKB(hitPathBytes));
+
+	// Not referenced by managers: removed weapons waiting for GC, leaks, pooled visuals
+	int32 orphanWeaponNum = 0;
+	SIZE_T orphanWeaponBytes = 0;
+	for (TObjectIterator<UAbstractWeapon> it; it; ++it)
+	{
+		if (it->IsTemplate() || it->GetWorld() != InWorld || ownedWeapons.Contains(*it))
+			continue;
+
+		++orphanWeaponNum;
+		orphanWeaponBytes += it->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+	int32 freeVisualNum = 0;
+	SIZE_T freeVisualBytes = 0;
+	for (TActorIterator<AWeaponVisual> it(InWorld); it; ++it)
+	{
+		if (ownedVisuals.Contains(*it))
+			continue;
+
+		++freeVisualNum;
+		freeVisualBytes += it->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	Ar.Logf(TEXT("Weapons without manager: %d, %.1f KB"), orphanWeaponNum, ToKB(orphanWeaponBytes));
+	Ar.Logf(TEXT("Visuals without weapon (pooled or leaked): %d, %.1f KB"), freeVisualNum, ToKB(freeVisualBytes));
+	Ar.Logf(TEXT("Total: %d pawns, %.1f KB owned, %.1f KB shared"), pawnNum,
+		ToKB(totalBytes + orphanWeaponBytes + freeVisualBytes), ToKB(montageBytes + hitPathBytes));
+}
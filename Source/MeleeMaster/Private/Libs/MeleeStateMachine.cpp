@@ -0,0 +1,172 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeStateMachine.h"
+
+#include "Components/AdvancedWeaponManager.h"
+#include "Engine/World.h"
+#include "Subsystems/LoggerLib.h"
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<bool> CVarMeleeValidateStateMachine(
+	TEXT("melee.Validate.StateMachine"),
+	false,
+	TEXT("Checks every weapon manager status change against the allowed transitions and logs invalid ones."));
+#endif
+
+FOnMeleeStateTransition FMeleeStateMachine::OnTransition;
+
+namespace MeleeStateMachine
+{
+	static int32 ViolationNum = 0;
+
+	template <typename TEnum>
+	constexpr uint32 Bit(TEnum InStatus)
+	{
+		return 1u << static_cast<uint32>(InStatus);
+	}
+}
+
+bool FMeleeStateMachine::IsValidTransition(EWeaponFightingStatus InFrom, EWeaponFightingStatus InTo)
+{
+	using namespace MeleeStateMachine;
+
+	// Cancels, finished cooldowns and missing weapon drop to Idle from anywhere, StopWork sets Busy from anywhere
+	if (InFrom == InTo || InTo == EWeaponFightingStatus::Idle || InTo == EWeaponFightingStatus::Busy)
+		return true;
+
+	uint32 allowed = 0;
+	switch (InFrom)
+	{
+		case EWeaponFightingStatus::Idle:
+			allowed = Bit(EWeaponFightingStatus::PreAttack)
+				| Bit(EWeaponFightingStatus::BlockCharging);
+			break;
+		case EWeaponFightingStatus::PreAttack:
+			allowed = Bit(EWeaponFightingStatus::AttackCharging)
+				| Bit(EWeaponFightingStatus::RangeCharging);
+			break;
+		case EWeaponFightingStatus::AttackCharging:
+			allowed = Bit(EWeaponFightingStatus::Attacking)
+				| Bit(EWeaponFightingStatus::BlockCharging);
+			break;
+		case EWeaponFightingStatus::RangeCharging:
+			allowed = Bit(EWeaponFightingStatus::Attacking)
+				| Bit(EWeaponFightingStatus::BlockCharging);
+			break;
+		case EWeaponFightingStatus::BlockCharging:
+			// Parry turns the block into a charged attack
+			allowed = Bit(EWeaponFightingStatus::PostBlock)
+				| Bit(EWeaponFightingStatus::AttackCharging)
+				| Bit(EWeaponFightingStatus::BlockStunned);
+			break;
+		case EWeaponFightingStatus::Attacking:
+			allowed = Bit(EWeaponFightingStatus::PostAttack)
+				| Bit(EWeaponFightingStatus::ParryStunned)
+				| Bit(EWeaponFightingStatus::AttackStunned);
+			break;
+		default:
+			// Cooldowns and stuns only finish
+			break;
+	}
+	return (allowed & Bit(InTo)) != 0;
+}
+
+bool FMeleeStateMachine::IsValidTransition(EWeaponManagingStatus InFrom, EWeaponManagingStatus InTo)
+{
+	using namespace MeleeStateMachine;
+
+	// StopWork sets Busy from anywhere
+	if (InFrom == InTo || InTo == EWeaponManagingStatus::Busy)
+		return true;
+
+	uint32 allowed = 0;
+	switch (InFrom)
+	{
+		case EWeaponManagingStatus::Idle:
+			allowed = Bit(EWeaponManagingStatus::Equipping)
+				| Bit(EWeaponManagingStatus::DeEquipping)
+				| Bit(EWeaponManagingStatus::ShieldGetting)
+				| Bit(EWeaponManagingStatus::ShieldRemoving);
+			break;
+		case EWeaponManagingStatus::NoWeapon:
+			allowed = Bit(EWeaponManagingStatus::Equipping);
+			break;
+		case EWeaponManagingStatus::DeEquipping:
+			allowed = Bit(EWeaponManagingStatus::NoWeapon);
+			break;
+		case EWeaponManagingStatus::Equipping:
+		case EWeaponManagingStatus::Busy:
+		case EWeaponManagingStatus::ShieldGetting:
+		case EWeaponManagingStatus::ShieldRemoving:
+			allowed = Bit(EWeaponManagingStatus::Idle);
+			break;
+		default:
+			break;
+	}
+	return (allowed & Bit(InTo)) != 0;
+}
+
+#if !UE_BUILD_SHIPPING
+bool FMeleeStateMachine::IsNotifyEnabled_Internal()
+{
+	return OnTransition.IsBound() || CVarMeleeValidateStateMachine.GetValueOnGameThread();
+}
+
+void FMeleeStateMachine::NotifyTransition(UAdvancedWeaponManager* InManager, EWeaponFightingStatus InFrom,
+	EWeaponFightingStatus InTo)
+{
+	if (!IsNotifyEnabled_Internal())
+		return;
+
+	FMeleeStateTransition transition;
+	transition.From = static_cast<uint8>(InFrom);
+	transition.To = static_cast<uint8>(InTo);
+	transition.bValid = IsValidTransition(InFrom, InTo);
+	Notify_Internal(InManager, transition);
+}
+
+void FMeleeStateMachine::NotifyTransition(UAdvancedWeaponManager* InManager, EWeaponManagingStatus InFrom,
+	EWeaponManagingStatus InTo)
+{
+	if (!IsNotifyEnabled_Internal())
+		return;
+
+	FMeleeStateTransition transition;
+	transition.bManaging = true;
+	transition.From = static_cast<uint8>(InFrom);
+	transition.To = static_cast<uint8>(InTo);
+	transition.bValid = IsValidTransition(InFrom, InTo);
+	Notify_Internal(InManager, transition);
+}
+
+void FMeleeStateMachine::Notify_Internal(UAdvancedWeaponManager* InManager, FMeleeStateTransition& InTransition)
+{
+	const UWorld* world = InManager->GetWorld();
+	InTransition.Time = world ? world->GetTimeSeconds() : 0.0;
+	// Listeners check bValid themselves, the CVar only silences the log
+	if (!InTransition.bValid && CVarMeleeValidateStateMachine.GetValueOnGameThread())
+	{
+		++MeleeStateMachine::ViolationNum;
+		TRACEWARN(LogWeapon, "%s: invalid %s transition %s -> %s",
+			*GetNameSafe(InManager->GetOwner()),
+			InTransition.bManaging ? TEXT("managing") : TEXT("fighting"),
+			*GetStatusName(InTransition, false),
+			*GetStatusName(InTransition, true));
+	}
+	OnTransition.Broadcast(InManager, InTransition);
+}
+#endif
+
+int32 FMeleeStateMachine::GetViolationNum()
+{
+	return MeleeStateMachine::ViolationNum;
+}
+
+FString FMeleeStateMachine::GetStatusName(const FMeleeStateTransition& InTransition, bool bInTo)
+{
+	const uint8 status = bInTo ? InTransition.To : InTransition.From;
+	return InTransition.bManaging
+		? UEnum::GetDisplayValueAsText(static_cast<EWeaponManagingStatus>(status)).ToString()
+		: UEnum::GetDisplayValueAsText(static_cast<EWeaponFightingStatus>(status)).ToString();
+}
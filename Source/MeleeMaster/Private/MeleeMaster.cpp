@@ -4,6 +4,37 @@
 
 DEFINE_LOG_CATEGORY(LogWeapon);
 
+DEFINE_STAT(STAT_MeleeReplicateSubobjects);
+DEFINE_STAT(STAT_MeleeSubobjectsReplicated);
+DEFINE_STAT(STAT_MeleeProjectileTick);
+DEFINE_STAT(STAT_MeleeProjectilesInFlight);
+DEFINE_STAT(STAT_MeleeProjectilesLaunched);
+DEFINE_STAT(STAT_MeleeCacheMontages);
+DEFINE_STAT(STAT_MeleeTrailTick);
+DEFINE_STAT(STAT_MeleeTrailsActive);
+DEFINE_STAT(STAT_MeleeHitProcedure);
+DEFINE_STAT(STAT_MeleeProcessHits);
+DEFINE_STAT(STAT_MeleeProcessWeaponDamage);
+DEFINE_STAT(STAT_MeleeCanBlockIncomingDamage);
+DEFINE_STAT(STAT_MeleeEvaluateCurrentCurve);
+DEFINE_STAT(STAT_MeleeCreateVisuals);
+DEFINE_STAT(STAT_MeleeRpc);
+DEFINE_STAT(STAT_MeleeTraces);
+DEFINE_STAT(STAT_MeleeTracesSkipped);
+DEFINE_STAT(STAT_MeleeHits);
+DEFINE_STAT(STAT_MeleeBlocks);
+DEFINE_STAT(STAT_MeleeParries);
+DEFINE_STAT(STAT_MeleeRpcsSent);
+DEFINE_STAT(STAT_MeleeRpcsReceived);
+DEFINE_STAT(STAT_MeleeRpcsDropped);
+DEFINE_STAT(STAT_MeleeRpcsCoalesced);
+
+CSV_DEFINE_CATEGORY_MODULE(MELEEMASTER_API, MeleeMaster, true);
+
+LLM_DEFINE_TAG(MeleeMaster);
+
+UE_TRACE_CHANNEL_DEFINE(MeleeMasterChannel);
+
 #define LOCTEXT_NAMESPACE "FMeleeMasterModule"
 
 
@@ -4,6 +4,7 @@
 #include "Objects/AbstractWeapon.h"
 
 #include "Actors/WeaponVisual.h"
+#include "Components/AdvancedWeaponManager.h"
 #include "Data/WeaponDataAsset.h"
 #include "Net/UnrealNetwork.h"
 #include "Net/Core/PushModel/PushModel.h"
@@ -18,14 +19,22 @@ UAbstractWeapon::UAbstractWeapon(const FObjectInitializer& ObjectInitializer) :
 
 void UAbstractWeapon::OnRep_Data()
 {
+	if (WeaponManagerOwner.IsValid())
+	{
+		WeaponManagerOwner->NotifyWeaponDataReplicated(this);
+	}
 }
 
 void UAbstractWeapon::OnRep_Visuals()
 {
 }
 
-void UAbstractWeapon::OnRep_Guid()
+void UAbstractWeapon::OnRep_Handle()
 {
+	if (WeaponManagerOwner.IsValid())
+	{
+		WeaponManagerOwner->NotifyWeaponHandleReplicated(this);
+	}
 }
 
 void UAbstractWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -35,7 +44,7 @@ void UAbstractWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutL
 	Params.bIsPushBased = true;
 	DOREPLIFETIME_WITH_PARAMS_FAST(UAbstractWeapon, Data, Params);
 	DOREPLIFETIME_WITH_PARAMS_FAST(UAbstractWeapon, Visuals, Params);
-	DOREPLIFETIME_WITH_PARAMS_FAST(UAbstractWeapon, Guid, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UAbstractWeapon, Handle, Params);
 }
 
 bool UAbstractWeapon::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
@@ -43,6 +52,13 @@ bool UAbstractWeapon::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bun
 	return Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
 }
 
+void UAbstractWeapon::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Guid.GetAllocatedSize() + Visuals.GetAllocatedSize()
+		+ LocalVisuals.GetAllocatedSize());
+}
+
 float UAbstractWeapon::GetTotalDamagePerDirection(EWeaponDirection WeaponDirection) const
 {
 	return 0.0f;
@@ -98,7 +114,12 @@ bool UAbstractWeapon::IsBlockDirected() const
 void UAbstractWeapon::SetGuidString(FString InGuid)
 {
 	this->Guid = InGuid;
-	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Guid, this);
+}
+
+void UAbstractWeapon::SetHandle(FWeaponHandle InHandle)
+{
+	this->Handle = InHandle;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Handle, this);
 }
 
 FString UAbstractWeapon::MakeRandomGuidString()
@@ -117,23 +138,38 @@ void UAbstractWeapon::SetData(UWeaponDataAsset* InData)
 	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Data, this);
 }
 
+void UAbstractWeapon::MarkVisualsDirty()
+{
+	// Local actors can't be referenced over network
+	if (bLocalVisuals)
+		return;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Visuals, this);
+}
+
 void UAbstractWeapon::SetVisual(const TArray<AWeaponVisual*>& InVisuals)
 {
 	this->Visuals = InVisuals;
-	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Visuals, this);
+	MarkVisualsDirty();
+}
+
+void UAbstractWeapon::SetLocalVisual(const TArray<AWeaponVisual*>& InVisuals)
+{
+	this->bLocalVisuals = true;
+	this->LocalVisuals = InVisuals;
 }
 
 void UAbstractWeapon::ClearVisual()
 {
-	this->Visuals.Empty();
-	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Visuals, this);
+	GetVisualArray_Internal().Empty();
+	MarkVisualsDirty();
 }
 
 void UAbstractWeapon::DestroyVisuals()
 {
-	if (this->Visuals.Num() > 0)
+	for (AWeaponVisual* el : GetVisualArray_Internal())
 	{
-		for (AWeaponVisual* el : Visuals)
+		if (IsValid(el))
 		{
 			el->Destroy();
 		}
@@ -143,24 +179,26 @@ void UAbstractWeapon::DestroyVisuals()
 
 void UAbstractWeapon::SetVisualActor(int32 InIndex, AWeaponVisual* InVisual)
 {
-	if (Visuals.IsValidIndex(InIndex))
+	TArray<AWeaponVisual*>& visuals = GetVisualArray_Internal();
+	if (visuals.IsValidIndex(InIndex))
 	{
-		Visuals[InIndex] = InVisual;
+		visuals[InIndex] = InVisual;
 	}
 	else
 	{
-		Visuals.Add(InVisual);
+		visuals.Add(InVisual);
 	}
-	MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Visuals, this);
+	MarkVisualsDirty();
 }
 
 AWeaponVisual* UAbstractWeapon::RemoveVisualActor(int32 Index)
 {
-	if (Visuals.IsValidIndex(Index))
+	TArray<AWeaponVisual*>& visuals = GetVisualArray_Internal();
+	if (visuals.IsValidIndex(Index))
 	{
-		AWeaponVisual* res = Visuals[Index];
-		Visuals.RemoveAt(Index);
-		MARK_PROPERTY_DIRTY_FROM_NAME(UAbstractWeapon, Visuals, this);
+		AWeaponVisual* res = visuals[Index];
+		visuals.RemoveAt(Index);
+		MarkVisualsDirty();
 		return res;
 	}
 	return nullptr;
@@ -168,15 +206,16 @@ AWeaponVisual* UAbstractWeapon::RemoveVisualActor(int32 Index)
 
 void UAbstractWeapon::GetVisual(TArray<AWeaponVisual*>& OutVisual) const
 {
-	OutVisual = this->Visuals;
+	OutVisual = GetVisualArray_Internal();
 }
 
 bool UAbstractWeapon::GetVisualActor(int32 Index, AWeaponVisual*& OutVisual) const
 {
 	OutVisual = nullptr;
-	if (Visuals.IsValidIndex(Index))
+	const TArray<AWeaponVisual*>& visuals = GetVisualArray_Internal();
+	if (visuals.IsValidIndex(Index))
 	{
-		OutVisual = Visuals[Index];
+		OutVisual = visuals[Index];
 		return IsValid(OutVisual);
 	}
 	return false;
@@ -184,14 +223,7 @@ bool UAbstractWeapon::GetVisualActor(int32 Index, AWeaponVisual*& OutVisual) con
 
 int32 UAbstractWeapon::GetVisualIndex(const AWeaponVisual* InVisual) const
 {
-	for (int32 i = 0; i < Visuals.Num(); ++i)
-	{
-		if (Visuals[i] == InVisual)
-		{
-			return i;
-		}
-	}
-	return INDEX_NONE;
+	return GetVisualArray_Internal().IndexOfByKey(InVisual);
 }
 
 void UAbstractWeapon::SetWeaponManager(const TWeakObjectPtr<UAdvancedWeaponManager>& InValue)
@@ -5,9 +5,32 @@
 
 #include "MeleeMaster.h"
 #include "Actors/ArrowVisual.h"
+#include "Components/AdvancedWeaponManager.h"
 #include "Data/RangeWeaponDataAsset.h"
 #include "Data/WeaponDataAsset.h"
+#include "Data/Interfaces/DamageableEntity.h"
+#include "Data/Interfaces/DamageManagerInterface.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
 #include "Subsystems/LoggerLib.h"
+#include "Subsystems/ProjectileSubsystem.h"
+#include "Subsystems/VisualPoolSubsystem.h"
+#include "UObject/CoreNet.h"
+
+void FArrowLaunchRecord::Quantize()
+{
+	FNetBitWriter writer(nullptr, 256);
+	bool bSuccess = true;
+	Origin.NetSerialize(writer, nullptr, bSuccess);
+	Direction.NetSerialize(writer, nullptr, bSuccess);
+
+	FNetBitReader reader(nullptr, writer.GetData(), writer.GetNumBits());
+	Origin.NetSerialize(reader, nullptr, bSuccess);
+	Direction.NetSerialize(reader, nullptr, bSuccess);
+}
 
 ULongRangeWeapon::ULongRangeWeapon(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer),
 	LocalArrowVisual(nullptr)
@@ -32,7 +55,15 @@ void ULongRangeWeapon::ObjectEndPlay()
 {
 	if (IsValid(LocalArrowVisual))
 	{
-		LocalArrowVisual->Destroy();
+		if (UVisualPoolSubsystem* pool = UVisualPoolSubsystem::Get(LocalArrowVisual))
+		{
+			pool->Release(LocalArrowVisual);
+		}
+		else
+		{
+			LocalArrowVisual->Destroy();
+		}
+		LocalArrowVisual = nullptr;
 	}
 	Super::ObjectEndPlay();
 }
@@ -44,16 +75,31 @@ void ULongRangeWeapon::ShowOrCreateArrowVisual(USkeletalMeshComponent* ParentCom
 		UWorld* world = ParentComponent->GetWorld();
 		const FVector loc = ParentComponent->GetComponentLocation();
 		const FRotator rot = FRotator::ZeroRotator;
-		FActorSpawnParameters spawnParams;
-		spawnParams.Owner = ParentComponent->GetOwner();
-		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 		URangeWeaponDataAsset* rangeData = GetRangeData();
 		if (!rangeData)
 		{
 			TRACEERROR(LogWeapon, "Invalid data for ULongRangeWeapon. Must be 'URangeWeaponDataAsset'");
 			return;
 		}
-		LocalArrowVisual = world->SpawnActor<AArrowVisual>(rangeData->Arrow.VisualActorClass, loc, rot, spawnParams);
+		if (UVisualPoolSubsystem* pool = world->GetSubsystem<UVisualPoolSubsystem>())
+		{
+			AActor* pooledActor = pool->Acquire(rangeData->Arrow.VisualActorClass.Get(), FTransform(rot, loc),
+				ParentComponent->GetOwner());
+			LocalArrowVisual = Cast<AArrowVisual>(pooledActor);
+			if (pooledActor && !LocalArrowVisual)
+			{
+				TRACEERROR(LogWeapon, "Arrow visual class '%s' must be 'AArrowVisual'",
+					*pooledActor->GetClass()->GetFName().ToString());
+				pool->Release(pooledActor);
+			}
+		}
+		else
+		{
+			FActorSpawnParameters spawnParams;
+			spawnParams.Owner = ParentComponent->GetOwner();
+			spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			LocalArrowVisual = world->SpawnActor<AArrowVisual>(rangeData->Arrow.VisualActorClass, loc, rot, spawnParams);
+		}
 		if (IsValid(LocalArrowVisual))
 		{
 			const ENetRole role = ParentComponent->GetOwner()->GetLocalRole();
@@ -94,9 +140,154 @@ void ULongRangeWeapon::GetArrowLocRot_Implementation(FVector& OutLoc, FRotator&
 {
 	OutLoc = FVector::ZeroVector;
 	OutRot = FRotator::ZeroRotator;
+	if (AActor* owner = GetTypedOuter<AActor>())
+	{
+		owner->GetActorEyesViewPoint(OutLoc, OutRot);
+	}
 }
 
 void ULongRangeWeapon::FireArrow_Implementation(float Power)
 {
-	// IMPLEMENT
+	const FArrowLaunchRecord record = MakeArrowLaunchRecord(Power);
+	LaunchArrowFromRecord(record, true);
+
+	// Clients simulate their own copy, nothing else is replicated for the arrow
+	if (WeaponManagerOwner.IsValid())
+	{
+		WeaponManagerOwner->NotifyArrowLaunched(GetHandle(), record);
+	}
+}
+
+FArrowLaunchRecord ULongRangeWeapon::MakeArrowLaunchRecord(float Power)
+{
+	FVector loc;
+	FRotator rot;
+	GetArrowLocRot(loc, rot);
+
+	FArrowLaunchRecord record;
+	record.Origin = loc;
+	record.Direction = rot.Vector();
+	record.Power = FArrowLaunchRecord::QuantizePower(Power);
+	record.Seed = static_cast<uint16>(FMath::Rand() & 0xFFFF);
+	if (AActor* owner = GetTypedOuter<AActor>())
+	{
+		if (AGameStateBase* gs = owner->GetWorld()->GetGameState())
+		{
+			record.ServerTime = gs->GetServerWorldTimeSeconds();
+		}
+	}
+	record.Quantize();
+	return record;
+}
+
+void ULongRangeWeapon::LaunchArrowFromRecord(const FArrowLaunchRecord& InRecord, bool bAuthority)
+{
+	URangeWeaponDataAsset* rangeData = GetRangeData();
+	if (!IsValid(rangeData))
+	{
+		TRACEERROR(LogWeapon, "Invalid data for ULongRangeWeapon. Must be 'URangeWeaponDataAsset'");
+		return;
+	}
+
+	AActor* owner = GetTypedOuter<AActor>();
+	UProjectileSubsystem* projectiles = UProjectileSubsystem::Get(owner);
+	if (!IsValid(owner) || !projectiles)
+		return;
+
+	const float power = InRecord.GetPower();
+	const float speed = FMath::Lerp(rangeData->MinArrowSpeed, rangeData->MaxArrowSpeed, power);
+
+	FVector direction = InRecord.Direction;
+	if (rangeData->ArrowSpread > 0.0f)
+	{
+		const FRandomStream stream(InRecord.Seed);
+		direction = stream.VRandCone(direction, FMath::DegreesToRadians(rangeData->ArrowSpread));
+	}
+
+	FProjectileLaunchParams params;
+	params.Origin = InRecord.Origin;
+	params.Velocity = direction * speed;
+	params.Gravity = rangeData->ArrowGravity;
+	params.Drag = rangeData->ArrowDrag;
+	params.Radius = rangeData->ArrowRadius;
+	params.LifeTime = rangeData->ArrowLifeTime;
+	params.StuckLifeTime = rangeData->StuckArrowLifeTime;
+	params.TraceChannel = UEngineTypes::ConvertToCollisionChannel(rangeData->ArrowTraceQuery);
+	params.Damage = rangeData->BasicDamage * power;
+	params.Causer = owner;
+	params.VisualClass = rangeData->ProjectileVisualClass
+		? rangeData->ProjectileVisualClass
+		: rangeData->Arrow.VisualActorClass;
+	if (bAuthority)
+	{
+		params.RewindTime = GetArrowRewindTime();
+		params.OnImpact.BindUObject(this, &ULongRangeWeapon::OnArrowImpact);
+	}
+	else if (AGameStateBase* gs = owner->GetWorld()->GetGameState())
+	{
+		// Cosmetic copy: still sweeps to stick the visual, catches up with the server shot
+		params.FastForwardTime = FMath::Clamp(
+			static_cast<float>(gs->GetServerWorldTimeSeconds() - InRecord.ServerTime), 0.0f, 0.5f);
+	}
+	projectiles->Launch(params);
+}
+
+float ULongRangeWeapon::GetArrowRewindTime() const
+{
+	URangeWeaponDataAsset* rangeData = GetRangeData();
+	if (!IsValid(rangeData) || !rangeData->bArrowLagCompensation)
+		return 0.0f;
+
+	const APawn* pawn = GetTypedOuter<APawn>();
+	if (!pawn)
+		return 0.0f;
+
+	const APlayerState* ps = pawn->GetPlayerState();
+	// Bots and the listen server host see the present
+	if (!ps || pawn->IsLocallyControlled())
+		return 0.0f;
+
+	// Shooter sees targets half a round trip in the past
+	const float oneWay = ps->ExactPing * 0.001f * 0.5f;
+	return FMath::Clamp(oneWay, 0.0f, rangeData->MaxArrowRewindTime);
+}
+
+void ULongRangeWeapon::OnArrowImpact(const FProjectileImpact& InImpact)
+{
+	AActor* hitActor = InImpact.Hit.GetActor();
+	AActor* causer = InImpact.Causer.Get();
+	if (!IsValid(hitActor) || !IsValid(causer) || hitActor == causer)
+		return;
+
+	if (!causer->HasAuthority())
+		return;
+
+	if (hitActor->Implements<UDamageableEntity>() && !IDamageableEntity::Execute_IsAlive(hitActor))
+		return;
+
+	URangeWeaponDataAsset* rangeData = GetRangeData();
+	const TSubclassOf<UDamageType> damageType = rangeData ? rangeData->ArrowDamageType : nullptr;
+
+	EDamageReturn dmgReturn;
+	float totalDmg;
+	if (UAdvancedWeaponManager* victimManager = UAdvancedWeaponManager::FindForActor(hitActor))
+	{
+		victimManager->ProcessProjectileDamage(causer, InImpact.Damage, InImpact.Hit, damageType,
+			dmgReturn, totalDmg);
+		return;
+	}
+
+	if (!hitActor->Implements<UDamageableEntity>())
+		return;
+
+	AGameModeBase* gm = causer->GetWorld()->GetAuthGameMode();
+	if (!IsValid(gm) || !gm->Implements<UDamageManager>())
+	{
+		TRACEERROR(LogWeapon, "Gamemode must implement UDamageManager!");
+		return;
+	}
+	const APawn* pawn = Cast<APawn>(causer);
+	APlayerState* ps = pawn ? pawn->GetPlayerState() : nullptr;
+	IDamageManager::Execute_RequestDamage(gm, causer, ps, hitActor, InImpact.Damage, InImpact.Hit, damageType,
+		dmgReturn, totalDmg);
 }
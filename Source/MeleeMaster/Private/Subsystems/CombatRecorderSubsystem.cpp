@@ -0,0 +1,554 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/CombatRecorderSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Data/WeaponDataAsset.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Objects/AbstractWeapon.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Subsystems/LoggerLib.h"
+
+static FAutoConsoleCommandWithWorld CmdMeleeRecordStart(
+	TEXT("melee.Record.Start"),
+	TEXT("Starts recording server input of weapon managers."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* InWorld) {
+		if (UCombatRecorderSubsystem* recorder = UCombatRecorderSubsystem::Get(InWorld))
+		{
+			recorder->StartRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMeleeRecordStop(
+	TEXT("melee.Record.Stop"),
+	TEXT("melee.Record.Stop [Name] - stops recording, writes Saved/Profiling/MeleeRecords/Name.mmrec."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld) {
+		if (UCombatRecorderSubsystem* recorder = UCombatRecorderSubsystem::Get(InWorld))
+		{
+			recorder->StopRecording(InArgs.Num() > 0 ? InArgs[0] : FDateTime::Now().ToString());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMeleeRecordReplay(
+	TEXT("melee.Record.Replay"),
+	TEXT("melee.Record.Replay Name - replays the log, writes Saved/Profiling/MeleeReplay report."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld) {
+		UCombatRecorderSubsystem* recorder = UCombatRecorderSubsystem::Get(InWorld);
+		if (!recorder || InArgs.Num() == 0)
+			return;
+
+		recorder->StartReplay(InArgs[0]);
+	}));
+
+FArchive& operator<<(FArchive& Ar, FCombatRecordActor& InActor)
+{
+	Ar << InActor.ClassPath;
+	Ar << InActor.Transform;
+	Ar << InActor.Weapons;
+	Ar << InActor.CurrentWeaponIndex;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FCombatRecordInput& InInput)
+{
+	Ar << InInput.Time;
+	Ar << InInput.Actor;
+	Ar << InInput.Command.Type;
+	// Weapon indices are small
+	int8 index = static_cast<int8>(InInput.Command.Index);
+	Ar << index;
+	InInput.Command.Index = index;
+	Ar << InInput.Command.Direction;
+	Ar << InInput.Location;
+	Ar << InInput.Yaw;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FCombatRecordOutcome& InOutcome)
+{
+	Ar << InOutcome.Time;
+	Ar << InOutcome.Causer;
+	Ar << InOutcome.Victim;
+	Ar << InOutcome.Result;
+	Ar << InOutcome.Damage;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FCombatRecord& InRecord)
+{
+	uint32 magic = FCombatRecord::Magic;
+	uint32 version = FCombatRecord::Version;
+	Ar << magic;
+	Ar << version;
+	if (Ar.IsLoading() && (magic != FCombatRecord::Magic || version != FCombatRecord::Version))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << InRecord.Duration;
+	Ar << InRecord.Frames;
+	Ar << InRecord.FrameMs;
+	Ar << InRecord.PhaseMs;
+	Ar << InRecord.Actors;
+	Ar << InRecord.Inputs;
+	Ar << InRecord.Outcomes;
+	return Ar;
+}
+
+static TSharedRef<FJsonObject> MakeOutcomeJson(const FCombatRecordOutcome& InOutcome)
+{
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("time"), InOutcome.Time);
+	json->SetNumberField(TEXT("causer"), InOutcome.Causer);
+	json->SetNumberField(TEXT("victim"), InOutcome.Victim);
+	json->SetStringField(TEXT("result"), UEnum::GetValueAsString(InOutcome.Result));
+	json->SetNumberField(TEXT("damage"), InOutcome.Damage);
+	return json;
+}
+
+bool UCombatRecorderSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatRecorderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	DamageDealtHandle = UAdvancedWeaponManager::OnDamageDealt.AddUObject(this,
+		&UCombatRecorderSubsystem::RecordOutcome);
+}
+
+void UCombatRecorderSubsystem::Deinitialize()
+{
+	UAdvancedWeaponManager::OnDamageDealt.Remove(DamageDealtHandle);
+	Mode = ECombatRecorderMode::None;
+	ActorIds.Empty();
+	ReplayActors.Empty();
+	Super::Deinitialize();
+}
+
+TStatId UCombatRecorderSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatRecorderSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UCombatRecorderSubsystem::IsTickable() const
+{
+	return Mode != ECombatRecorderMode::None;
+}
+
+UCombatRecorderSubsystem* UCombatRecorderSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UCombatRecorderSubsystem>();
+	}
+	return nullptr;
+}
+
+FString UCombatRecorderSubsystem::GetRecordPath(const FString& InName)
+{
+	if (FPaths::FileExists(InName))
+		return InName;
+
+	return FPaths::Combine(FPaths::ProfilingDir(), TEXT("MeleeRecords"), InName + TEXT(".mmrec"));
+}
+
+float UCombatRecorderSubsystem::GetRecordTime() const
+{
+	return static_cast<float>(GetWorld()->GetTimeSeconds() - StartTime);
+}
+
+void UCombatRecorderSubsystem::ResetSampling()
+{
+	StartCounters = FMeleeCounters::Get();
+	FrameMsSum = 0.0;
+	Frames = 0;
+}
+
+void UCombatRecorderSubsystem::FinishSampling(FCombatRecord& OutRecord) const
+{
+	const FMeleeCounters& counters = FMeleeCounters::Get();
+	const double msPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+
+	OutRecord.Frames = Frames;
+	OutRecord.FrameMs = Frames > 0 ? FrameMsSum / Frames : 0.0f;
+	OutRecord.PhaseMs.SetNum(static_cast<int32>(EMeleePhase::Num));
+	for (int32 i = 0; i < OutRecord.PhaseMs.Num(); ++i)
+	{
+		OutRecord.PhaseMs[i] = (counters.PhaseCycles[i] - StartCounters.PhaseCycles[i]) * msPerCycle;
+	}
+}
+
+void UCombatRecorderSubsystem::Tick(float DeltaTime)
+{
+	FrameMsSum += FApp::GetDeltaTime() * 1000.0;
+	++Frames;
+
+	if (Mode != ECombatRecorderMode::Replaying)
+		return;
+
+	const float time = GetRecordTime();
+	if (!bReplayStarted)
+	{
+		if (time < ReplayWarmupTime)
+			return;
+
+		// Recorded time starts now
+		bReplayStarted = true;
+		StartTime = GetWorld()->GetTimeSeconds();
+		ResetSampling();
+		return;
+	}
+
+	for (; NextInput < Record.Inputs.Num() && Record.Inputs[NextInput].Time <= time; ++NextInput)
+	{
+		const FCombatRecordInput& input = Record.Inputs[NextInput];
+		AActor* actor = ReplayActors.IsValidIndex(input.Actor) ? ReplayActors[input.Actor].Get() : nullptr;
+		UAdvancedWeaponManager* manager = UAdvancedWeaponManager::FindForActor(actor);
+		if (!manager)
+			continue;
+
+		actor->SetActorLocationAndRotation(FVector(input.Location), FRotator(0.0f, input.Yaw, 0.0f), false, nullptr,
+			ETeleportType::TeleportPhysics);
+		manager->ExecuteInput(input.Command);
+	}
+
+	if (time >= Record.Duration)
+	{
+		FinishReplay();
+	}
+}
+
+uint16 UCombatRecorderSubsystem::GetActorId(AActor* InActor)
+{
+	if (const uint16* id = ActorIds.Find(InActor))
+		return *id;
+
+	const uint16 id = static_cast<uint16>(Record.Actors.Num());
+	ActorIds.Add(InActor, id);
+
+	FCombatRecordActor& recordActor = Record.Actors.AddDefaulted_GetRef();
+	recordActor.ClassPath = InActor->GetClass()->GetPathName();
+	recordActor.Transform = InActor->GetActorTransform();
+	if (UAdvancedWeaponManager* manager = UAdvancedWeaponManager::FindForActor(InActor))
+	{
+		for (const UAbstractWeapon* weapon : manager->GetWeaponList())
+		{
+			recordActor.Weapons.Add(IsValid(weapon) && weapon->GetData()
+				? weapon->GetData()->GetPathName()
+				: FString());
+		}
+		recordActor.CurrentWeaponIndex = manager->GetCurrentWeaponIndex();
+	}
+	return id;
+}
+
+bool UCombatRecorderSubsystem::StartRecording()
+{
+	if (Mode != ECombatRecorderMode::None)
+	{
+		TRACEWARN(LogWeapon, "Combat recorder is busy");
+		return false;
+	}
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		TRACEERROR(LogWeapon, "Combat recorder must run on the server");
+		return false;
+	}
+
+	Record = FCombatRecord();
+	ActorIds.Reset();
+	StartTime = GetWorld()->GetTimeSeconds();
+	ResetSampling();
+	Mode = ECombatRecorderMode::Recording;
+	TRACE(LogWeapon, "Combat recording started");
+	return true;
+}
+
+FString UCombatRecorderSubsystem::StopRecording(const FString& InName)
+{
+	if (Mode != ECombatRecorderMode::Recording)
+		return FString();
+
+	Mode = ECombatRecorderMode::None;
+	Record.Duration = GetRecordTime();
+	FinishSampling(Record);
+	ActorIds.Reset();
+
+	FBufferArchive writer;
+	writer << Record;
+	const FString path = GetRecordPath(InName);
+	if (!FFileHelper::SaveArrayToFile(writer, *path))
+	{
+		TRACEERROR(LogWeapon, "Failed to write combat record %s", *path);
+		return FString();
+	}
+
+	TRACE(LogWeapon, "Combat record %s: %d actors, %d inputs, %d outcomes, %.1f sec", *path, Record.Actors.Num(),
+		Record.Inputs.Num(), Record.Outcomes.Num(), Record.Duration);
+	return path;
+}
+
+void UCombatRecorderSubsystem::RecordInput(UAdvancedWeaponManager* InManager, const FMeleeInputCommand& InCommand)
+{
+	if (Mode != ECombatRecorderMode::Recording || !IsValid(InManager))
+		return;
+
+	AActor* owner = InManager->GetOwner();
+	FCombatRecordInput& input = Record.Inputs.AddDefaulted_GetRef();
+	input.Time = GetRecordTime();
+	input.Actor = GetActorId(owner);
+	input.Command = InCommand;
+	input.Location = FVector3f(owner->GetActorLocation());
+	input.Yaw = owner->GetActorRotation().Yaw;
+}
+
+void UCombatRecorderSubsystem::RecordOutcome(UAdvancedWeaponManager* InCauser, AActor* InVictim,
+	EDamageReturn InResult, float InDamage)
+{
+	if (Mode == ECombatRecorderMode::None || !IsValid(InCauser) || !IsValid(InVictim))
+		return;
+
+	FCombatRecordOutcome outcome;
+	outcome.Time = GetRecordTime();
+	outcome.Result = InResult;
+	outcome.Damage = InDamage;
+	if (Mode == ECombatRecorderMode::Recording)
+	{
+		outcome.Causer = GetActorId(InCauser->GetOwner());
+		outcome.Victim = GetActorId(InVictim);
+		Record.Outcomes.Add(outcome);
+		return;
+	}
+
+	// Replay only knows actors it spawned
+	const uint16* causer = ActorIds.Find(InCauser->GetOwner());
+	const uint16* victim = ActorIds.Find(InVictim);
+	if (!causer || !victim)
+		return;
+
+	outcome.Causer = *causer;
+	outcome.Victim = *victim;
+	ReplayOutcomes.Add(outcome);
+}
+
+bool UCombatRecorderSubsystem::StartReplay(const FString& InName)
+{
+	if (Mode != ECombatRecorderMode::None)
+	{
+		TRACEWARN(LogWeapon, "Combat recorder is busy");
+		return false;
+	}
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		TRACEERROR(LogWeapon, "Combat replay must run on the server");
+		return false;
+	}
+
+	const FString path = GetRecordPath(InName);
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *path))
+	{
+		TRACEERROR(LogWeapon, "Failed to read combat record %s", *path);
+		return false;
+	}
+
+	Record = FCombatRecord();
+	FMemoryReader reader(data);
+	reader << Record;
+	if (reader.IsError())
+	{
+		TRACEERROR(LogWeapon, "Invalid combat record %s", *path);
+		return false;
+	}
+
+	ReplayName = FPaths::GetBaseFilename(path);
+	ReplayOutcomes.Reset();
+	ActorIds.Reset();
+	if (!SpawnReplayActors())
+	{
+		StopReplay();
+		return false;
+	}
+
+	NextInput = 0;
+	bReplayStarted = false;
+	StartTime = GetWorld()->GetTimeSeconds();
+	Mode = ECombatRecorderMode::Replaying;
+	TRACE(LogWeapon, "Combat replay %s: %d actors, %d inputs", *ReplayName, Record.Actors.Num(),
+		Record.Inputs.Num());
+	return true;
+}
+
+bool UCombatRecorderSubsystem::SpawnReplayActors()
+{
+	ReplayActors.Reset(Record.Actors.Num());
+	for (int32 i = 0; i < Record.Actors.Num(); ++i)
+	{
+		const FCombatRecordActor& recordActor = Record.Actors[i];
+		UClass* actorClass = LoadClass<AActor>(nullptr, *recordActor.ClassPath);
+		if (!actorClass)
+		{
+			TRACEERROR(LogWeapon, "Failed to load replay actor class %s", *recordActor.ClassPath);
+			return false;
+		}
+
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride =
+			ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		spawnParameters.ObjectFlags = RF_Transient;
+		AActor* actor = GetWorld()->SpawnActor<AActor>(actorClass, recordActor.Transform, spawnParameters);
+		if (!IsValid(actor))
+		{
+			TRACEERROR(LogWeapon, "Failed to spawn replay actor %s", *recordActor.ClassPath);
+			return false;
+		}
+		ReplayActors.Add(actor);
+		ActorIds.Add(actor, static_cast<uint16>(i));
+
+		// Victims without weapons only take damage
+		if (recordActor.Weapons.Num() == 0)
+			continue;
+
+		// Hits read the player state through the controller
+		APawn* pawn = Cast<APawn>(actor);
+		if (pawn && !pawn->GetController())
+		{
+			pawn->SpawnDefaultController();
+		}
+
+		UAdvancedWeaponManager* manager = UAdvancedWeaponManager::FindOrAddForActor(actor);
+		// Default weapons of the class are already in the list
+		for (int32 w = manager->WeaponNum(); w < recordActor.Weapons.Num(); ++w)
+		{
+			UWeaponDataAsset* weapon = LoadObject<UWeaponDataAsset>(nullptr, *recordActor.Weapons[w]);
+			if (!weapon)
+			{
+				TRACEERROR(LogWeapon, "Failed to load replay weapon %s", *recordActor.Weapons[w]);
+				return false;
+			}
+			manager->AddNewWeapon(weapon);
+		}
+
+		if (recordActor.CurrentWeaponIndex != INDEX_NONE)
+		{
+			manager->ExecuteInput(FMeleeInputCommand(EMeleeInputType::Equip, recordActor.CurrentWeaponIndex));
+		}
+	}
+	return true;
+}
+
+void UCombatRecorderSubsystem::StopReplay()
+{
+	for (const TWeakObjectPtr<AActor>& actor : ReplayActors)
+	{
+		if (actor.IsValid())
+		{
+			actor->Destroy();
+		}
+	}
+	ReplayActors.Reset();
+	ActorIds.Reset();
+	if (Mode == ECombatRecorderMode::Replaying)
+	{
+		Mode = ECombatRecorderMode::None;
+	}
+}
+
+void UCombatRecorderSubsystem::FinishReplay()
+{
+	FCombatRecord replayTiming;
+	replayTiming.Duration = GetRecordTime();
+	FinishSampling(replayTiming);
+
+	const FString path = WriteReport(replayTiming);
+	TRACE(LogWeapon, "Combat replay %s finished: %s", *ReplayName, *path);
+	StopReplay();
+}
+
+FString UCombatRecorderSubsystem::WriteReport(const FCombatRecord& InReplayTiming) const
+{
+	// Outcomes are compared in order, replay is driven by the same input sequence
+	TArray<TSharedPtr<FJsonValue>> mismatches;
+	int32 mismatchNum = 0;
+	const int32 num = FMath::Max(Record.Outcomes.Num(), ReplayOutcomes.Num());
+	for (int32 i = 0; i < num; ++i)
+	{
+		const FCombatRecordOutcome* recorded = Record.Outcomes.IsValidIndex(i) ? &Record.Outcomes[i] : nullptr;
+		const FCombatRecordOutcome* replayed = ReplayOutcomes.IsValidIndex(i) ? &ReplayOutcomes[i] : nullptr;
+		const bool bMatch = recorded && replayed
+			&& recorded->Causer == replayed->Causer
+			&& recorded->Victim == replayed->Victim
+			&& recorded->Result == replayed->Result
+			&& FMath::IsNearlyEqual(recorded->Damage, replayed->Damage, DamageTolerance);
+		if (bMatch)
+			continue;
+
+		++mismatchNum;
+		if (mismatches.Num() >= MaxReportedMismatches)
+			continue;
+
+		TSharedRef<FJsonObject> mismatch = MakeShared<FJsonObject>();
+		mismatch->SetNumberField(TEXT("index"), i);
+		if (recorded)
+		{
+			mismatch->SetObjectField(TEXT("recorded"), MakeOutcomeJson(*recorded));
+		}
+		if (replayed)
+		{
+			mismatch->SetObjectField(TEXT("replayed"), MakeOutcomeJson(*replayed));
+		}
+		mismatches.Add(MakeShared<FJsonValueObject>(mismatch));
+	}
+
+	TSharedRef<FJsonObject> phases = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < static_cast<int32>(EMeleePhase::Num); ++i)
+	{
+		TSharedRef<FJsonObject> phase = MakeShared<FJsonObject>();
+		const float recordedMs = Record.PhaseMs.IsValidIndex(i) ? Record.PhaseMs[i] : 0.0f;
+		const float replayedMs = InReplayTiming.PhaseMs.IsValidIndex(i) ? InReplayTiming.PhaseMs[i] : 0.0f;
+		phase->SetNumberField(TEXT("recordedMs"), recordedMs);
+		phase->SetNumberField(TEXT("replayedMs"), replayedMs);
+		phase->SetNumberField(TEXT("ratio"), recordedMs > 0.0f ? replayedMs / recordedMs : 0.0f);
+		phases->SetObjectField(FMeleeCounters::GetPhaseName(static_cast<EMeleePhase>(i)), phase);
+	}
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetStringField(TEXT("record"), ReplayName);
+	json->SetNumberField(TEXT("duration"), Record.Duration);
+	json->SetNumberField(TEXT("inputs"), Record.Inputs.Num());
+	json->SetNumberField(TEXT("recordedOutcomes"), Record.Outcomes.Num());
+	json->SetNumberField(TEXT("replayedOutcomes"), ReplayOutcomes.Num());
+	json->SetNumberField(TEXT("mismatches"), mismatchNum);
+	json->SetArrayField(TEXT("firstMismatches"), mismatches);
+	json->SetNumberField(TEXT("recordedFrameMs"), Record.FrameMs);
+	json->SetNumberField(TEXT("replayedFrameMs"), InReplayTiming.FrameMs);
+	json->SetObjectField(TEXT("phases"), phases);
+
+	FString output;
+	const TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&output);
+	FJsonSerializer::Serialize(json, writer);
+
+	const FString path = FPaths::Combine(FPaths::ProfilingDir(), TEXT("MeleeReplay"),
+		FString::Printf(TEXT("%s_%s.json"), *ReplayName, *FDateTime::Now().ToString()));
+	if (!FFileHelper::SaveStringToFile(output, *path))
+	{
+		TRACEERROR(LogWeapon, "Failed to write combat replay report %s", *path);
+	}
+	return path;
+}
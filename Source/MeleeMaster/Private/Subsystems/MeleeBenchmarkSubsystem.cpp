@@ -0,0 +1,607 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeBenchmarkSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Curves/CurveFloat.h"
+#include "Data/WeaponHitPathAsset.h"
+#include "Dom/JsonObject.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/PlatformMemory.h"
+#include "Libs/MeleeCombatMath.h"
+#include "Misc/App.h"
+#include "Subsystems/LoggerLib.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMeleeBenchBrawl(
+	TEXT("melee.Bench.Brawl"),
+	TEXT("melee.Bench.Brawl N [Seconds=20] - N fighters brawl, results are written to Saved/Profiling/MeleeBench."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld) {
+		UMeleeBenchmarkSubsystem* bench = UMeleeBenchmarkSubsystem::Get(InWorld);
+		if (!bench)
+			return;
+
+		const int32 size = InArgs.Num() > 0 ? FCString::Atoi(*InArgs[0]) : 10;
+		const float duration = InArgs.Num() > 1 ? FCString::Atof(*InArgs[1]) : 20.0f;
+		bench->StartBrawl(size, duration);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMeleeBenchSuite(
+	TEXT("melee.Bench.Suite"),
+	TEXT("melee.Bench.Suite [Seconds=20] - runs brawls of every SuiteSizes entry (10, 50, 100, 250)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld) {
+		if (UMeleeBenchmarkSubsystem* bench = UMeleeBenchmarkSubsystem::Get(InWorld))
+		{
+			bench->StartSuite(InArgs.Num() > 0 ? FCString::Atof(*InArgs[0]) : 20.0f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdMeleeBenchStop(
+	TEXT("melee.Bench.Stop"),
+	TEXT("Stops running melee benchmark without results."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* InWorld) {
+		if (UMeleeBenchmarkSubsystem* bench = UMeleeBenchmarkSubsystem::Get(InWorld))
+		{
+			bench->Stop();
+		}
+	}));
+
+/** Random inputs per kernel, iterations wrap around */
+static constexpr int32 KernelInputNum = 4096;
+
+/**
+ * @brief Runs InKernel(InputIndex) InIterations times.
+ * @return Nanoseconds per call.
+ */
+template <typename TKernel>
+static double MeasureKernel(int64 InIterations, TKernel&& InKernel)
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	for (int64 i = 0; i < InIterations; ++i)
+	{
+		InKernel(static_cast<int32>(i & (KernelInputNum - 1)));
+	}
+	const double seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - startCycles);
+	return seconds * 1.0e9 / FMath::Max<int64>(InIterations, 1);
+}
+
+/**
+ * @brief Known answers of FMeleeCombatMath, timing a broken kernel is meaningless.
+ * @return Failed checks.
+ */
+static TArray<FString> CheckKernels()
+{
+	TArray<FString> errors;
+	auto check = [&errors](bool bInPassed, const TCHAR* InName) {
+		if (!bInPassed)
+		{
+			errors.Add(InName);
+		}
+	};
+
+	check(FMeleeCombatMath::IsBlockDirectionMatched(EWeaponDirection::Right, EWeaponDirection::Left)
+		&& !FMeleeCombatMath::IsBlockDirectionMatched(EWeaponDirection::Forward, EWeaponDirection::Left),
+		TEXT("IsBlockDirectionMatched"));
+	check(FMeleeCombatMath::ResolveBlock(true, EWeaponTier::Light, EWeaponTier::High, 0.3f, 0.8f) == EBlockResult::ShieldBlock
+		&& FMeleeCombatMath::ResolveBlock(false, EWeaponTier::High, EWeaponTier::Light, 0.3f, 0.8f) == EBlockResult::Parry
+		&& FMeleeCombatMath::ResolveBlock(false, EWeaponTier::Light, EWeaponTier::High, 0.3f, 0.8f) == EBlockResult::Block
+		&& FMeleeCombatMath::ResolveBlock(false, EWeaponTier::High, EWeaponTier::High, 1.0f, 0.8f) == EBlockResult::Block,
+		TEXT("ResolveBlock"));
+	check(FMeleeCombatMath::IsInBlockAngle(FVector::ForwardVector, FVector(100.0f, 0.0f, 50.0f), 90.0f)
+		&& !FMeleeCombatMath::IsInBlockAngle(FVector::ForwardVector, FVector::RightVector, 170.0f),
+		TEXT("IsInBlockAngle"));
+	check(FMath::IsNearlyEqual(FMeleeCombatMath::GetChargingCurveTime(10.0f, 11.0f, 10.5f), 0.5f, KINDA_SMALL_NUMBER),
+		TEXT("GetChargingCurveTime"));
+	check(FMath::IsNearlyEqual(FMeleeCombatMath::EvaluateComboDamage(10.0f, 0.5f), 15.0f), TEXT("EvaluateComboDamage"));
+
+	FWeaponHitDataElement element;
+	element.Start = FVector(0.0f, 100.0f, 0.0f);
+	element.End = FVector(0.0f, 200.0f, 0.0f);
+	FVector start;
+	FVector end;
+	FRotator rotation;
+	FMeleeCombatMath::TransformHitSegment(FRotator(30.0f, 0.0f, 0.0f), FVector::ZeroVector, 10.0f, element, start,
+		end, rotation);
+	// Authored +Y faces the attacker forward, pitch is ignored
+	check(start.Equals(FVector(100.0f, 0.0f, 10.0f), 0.01f) && end.Equals(FVector(200.0f, 0.0f, 10.0f), 0.01f),
+		TEXT("TransformHitSegment"));
+	return errors;
+}
+
+/**
+ * @brief Measures FMeleeCombatMath kernels and data helpers of the hit and block path with random inputs.
+ * Results are logged and written to Saved/Profiling/MeleeBench/Kernels_*.json, the run fails if a known
+ * answer check fails or a result is not finite.
+ */
+static void RunKernelBenchmarks(int64 InIterations)
+{
+	FRandomStream random(KernelInputNum);
+	auto randomVector = [&random]() { return FVector(random.FRandRange(-1000.0f, 1000.0f),
+		random.FRandRange(-1000.0f, 1000.0f), random.FRandRange(-100.0f, 100.0f)); };
+	auto randomDirection = [&random]() { return static_cast<EWeaponDirection>(random.RandRange(0, 3)); };
+	auto randomTier = [&random]() { return static_cast<EWeaponTier>(random.RandRange(1, 3)); };
+
+	struct FKernelInput
+	{
+		FVector A;
+		FVector B;
+		FRotator Rotation;
+		float X;
+		float Y;
+		float Angle;
+		EWeaponDirection AttackDirection;
+		EWeaponDirection BlockDirection;
+		EWeaponTier AttackTier;
+		EWeaponTier BlockTier;
+		bool bShield;
+	};
+	TArray<FKernelInput> inputs;
+	inputs.SetNumUninitialized(KernelInputNum);
+	for (FKernelInput& input : inputs)
+	{
+		input.A = randomVector();
+		input.B = randomVector();
+		input.Rotation = FRotator(random.FRandRange(-80.0f, 80.0f), random.FRandRange(-180.0f, 180.0f), 0.0f);
+		input.X = random.FRand();
+		input.Y = random.FRand();
+		input.Angle = random.FRandRange(30.0f, 270.0f);
+		input.AttackDirection = randomDirection();
+		input.BlockDirection = randomDirection();
+		input.AttackTier = randomTier();
+		input.BlockTier = randomTier();
+		input.bShield = random.FRand() < 0.2f;
+	}
+
+	// Charging curve and hit path as authored in weapon data
+	UCurveFloat* curve = NewObject<UCurveFloat>(GetTransientPackage());
+	curve->FloatCurve.AddKey(0.0f, 0.1f);
+	curve->FloatCurve.AddKey(0.3f, 0.6f);
+	curve->FloatCurve.AddKey(0.6f, 1.0f);
+	curve->FloatCurve.AddKey(1.0f, 0.4f);
+
+	UWeaponHitPathAsset* hitPath = NewObject<UWeaponHitPathAsset>(GetTransientPackage());
+	for (int32 i = 0; i < 8; ++i)
+	{
+		FWeaponHitDataElement& element = hitPath->Data.Elements.AddDefaulted_GetRef();
+		element.Start = randomVector() * 0.1f;
+		element.End = randomVector() * 0.1f;
+	}
+	FMeleeAttackCurveData attackData;
+	attackData.HitPath = hitPath;
+	attackData.bDamageForFullPath = true;
+
+	// Results are summed so loops are not optimized away
+	double sink = 0.0;
+	TArray<TPair<FString, double>> results;
+
+	results.Emplace(TEXT("CanBlockIncomingDamage"), MeasureKernel(InIterations, [&](int32 i) {
+		const FKernelInput& input = inputs[i];
+		if (input.bShield || FMeleeCombatMath::IsBlockDirectionMatched(input.AttackDirection, input.BlockDirection))
+		{
+			sink += static_cast<double>(FMeleeCombatMath::ResolveBlock(input.bShield, input.BlockTier,
+				input.AttackTier, input.X, input.Y));
+		}
+	}));
+	results.Emplace(TEXT("CanBlockSide"), MeasureKernel(InIterations, [&](int32 i) {
+		const FKernelInput& input = inputs[i];
+		sink += FMeleeCombatMath::IsInBlockAngle(input.A, input.B, input.Angle) ? 1.0 : 0.0;
+	}));
+	results.Emplace(TEXT("EvaluateCurrentCurve"), MeasureKernel(InIterations, [&](int32 i) {
+		const FKernelInput& input = inputs[i];
+		const float startTime = input.Angle;
+		const float finishTime = startTime + 1.0f;
+		sink += curve->GetFloatValue(FMeleeCombatMath::GetChargingCurveTime(startTime, finishTime,
+			startTime + input.X));
+	}));
+	results.Emplace(TEXT("EvaluateAttackComboDamage"), MeasureKernel(InIterations, [&](int32 i) {
+		const FKernelInput& input = inputs[i];
+		sink += FMeleeCombatMath::EvaluateComboDamage(input.Angle, input.X);
+	}));
+	results.Emplace(TEXT("FMeleeAttackCurveData::GetDamage"), MeasureKernel(InIterations, [&](int32 i) {
+		attackData.BasicDamage = inputs[i].Angle;
+		sink += attackData.GetDamage();
+	}));
+	results.Emplace(TEXT("MeleeHitProcedure transform"), MeasureKernel(InIterations, [&](int32 i) {
+		const FKernelInput& input = inputs[i];
+		FVector start;
+		FVector end;
+		FRotator rotation;
+		FMeleeCombatMath::TransformHitSegment(input.Rotation, input.A, hitPath->ZOffset,
+			hitPath->Data.Elements[i & 7], start, end, rotation);
+		sink += start.X + end.Y;
+	}));
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("iterations"), InIterations);
+	json->SetStringField(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	TSharedRef<FJsonObject> kernels = MakeShared<FJsonObject>();
+	for (const TPair<FString, double>& result : results)
+	{
+		kernels->SetNumberField(result.Key, result.Value);
+		TRACE(LogWeapon, "%s: %.2f ns/op", *result.Key, result.Value);
+	}
+	json->SetObjectField(TEXT("nsPerOp"), kernels);
+	json->SetNumberField(TEXT("checksum"), sink);
+
+	TArray<FString> errors = CheckKernels();
+	if (!FMath::IsFinite(sink))
+	{
+		errors.Add(TEXT("Checksum is not finite"));
+	}
+	json->SetBoolField(TEXT("passed"), errors.Num() == 0);
+	TArray<TSharedPtr<FJsonValue>> errorValues;
+	for (const FString& error : errors)
+	{
+		TRACEERROR(LogWeapon, "Melee kernel check failed: %s", *error);
+		errorValues.Add(MakeShared<FJsonValueString>(error));
+	}
+	json->SetArrayField(TEXT("errors"), errorValues);
+
+	const FString path = FMeleeHarnessFixture::WriteResults(json, TEXT("MeleeBench"), TEXT("Kernels"));
+	TRACE(LogWeapon, "Melee kernels %s: %s", errors.Num() == 0 ? TEXT("passed") : TEXT("failed"), *path);
+}
+
+static FAutoConsoleCommand CmdMeleeBenchKernels(
+	TEXT("melee.Bench.Kernels"),
+	TEXT("melee.Bench.Kernels [Iterations=5000000] - ns/op of combat math kernels."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& InArgs) {
+		const int64 iterations = InArgs.Num() > 0 ? FCString::Atoi64(*InArgs[0]) : 5000000;
+		RunKernelBenchmarks(FMath::Max<int64>(iterations, 1));
+	}));
+
+/**
+ * @brief Percentile of sorted samples.
+ */
+static float GetPercentile(const TArray<float>& InSorted, float InPercent)
+{
+	if (InSorted.Num() == 0)
+		return 0.0f;
+
+	const int32 index = FMath::Clamp(FMath::CeilToInt(InPercent * InSorted.Num()) - 1, 0, InSorted.Num() - 1);
+	return InSorted[index];
+}
+
+static TSharedRef<FJsonObject> MakeTimingJson(const TArray<float>& InSamples)
+{
+	TArray<float> sorted = InSamples;
+	sorted.Sort();
+	double sum = 0.0;
+	for (const float sample : sorted)
+	{
+		sum += sample;
+	}
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("avg"), sorted.Num() > 0 ? sum / sorted.Num() : 0.0);
+	json->SetNumberField(TEXT("p50"), GetPercentile(sorted, 0.5f));
+	json->SetNumberField(TEXT("p95"), GetPercentile(sorted, 0.95f));
+	json->SetNumberField(TEXT("p99"), GetPercentile(sorted, 0.99f));
+	json->SetNumberField(TEXT("max"), sorted.Num() > 0 ? sorted.Last() : 0.0f);
+	return json;
+}
+
+bool UMeleeBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return FMeleeHarnessFixture::DoesSupportWorldType(WorldType);
+}
+
+void UMeleeBenchmarkSubsystem::Deinitialize()
+{
+	// Pawns are destroyed with the world
+	Bots.Empty();
+	PendingSizes.Empty();
+	bRunning = false;
+	Super::Deinitialize();
+}
+
+TStatId UMeleeBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeleeBenchmarkSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UMeleeBenchmarkSubsystem::IsTickable() const
+{
+	return bRunning;
+}
+
+UMeleeBenchmarkSubsystem* UMeleeBenchmarkSubsystem::Get(const UObject* WorldContextObject)
+{
+	return FMeleeHarnessFixture::GetSubsystem<UMeleeBenchmarkSubsystem>(WorldContextObject);
+}
+
+bool UMeleeBenchmarkSubsystem::StartBrawl(int32 InSize, float InDuration)
+{
+	if (bRunning)
+	{
+		TRACEWARN(LogWeapon, "Melee benchmark is already running");
+		return false;
+	}
+
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		TRACEERROR(LogWeapon, "Melee benchmark must run on the server");
+		return false;
+	}
+
+	// Even number, fighters are paired
+	const int32 size = FMath::Max(2, InSize + InSize % 2);
+	Random.Initialize(size);
+	if (!SpawnBots(size))
+	{
+		DestroyBots();
+		return false;
+	}
+
+	RunSize = size;
+	RunDuration = FMath::Max(InDuration, 1.0f);
+	RunStartTime = FPlatformTime::Seconds();
+	bRunning = true;
+	bSampling = false;
+	TRACE(LogWeapon, "Melee benchmark: %d fighters, %.1f sec", RunSize, RunDuration);
+	return true;
+}
+
+bool UMeleeBenchmarkSubsystem::StartSuite(float InDuration)
+{
+	if (bRunning || SuiteSizes.Num() == 0)
+		return false;
+
+	PendingSizes = SuiteSizes;
+	const int32 first = PendingSizes[0];
+	PendingSizes.RemoveAt(0);
+	if (!StartBrawl(first, InDuration))
+	{
+		PendingSizes.Reset();
+		return false;
+	}
+	return true;
+}
+
+void UMeleeBenchmarkSubsystem::Stop()
+{
+	PendingSizes.Reset();
+	if (!bRunning)
+		return;
+
+	DestroyBots();
+	bRunning = false;
+	bSampling = false;
+	TRACE(LogWeapon, "Melee benchmark stopped");
+}
+
+bool UMeleeBenchmarkSubsystem::SpawnBots(int32 InSize)
+{
+	const FMeleeHarnessFixture fixture = GetFixture();
+	UWeaponDataAsset* weapon = fixture.LoadWeapon();
+	TArray<UAdvancedWeaponManager*> managers;
+	const bool bSpawned = fixture.SpawnFighters(GetWorld(), InSize, managers);
+
+	Bots.Reserve(managers.Num());
+	for (int32 i = 0; i < managers.Num(); ++i)
+	{
+		UAdvancedWeaponManager* manager = managers[i];
+		const int32 weaponIndex = weapon ? manager->AddNewWeapon(weapon) : 0;
+		manager->TryEquipProxy(FMath::Max(weaponIndex, 0));
+
+		FMeleeBenchBot& bot = Bots.AddDefaulted_GetRef();
+		bot.Pawn = Cast<APawn>(manager->GetOwner());
+		bot.Manager = manager;
+		bot.bAttacker = i % 2 == 0;
+		// Spread first actions over a second
+		bot.NextActionTime = WarmupTime + Random.FRand();
+	}
+	return bSpawned;
+}
+
+void UMeleeBenchmarkSubsystem::DestroyBots()
+{
+	for (const FMeleeBenchBot& bot : Bots)
+	{
+		if (APawn* pawn = bot.Pawn.Get())
+		{
+			pawn->Destroy();
+		}
+	}
+	Bots.Reset();
+}
+
+void UMeleeBenchmarkSubsystem::DriveBot(FMeleeBenchBot& InBot, double InNow)
+{
+	UAdvancedWeaponManager* manager = InBot.Manager.Get();
+	if (!manager || InNow < InBot.NextActionTime)
+		return;
+
+	const EWeaponDirection direction = static_cast<EWeaponDirection>(Random.RandRange(0, 3));
+	if (InBot.bAttacker)
+	{
+		// Charge, release, recover
+		switch (InBot.Step)
+		{
+		case 0:
+			manager->RequestDirectedAttackProxy(direction);
+			InBot.NextActionTime = InNow + 0.3 + Random.FRand() * 0.4;
+			break;
+		default:
+			manager->RequestAttackReleasedProxy();
+			InBot.NextActionTime = InNow + 1.0;
+			break;
+		}
+	}
+	else
+	{
+		// Raise block (random direction gives blocks, parries and full hits), hold, lower
+		switch (InBot.Step)
+		{
+		case 0:
+			manager->RequestBlockProxy(direction);
+			InBot.NextActionTime = InNow + 0.8;
+			break;
+		default:
+			manager->RequestBlockReleasedProxy();
+			InBot.NextActionTime = InNow + 0.5;
+			break;
+		}
+	}
+
+	InBot.Step = (InBot.Step + 1) % 2;
+	if (InBot.Step == 0)
+	{
+		// Swap roles every cycle
+		InBot.bAttacker = !InBot.bAttacker;
+	}
+}
+
+void UMeleeBenchmarkSubsystem::GetNetTotals(int64& OutBytes, int64& InBytes) const
+{
+	OutBytes = 0;
+	InBytes = 0;
+	if (const UNetDriver* driver = GetWorld()->GetNetDriver())
+	{
+		OutBytes = static_cast<int64>(driver->OutTotalBytes);
+		InBytes = static_cast<int64>(driver->InTotalBytes);
+	}
+}
+
+int32 UMeleeBenchmarkSubsystem::GetClientConnectionNum() const
+{
+	const UNetDriver* driver = GetWorld()->GetNetDriver();
+	return driver ? driver->ClientConnections.Num() : 0;
+}
+
+void UMeleeBenchmarkSubsystem::BeginSampling()
+{
+	bSampling = true;
+	SampleStartTime = FPlatformTime::Seconds();
+	FrameTimes.Reset();
+	BusyTimes.Reset();
+	StartCounters = FMeleeCounters::Get();
+	GetNetTotals(StartOutBytes, StartInBytes);
+	const FPlatformMemoryStats memory = FPlatformMemory::GetStats();
+	StartUsedPhysical = memory.UsedPhysical;
+	PeakUsedPhysical = memory.UsedPhysical;
+}
+
+void UMeleeBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	const double now = FPlatformTime::Seconds();
+	const double elapsed = now - RunStartTime;
+	for (FMeleeBenchBot& bot : Bots)
+	{
+		DriveBot(bot, elapsed);
+	}
+
+	if (!bSampling)
+	{
+		if (elapsed >= WarmupTime)
+		{
+			BeginSampling();
+		}
+		return;
+	}
+
+	// Busy time excludes sleeping for the max tick rate of the server
+	FrameTimes.Add(FApp::GetDeltaTime() * 1000.0);
+	BusyTimes.Add(FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0) * 1000.0);
+	PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	if (now - SampleStartTime >= RunDuration)
+	{
+		FinishRun();
+	}
+}
+
+void UMeleeBenchmarkSubsystem::FinishRun()
+{
+	const double elapsed = FPlatformTime::Seconds() - SampleStartTime;
+	bool bPassed = false;
+	const FString path = WriteResults(elapsed, bPassed);
+	TRACE(LogWeapon, "Melee benchmark %d fighters %s: %s", RunSize, bPassed ? TEXT("passed") : TEXT("failed"), *path);
+
+	DestroyBots();
+	bRunning = false;
+	bSampling = false;
+
+	if (PendingSizes.Num() > 0)
+	{
+		const int32 next = PendingSizes[0];
+		PendingSizes.RemoveAt(0);
+		StartBrawl(next, RunDuration);
+	}
+}
+
+FString UMeleeBenchmarkSubsystem::WriteResults(double InElapsed, bool& bOutPassed) const
+{
+	const FMeleeCounters& counters = FMeleeCounters::Get();
+	const double seconds = FMath::Max(InElapsed, KINDA_SMALL_NUMBER);
+	int64 outBytes;
+	int64 inBytes;
+	GetNetTotals(outBytes, inBytes);
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("fighters"), RunSize);
+	json->SetNumberField(TEXT("seconds"), seconds);
+	json->SetNumberField(TEXT("frames"), FrameTimes.Num());
+	json->SetStringField(TEXT("map"), GetWorld()->GetMapName());
+	json->SetStringField(TEXT("netMode"), GetWorld()->GetNetMode() == NM_DedicatedServer
+		? TEXT("DedicatedServer")
+		: GetWorld()->GetNetMode() == NM_ListenServer ? TEXT("ListenServer") : TEXT("Standalone"));
+	json->SetStringField(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	json->SetObjectField(TEXT("frameTimeMs"), MakeTimingJson(FrameTimes));
+	json->SetObjectField(TEXT("busyTimeMs"), MakeTimingJson(BusyTimes));
+	json->SetNumberField(TEXT("tracesPerSec"), (counters.Traces - StartCounters.Traces) / seconds);
+	json->SetNumberField(TEXT("hitsPerSec"), (counters.Hits - StartCounters.Hits) / seconds);
+	json->SetNumberField(TEXT("blocks"), counters.Blocks - StartCounters.Blocks);
+	json->SetNumberField(TEXT("parries"), counters.Parries - StartCounters.Parries);
+	const int32 clientNum = GetClientConnectionNum();
+	json->SetNumberField(TEXT("clientConnections"), clientNum);
+	if (clientNum > 0)
+	{
+		json->SetNumberField(TEXT("rpcs"), counters.Rpcs - StartCounters.Rpcs);
+		json->SetNumberField(TEXT("rpcsPerSec"), (counters.Rpcs - StartCounters.Rpcs) / seconds);
+		json->SetNumberField(TEXT("netOutBytesPerSec"), (outBytes - StartOutBytes) / seconds);
+		json->SetNumberField(TEXT("netInBytesPerSec"), (inBytes - StartInBytes) / seconds);
+	}
+	else
+	{
+		// Bots call the RPCs locally, nothing is sent
+		for (const TCHAR* field : {TEXT("rpcs"), TEXT("rpcsPerSec"), TEXT("netOutBytesPerSec"), TEXT("netInBytesPerSec")})
+		{
+			json->SetField(field, MakeShared<FJsonValueNull>());
+		}
+	}
+	json->SetNumberField(TEXT("memoryGrowthMB"),
+		(static_cast<double>(PeakUsedPhysical) - static_cast<double>(StartUsedPhysical)) / (1024.0 * 1024.0));
+	json->SetNumberField(TEXT("memoryPeakMB"), PeakUsedPhysical / (1024.0 * 1024.0));
+
+	TArray<FString> errors;
+	if (FrameTimes.Num() == 0)
+	{
+		errors.Add(TEXT("No frames sampled"));
+	}
+	if (counters.Traces == StartCounters.Traces)
+	{
+		errors.Add(TEXT("No melee traces, fighters did not attack"));
+	}
+	TArray<float> busyTimes = BusyTimes;
+	busyTimes.Sort();
+	const float busyP95 = GetPercentile(busyTimes, 0.95f);
+	if (BusyTimeBudgetMs > 0.0f && busyP95 > BusyTimeBudgetMs)
+	{
+		errors.Add(FString::Printf(TEXT("Busy time p95 %.2f ms is over budget %.2f ms"), busyP95, BusyTimeBudgetMs));
+	}
+
+	bOutPassed = errors.Num() == 0;
+	json->SetBoolField(TEXT("passed"), bOutPassed);
+	TArray<TSharedPtr<FJsonValue>> errorValues;
+	for (const FString& error : errors)
+	{
+		TRACEERROR(LogWeapon, "Melee benchmark %d fighters: %s", RunSize, *error);
+		errorValues.Add(MakeShared<FJsonValueString>(error));
+	}
+	json->SetArrayField(TEXT("errors"), errorValues);
+
+	return FMeleeHarnessFixture::WriteResults(json, TEXT("MeleeBench"), FString::Printf(TEXT("Brawl_%d"), RunSize));
+}
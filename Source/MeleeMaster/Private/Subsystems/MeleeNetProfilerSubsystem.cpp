@@ -0,0 +1,513 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeNetProfilerSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Subsystems/LoggerLib.h"
+#include "UObject/UnrealType.h"
+#if UE_WITH_IRIS
+#include "Iris/IrisConfig.h"
+#endif
+
+static TAutoConsoleVariable<int32> CVarMeleeNetProfile(
+	TEXT("melee.Net.Profile"),
+	0,
+	TEXT("1 - measure weapon manager RPC and property traffic per connection (melee.Net.Report, CSV)."));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdMeleeNetReport(
+	TEXT("melee.Net.Report"),
+	TEXT("Prints weapon manager traffic of the last second per RPC, property and connection."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& InArgs, UWorld* InWorld, FOutputDevice& Ar) {
+			if (UMeleeNetProfilerSubsystem::IsUsingIris())
+			{
+				Ar.Log(TEXT("melee.Net.Profile does not support Iris replication, use -NetTrace=1 -trace=net"));
+				return;
+			}
+			if (!UMeleeNetProfilerSubsystem::IsEnabled())
+			{
+				Ar.Log(TEXT("melee.Net.Profile is 0"));
+				return;
+			}
+			if (UMeleeNetProfilerSubsystem* profiler = UMeleeNetProfilerSubsystem::Get(InWorld))
+			{
+				profiler->Dump(Ar);
+			}
+		}));
+
+/**
+ * @brief Copy of replicated property values, used to find changed ones.
+ */
+class FMeleePropertyShadow
+{
+public:
+	explicit FMeleePropertyShadow(const TArray<FProperty*>& InProperties)
+		: Properties(InProperties)
+	{
+		int32 size = 0;
+		for (const FProperty* property : Properties)
+		{
+			size = Align(size, property->GetMinAlignment());
+			Offsets.Add(size);
+			size += property->GetSize();
+		}
+		Buffer = static_cast<uint8*>(FMemory::Malloc(FMath::Max(size, 1), 16));
+		for (int32 i = 0; i < Properties.Num(); ++i)
+		{
+			Properties[i]->InitializeValue(Buffer + Offsets[i]);
+		}
+	}
+
+	~FMeleePropertyShadow()
+	{
+		for (int32 i = 0; i < Properties.Num(); ++i)
+		{
+			Properties[i]->DestroyValue(Buffer + Offsets[i]);
+		}
+		FMemory::Free(Buffer);
+	}
+
+	FMeleePropertyShadow(const FMeleePropertyShadow&) = delete;
+	FMeleePropertyShadow& operator=(const FMeleePropertyShadow&) = delete;
+
+	/**
+	 * @brief Stores the value of the property.
+	 * @return True if the value differs from the stored one.
+	 */
+	bool Update(int32 InIndex, const void* InValue)
+	{
+		void* shadowValue = Buffer + Offsets[InIndex];
+		if (Properties[InIndex]->Identical(shadowValue, InValue))
+			return false;
+
+		Properties[InIndex]->CopyCompleteValue(shadowValue, InValue);
+		return true;
+	}
+
+private:
+	const TArray<FProperty*>& Properties;
+	TArray<int32> Offsets;
+	uint8* Buffer{nullptr};
+};
+
+/**
+ * @brief Replicated properties of the weapon manager.
+ */
+static const TArray<FProperty*>& GetManagerNetProperties()
+{
+	static TArray<FProperty*> properties;
+	if (properties.Num() == 0)
+	{
+		for (TFieldIterator<FProperty> it(UAdvancedWeaponManager::StaticClass()); it; ++it)
+		{
+			if (it->HasAnyPropertyFlags(CPF_Net))
+			{
+				properties.Add(*it);
+			}
+		}
+	}
+	return properties;
+}
+
+/**
+ * @brief Approximate serialized size of a property value (bits).
+ * Object references are NetGUIDs, containers carry their length.
+ */
+static int64 EstimateNetBits(const FProperty* InProperty, const void* InValue)
+{
+	if (InProperty->IsA<FBoolProperty>())
+		return 1;
+
+	if (InProperty->IsA<FObjectPropertyBase>())
+		return 32;
+
+	if (const FStrProperty* strProperty = CastField<FStrProperty>(InProperty))
+		return 32 + strProperty->GetPropertyValue(InValue).Len() * 8;
+
+	if (const FArrayProperty* arrayProperty = CastField<FArrayProperty>(InProperty))
+	{
+		FScriptArrayHelper helper(arrayProperty, InValue);
+		int64 bits = 16;
+		for (int32 i = 0; i < helper.Num(); ++i)
+		{
+			bits += EstimateNetBits(arrayProperty->Inner, helper.GetRawPtr(i));
+		}
+		return bits;
+	}
+
+	if (const FStructProperty* structProperty = CastField<FStructProperty>(InProperty))
+	{
+		int64 bits = 0;
+		for (TFieldIterator<FProperty> it(structProperty->Struct); it; ++it)
+		{
+			if (!it->HasAnyPropertyFlags(CPF_RepSkip))
+			{
+				bits += EstimateNetBits(*it, it->ContainerPtrToValuePtr<void>(InValue));
+			}
+		}
+		return bits;
+	}
+	return InProperty->GetSize() * 8;
+}
+
+/**
+ * @brief Writes the value the way RPC parameters are sent.
+ * Arrays and structs without native NetSerialize are walked here, the engine has no NetSerializeItem for them.
+ */
+static void SerializeNetValue(FNetBitWriter& Ar, UPackageMap* InMap, const FProperty* InProperty, void* InValue)
+{
+	if (const FArrayProperty* arrayProperty = CastField<FArrayProperty>(InProperty))
+	{
+		FScriptArrayHelper helper(arrayProperty, InValue);
+		uint32 num = helper.Num();
+		Ar.SerializeIntPacked(num);
+		for (int32 i = 0; i < helper.Num(); ++i)
+		{
+			SerializeNetValue(Ar, InMap, arrayProperty->Inner, helper.GetRawPtr(i));
+		}
+		return;
+	}
+
+	const FStructProperty* structProperty = CastField<FStructProperty>(InProperty);
+	if (structProperty && !(structProperty->Struct->StructFlags & STRUCT_NetSerializeNative))
+	{
+		for (TFieldIterator<FProperty> it(structProperty->Struct); it; ++it)
+		{
+			if (!it->HasAnyPropertyFlags(CPF_RepSkip))
+			{
+				SerializeNetValue(Ar, InMap, *it, it->ContainerPtrToValuePtr<void>(InValue));
+			}
+		}
+		return;
+	}
+
+	InProperty->NetSerializeItem(Ar, InMap, InValue);
+}
+
+bool UMeleeNetSizePackageMap::SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID)
+{
+	// Acked objects are sent as a packed NetGUID
+	uint32 placeholder = 0xFFFFFFFF;
+	Ar.SerializeIntPacked(placeholder);
+	return true;
+}
+
+static int64 GetConnectionSentBits(const UNetConnection* InConnection)
+{
+	// Flushed packets and pending packet
+	return static_cast<int64>(InConnection->OutTotalBytes) * 8 + InConnection->SendBuffer.GetNumBits();
+}
+
+void FMeleeNetWindow::Reset()
+{
+	Rpcs.Reset();
+	Properties.Reset();
+	Connections.Reset();
+}
+
+bool UMeleeNetProfilerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UMeleeNetProfilerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	if (IsUsingIris())
+	{
+		TRACE(LogWeapon, "Melee net profiler is off, Iris replication is not supported");
+	}
+}
+
+void UMeleeNetProfilerSubsystem::Deinitialize()
+{
+	SizePackageMap = nullptr;
+	ManagerShadows.Empty();
+	Current.Reset();
+	Last.Reset();
+	Super::Deinitialize();
+}
+
+TStatId UMeleeNetProfilerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeleeNetProfilerSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UMeleeNetProfilerSubsystem::IsTickable() const
+{
+	return IsEnabled();
+}
+
+bool UMeleeNetProfilerSubsystem::IsEnabled()
+{
+	return CVarMeleeNetProfile.GetValueOnGameThread() > 0 && !IsUsingIris();
+}
+
+bool UMeleeNetProfilerSubsystem::IsUsingIris()
+{
+#if UE_WITH_IRIS
+	return UE::Net::ShouldUseIrisReplication();
+#else
+	return false;
+#endif
+}
+
+UMeleeNetProfilerSubsystem* UMeleeNetProfilerSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UMeleeNetProfilerSubsystem>();
+	}
+	return nullptr;
+}
+
+void UMeleeNetProfilerSubsystem::Tick(float DeltaTime)
+{
+	const double currentTime = FPlatformTime::Seconds();
+	if (WindowStartTime <= 0.0)
+	{
+		WindowStartTime = currentTime;
+		return;
+	}
+	if (currentTime - WindowStartTime >= 1.0)
+	{
+		LastWindowSeconds = currentTime - WindowStartTime;
+		WindowStartTime = currentTime;
+		FinishWindow();
+	}
+}
+
+void UMeleeNetProfilerSubsystem::GatherConnections(TArray<UNetConnection*>& OutConnections) const
+{
+	OutConnections.Reset();
+	const UNetDriver* driver = GetWorld()->GetNetDriver();
+	if (!driver)
+		return;
+
+	if (driver->ServerConnection)
+	{
+		OutConnections.Add(driver->ServerConnection);
+	}
+	OutConnections.Append(driver->ClientConnections);
+}
+
+void UMeleeNetProfilerSubsystem::AddToConnection(UNetConnection* InConnection, FName InName, int64 InBits)
+{
+	FMeleeNetConnectionStats& stats = Current.Connections.FindOrAdd(InConnection);
+	if (stats.Name.IsEmpty())
+	{
+		stats.Name = InConnection->PlayerController
+			? InConnection->PlayerController->GetName()
+			: InConnection->LowLevelGetRemoteAddress(true);
+	}
+	stats.Total.Add(InBits);
+	stats.Messages.FindOrAdd(InName).Add(InBits);
+}
+
+void UMeleeNetProfilerSubsystem::BeginRpc(const UAdvancedWeaponManager* InManager, const UFunction* InFunction)
+{
+	RpcConnectionBits.Reset();
+	AActor* owner = InManager->GetOwner();
+	if (!IsValid(owner))
+		return;
+
+	TArray<UNetConnection*> connections;
+	if (InFunction->HasAnyFunctionFlags(FUNC_NetMulticast))
+	{
+		GatherConnections(connections);
+		connections.RemoveAllSwap([owner](UNetConnection* InConnection) {
+			return !InConnection->FindActorChannelRef(owner);
+		});
+	}
+	else if (UNetConnection* connection = owner->GetNetConnection())
+	{
+		connections.Add(connection);
+	}
+
+	for (UNetConnection* connection : connections)
+	{
+		RpcConnectionBits.Emplace(connection, GetConnectionSentBits(connection));
+	}
+}
+
+void UMeleeNetProfilerSubsystem::EndRpc(const UFunction* InFunction, void* InParameters)
+{
+	// Legacy net driver queues these on the actor channel, nothing is written to the send buffer now
+	const bool bQueued = InFunction->HasAnyFunctionFlags(FUNC_NetMulticast)
+		&& !InFunction->HasAnyFunctionFlags(FUNC_NetReliable);
+	int64 parameterBits = INDEX_NONE;
+
+	const FName name = InFunction->GetFName();
+	for (const TPair<UNetConnection*, int64>& pair : RpcConnectionBits)
+	{
+		if (!IsValid(pair.Key))
+			continue;
+
+		int64 bits = FMath::Max<int64>(GetConnectionSentBits(pair.Key) - pair.Value, 0);
+		if (bits == 0 && bQueued)
+		{
+			if (parameterBits == INDEX_NONE)
+			{
+				parameterBits = MeasureParameterBits(InFunction, InParameters);
+			}
+			bits = parameterBits;
+		}
+
+		Current.Rpcs.FindOrAdd(name).Add(bits);
+		AddToConnection(pair.Key, name, bits);
+	}
+	RpcConnectionBits.Reset();
+}
+
+int64 UMeleeNetProfilerSubsystem::MeasureParameterBits(const UFunction* InFunction, void* InParameters)
+{
+	if (!InParameters)
+		return 0;
+
+	if (!SizePackageMap)
+	{
+		SizePackageMap = NewObject<UMeleeNetSizePackageMap>(this);
+	}
+
+	FNetBitWriter writer(SizePackageMap, 256);
+	writer.SetAllowResize(true);
+	for (TFieldIterator<FProperty> it(InFunction); it && it->HasAnyPropertyFlags(CPF_Parm); ++it)
+	{
+		if (!it->HasAnyPropertyFlags(CPF_ReturnParm))
+		{
+			SerializeNetValue(writer, SizePackageMap, *it, it->ContainerPtrToValuePtr<void>(InParameters));
+		}
+	}
+	return writer.GetNumBits();
+}
+
+void UMeleeNetProfilerSubsystem::RecordProperty(FName InName, UNetConnection* InConnection, int64 InBits)
+{
+	if (InBits <= 0 || !InConnection)
+		return;
+
+	Current.Properties.FindOrAdd(InName).Add(InBits);
+	AddToConnection(InConnection, InName, InBits);
+}
+
+void UMeleeNetProfilerSubsystem::SampleManagerProperties(UAdvancedWeaponManager* InManager)
+{
+	if (!IsValid(InManager) || !IsValid(InManager->GetOwner()))
+		return;
+
+	const TArray<FProperty*>& properties = GetManagerNetProperties();
+	TSharedPtr<FMeleePropertyShadow>& shadow = ManagerShadows.FindOrAdd(InManager);
+	if (!shadow.IsValid())
+	{
+		shadow = MakeShared<FMeleePropertyShadow>(properties);
+	}
+
+	// Connections the owner replicates to
+	TArray<UNetConnection*> connections;
+	GatherConnections(connections);
+	AActor* owner = InManager->GetOwner();
+	connections.RemoveAllSwap([owner](UNetConnection* InConnection) {
+		return !InConnection->FindActorChannelRef(owner);
+	});
+	if (connections.Num() == 0)
+		return;
+
+	for (int32 i = 0; i < properties.Num(); ++i)
+	{
+		const void* value = properties[i]->ContainerPtrToValuePtr<void>(InManager);
+		if (!shadow->Update(i, value))
+			continue;
+
+		// Property handle and value
+		const int64 bits = 8 + EstimateNetBits(properties[i], value);
+		for (UNetConnection* connection : connections)
+		{
+			RecordProperty(properties[i]->GetFName(), connection, bits);
+		}
+	}
+}
+
+void UMeleeNetProfilerSubsystem::FinishWindow()
+{
+#if CSV_PROFILER
+	const uint32 category = CSV_CATEGORY_INDEX(MeleeMaster);
+	const float seconds = FMath::Max(LastWindowSeconds, KINDA_SMALL_NUMBER);
+	for (const TPair<FName, FMeleeNetStat>& pair : Current.Rpcs)
+	{
+		FCsvProfiler::RecordCustomStat(FName(*(TEXT("NetRpcBytes_") + pair.Key.ToString())), category,
+			pair.Value.Bits / 8.0f / seconds, ECsvCustomStatOp::Set);
+	}
+	for (const TPair<FName, FMeleeNetStat>& pair : Current.Properties)
+	{
+		FCsvProfiler::RecordCustomStat(FName(*(TEXT("NetPropertyBytes_") + pair.Key.ToString())), category,
+			pair.Value.Bits / 8.0f / seconds, ECsvCustomStatOp::Set);
+	}
+#endif
+
+	// Destroyed managers
+	for (auto it = ManagerShadows.CreateIterator(); it; ++it)
+	{
+		if (!it->Key.ResolveObjectPtr())
+		{
+			it.RemoveCurrent();
+		}
+	}
+
+	Last = MoveTemp(Current);
+	Current.Reset();
+}
+
+void UMeleeNetProfilerSubsystem::Dump(FOutputDevice& Ar) const
+{
+	const float seconds = FMath::Max(LastWindowSeconds, KINDA_SMALL_NUMBER);
+	auto dumpStats = [&](const TCHAR* InTitle, const TMap<FName, FMeleeNetStat>& InStats) {
+		TArray<TPair<FName, FMeleeNetStat>> sorted = InStats.Array();
+		sorted.Sort([](const TPair<FName, FMeleeNetStat>& A, const TPair<FName, FMeleeNetStat>& B) {
+			return A.Value.Bits > B.Value.Bits;
+		});
+		Ar.Logf(TEXT("%-40s %10s %12s"), InTitle, TEXT("Count/s"), TEXT("Bytes/s"));
+		for (const TPair<FName, FMeleeNetStat>& pair : sorted)
+		{
+			Ar.Logf(TEXT("%-40s %10.1f %12.1f"), *pair.Key.ToString(), pair.Value.Count / seconds,
+				pair.Value.Bits / 8.0f / seconds);
+		}
+	};
+
+	Ar.Logf(TEXT("MeleeMaster traffic, last %.2f sec"), seconds);
+	dumpStats(TEXT("RPC"), Last.Rpcs);
+	dumpStats(TEXT("Property (estimated) / subobject"), Last.Properties);
+
+	TArray<const FMeleeNetConnectionStats*> connections;
+	for (const TPair<TObjectKey<UNetConnection>, FMeleeNetConnectionStats>& pair : Last.Connections)
+	{
+		connections.Add(&pair.Value);
+	}
+	connections.Sort([](const FMeleeNetConnectionStats& A, const FMeleeNetConnectionStats& B) {
+		return A.Total.Bits > B.Total.Bits;
+	});
+	Ar.Logf(TEXT("%-40s %10s %12s  %s"), TEXT("Connection"), TEXT("Count/s"), TEXT("Bytes/s"), TEXT("Top message"));
+	for (const FMeleeNetConnectionStats* stats : connections)
+	{
+		FName top = NAME_None;
+		int64 topBits = 0;
+		for (const TPair<FName, FMeleeNetStat>& pair : stats->Messages)
+		{
+			if (pair.Value.Bits > topBits)
+			{
+				top = pair.Key;
+				topBits = pair.Value.Bits;
+			}
+		}
+		Ar.Logf(TEXT("%-40s %10.1f %12.1f  %s"), *stats->Name, stats->Total.Count / seconds,
+			stats->Total.Bits / 8.0f / seconds, *top.ToString());
+	}
+}
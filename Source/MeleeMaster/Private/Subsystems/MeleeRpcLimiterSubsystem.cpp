@@ -0,0 +1,237 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeRpcLimiterSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Subsystems/LoggerLib.h"
+
+static TAutoConsoleVariable<bool> CVarMeleeNetRateLimit(
+	TEXT("melee.Net.RateLimit"),
+	true,
+	TEXT("Drops combat RPCs of a client connection above the token bucket rate."));
+
+static TAutoConsoleVariable<bool> CVarMeleeNetCoalesce(
+	TEXT("melee.Net.Coalesce"),
+	true,
+	TEXT("Queues combat RPCs of a manager until the end of the net tick and collapses a command followed by\n")
+	TEXT("its duplicate or its inverse (Block, UnBlock runs as UnBlock). Arrival order is kept."));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdMeleeNetLimiter(
+	TEXT("melee.Net.Limiter"),
+	TEXT("Prints accepted, dropped and coalesced combat RPCs per client connection."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& InArgs, UWorld* InWorld, FOutputDevice& Ar) {
+			if (UMeleeRpcLimiterSubsystem* limiter = UMeleeRpcLimiterSubsystem::Get(InWorld))
+			{
+				limiter->Dump(Ar);
+			}
+		}));
+
+bool UMeleeRpcLimiterSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UMeleeRpcLimiterSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PostTickDispatchHandle = GetWorld()->OnPostTickDispatch().AddUObject(this,
+		&UMeleeRpcLimiterSubsystem::FlushQueues);
+}
+
+void UMeleeRpcLimiterSubsystem::Deinitialize()
+{
+	GetWorld()->OnPostTickDispatch().Remove(PostTickDispatchHandle);
+	Connections.Empty();
+	Queues.Empty();
+	Super::Deinitialize();
+}
+
+UMeleeRpcLimiterSubsystem* UMeleeRpcLimiterSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UMeleeRpcLimiterSubsystem>();
+	}
+	return nullptr;
+}
+
+bool UMeleeRpcLimiterSubsystem::IsReleaseInput(EMeleeInputType InType)
+{
+	return InType == EMeleeInputType::UnBlock
+		|| InType == EMeleeInputType::CancelCharge
+		|| InType == EMeleeInputType::Attack;
+}
+
+bool UMeleeRpcLimiterSubsystem::IsSameInput(const FMeleeInputCommand& InA, const FMeleeInputCommand& InB)
+{
+	return InA.Type == InB.Type && InA.Index == InB.Index && InA.Direction == InB.Direction;
+}
+
+bool UMeleeRpcLimiterSubsystem::IsInverseInput(const FMeleeInputCommand& InPrevious,
+	const FMeleeInputCommand& InNext)
+{
+	switch (InNext.Type)
+	{
+	case EMeleeInputType::UnBlock:
+		return InPrevious.Type == EMeleeInputType::Block;
+	case EMeleeInputType::CancelCharge:
+		return InPrevious.Type == EMeleeInputType::StartAttack
+			|| InPrevious.Type == EMeleeInputType::StartAttackSimple;
+	case EMeleeInputType::DeEquip:
+		return InPrevious.Type == EMeleeInputType::Equip && InPrevious.Index == InNext.Index;
+	case EMeleeInputType::RemoveShield:
+		return InPrevious.Type == EMeleeInputType::GetShield;
+	default:
+		return false;
+	}
+}
+
+bool UMeleeRpcLimiterSubsystem::AcceptInput(UAdvancedWeaponManager* InManager, UNetConnection* InConnection,
+	const FMeleeInputCommand& InCommand)
+{
+	const bool bRateLimit = CVarMeleeNetRateLimit.GetValueOnGameThread();
+	const bool bCoalesce = CVarMeleeNetCoalesce.GetValueOnGameThread();
+	if (!bRateLimit && !bCoalesce)
+		return true;
+
+	FMeleeRpcLimiterConnection& connection = Connections.FindOrAdd(InConnection);
+	if (bRateLimit)
+	{
+		const double time = GetWorld()->GetRealTimeSeconds();
+		connection.Tokens = connection.LastRefillTime < 0.0
+			? BurstSize
+			: FMath::Min(BurstSize, connection.Tokens + static_cast<float>(time - connection.LastRefillTime) *
+				TokensPerSecond);
+		connection.LastRefillTime = time;
+
+		if (connection.Tokens < 1.0f && !IsReleaseInput(InCommand.Type))
+		{
+			++connection.Dropped;
+			INC_DWORD_STAT(STAT_MeleeRpcsDropped);
+			if (connection.LastWarnTime < 0.0 || time - connection.LastWarnTime >= WarnInterval)
+			{
+				connection.LastWarnTime = time;
+				TRACEWARN(LogWeapon, "%s exceeds %.1f combat RPCs per second, %lld dropped",
+					*GetNameSafe(InConnection->PlayerController), TokensPerSecond, connection.Dropped);
+			}
+			return false;
+		}
+		connection.Tokens = FMath::Max(connection.Tokens - 1.0f, 0.0f);
+	}
+	++connection.Accepted;
+
+	if (!bCoalesce)
+		return true;
+
+	FMeleeRpcLimiterQueue* queue = Queues.FindByPredicate([InManager](const FMeleeRpcLimiterQueue& InQueue) {
+		return InQueue.Manager.Get() == InManager;
+	});
+	if (!queue)
+	{
+		queue = &Queues.AddDefaulted_GetRef();
+		queue->Manager = InManager;
+	}
+
+	// Only the tail is collapsed, a command repeated or undone by the next one is not needed
+	int32 collapsed = 0;
+	while (queue->Commands.Num() > 0 && (IsSameInput(queue->Commands.Last(), InCommand)
+		|| IsInverseInput(queue->Commands.Last(), InCommand)))
+	{
+		queue->Commands.Pop();
+		++collapsed;
+	}
+	if (collapsed > 0)
+	{
+		connection.Coalesced += collapsed;
+		INC_DWORD_STAT_BY(STAT_MeleeRpcsCoalesced, collapsed);
+	}
+	queue->Commands.Add(InCommand);
+	return false;
+}
+
+void UMeleeRpcLimiterSubsystem::FlushQueues()
+{
+	if (Queues.Num() > 0)
+	{
+		// ExecuteInput is not limited, nothing is queued while the queues are executed
+		TArray<FMeleeRpcLimiterQueue> queues = MoveTemp(Queues);
+		Queues.Reset();
+		for (const FMeleeRpcLimiterQueue& queue : queues)
+		{
+			UAdvancedWeaponManager* manager = queue.Manager.Get();
+			if (!IsValid(manager))
+				continue;
+
+			for (const FMeleeInputCommand& command : queue.Commands)
+			{
+				manager->ExecuteInput(command);
+			}
+		}
+	}
+
+	RemoveClosedConnections();
+}
+
+void UMeleeRpcLimiterSubsystem::RemoveClosedConnections()
+{
+	const UNetDriver* driver = GetWorld()->GetNetDriver();
+	const int32 openNum = driver ? driver->ClientConnections.Num() : 0;
+	if (Connections.Num() <= openNum)
+		return;
+
+	for (auto it = Connections.CreateIterator(); it; ++it)
+	{
+		const UNetConnection* connection = it.Key().ResolveObjectPtr();
+		if (!connection || connection->GetConnectionState() == USOCK_Closed)
+		{
+			it.RemoveCurrent();
+		}
+	}
+}
+
+const FMeleeRpcLimiterConnection* UMeleeRpcLimiterSubsystem::FindConnection(const UNetConnection* InConnection) const
+{
+	return Connections.Find(InConnection);
+}
+
+const FMeleeRpcLimiterQueue* UMeleeRpcLimiterSubsystem::FindQueue(const UAdvancedWeaponManager* InManager) const
+{
+	return Queues.FindByPredicate([InManager](const FMeleeRpcLimiterQueue& InQueue) {
+		return InQueue.Manager.Get() == InManager;
+	});
+}
+
+void UMeleeRpcLimiterSubsystem::RemoveConnection(const UNetConnection* InConnection)
+{
+	Connections.Remove(InConnection);
+}
+
+void UMeleeRpcLimiterSubsystem::Dump(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("MeleeMaster RPC limiter (%s): rate limit %s, coalesce %s, %.1f/s, burst %.0f"),
+		*GetWorld()->GetName(),
+		CVarMeleeNetRateLimit.GetValueOnGameThread() ? TEXT("on") : TEXT("off"),
+		CVarMeleeNetCoalesce.GetValueOnGameThread() ? TEXT("on") : TEXT("off"),
+		TokensPerSecond, BurstSize);
+	for (const TPair<TObjectKey<UNetConnection>, FMeleeRpcLimiterConnection>& pair : Connections)
+	{
+		const UNetConnection* connection = pair.Key.ResolveObjectPtr();
+		if (!connection)
+			continue;
+
+		const FMeleeRpcLimiterConnection& stats = pair.Value;
+		Ar.Logf(TEXT("  %-32s accepted %8lld  dropped %8lld  coalesced %8lld  tokens %5.1f"),
+			*GetNameSafe(connection->PlayerController), stats.Accepted, stats.Dropped, stats.Coalesced,
+			stats.Tokens);
+	}
+}
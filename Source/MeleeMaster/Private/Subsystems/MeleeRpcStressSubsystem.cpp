@@ -0,0 +1,566 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeRpcStressSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Data/MeleeWeaponDataAsset.h"
+#include "Dom/JsonObject.h"
+#include "Engine/DemoNetConnection.h"
+#include "Engine/World.h"
+#include "Objects/MeleeWeapon.h"
+#include "Subsystems/LoggerLib.h"
+#include "Subsystems/MeleeRpcLimiterSubsystem.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMeleeStressRpc(
+	TEXT("melee.Stress.Rpc"),
+	TEXT("melee.Stress.Rpc N [Seconds=20] [Seed] - floods N fighters with random combat input, results are written to Saved/Profiling/MeleeStress."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld) {
+		UMeleeRpcStressSubsystem* stress = UMeleeRpcStressSubsystem::Get(InWorld);
+		if (!stress)
+			return;
+
+		const int32 size = InArgs.Num() > 0 ? FCString::Atoi(*InArgs[0]) : 10;
+		const float duration = InArgs.Num() > 1 ? FCString::Atof(*InArgs[1]) : 20.0f;
+		const int32 seed = InArgs.Num() > 2 ? FCString::Atoi(*InArgs[2]) : FMath::Rand();
+		stress->Start(size, duration, seed);
+	}));
+
+static FAutoConsoleCommandWithWorld CmdMeleeStressLimiter(
+	TEXT("melee.Stress.Limiter"),
+	TEXT("Checks RPC limiter drops and coalescing with fake client connections, results are written to Saved/Profiling/MeleeStress."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* InWorld) {
+		if (UMeleeRpcStressSubsystem* stress = UMeleeRpcStressSubsystem::Get(InWorld))
+		{
+			stress->CheckLimiter();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdMeleeStressStop(
+	TEXT("melee.Stress.Stop"),
+	TEXT("Stops the running combat input stress without results."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* InWorld) {
+		if (UMeleeRpcStressSubsystem* stress = UMeleeRpcStressSubsystem::Get(InWorld))
+		{
+			stress->Stop();
+		}
+	}));
+
+namespace MeleeRpcStress
+{
+	/** Input sent above the burst by the limiter check */
+	static constexpr int32 LimiterExtraInputNum = 10;
+
+	/** Server RPCs under stress */
+	static constexpr EMeleeInputType InputTypes[] = {
+		EMeleeInputType::StartAttack,
+		EMeleeInputType::Attack,
+		EMeleeInputType::Block,
+		EMeleeInputType::UnBlock,
+		EMeleeInputType::Equip,
+		EMeleeInputType::Change,
+		EMeleeInputType::GetShield,
+		EMeleeInputType::RemoveShield
+	};
+}
+
+bool UMeleeRpcStressSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return FMeleeHarnessFixture::DoesSupportWorldType(WorldType);
+}
+
+void UMeleeRpcStressSubsystem::Deinitialize()
+{
+	FMeleeStateMachine::OnTransition.Remove(TransitionHandle);
+	UAdvancedWeaponManager::OnDamageDealt.Remove(DamageDealtHandle);
+	Phase = EMeleeStressPhase::None;
+	Managers.Empty();
+	Swings.Empty();
+	Super::Deinitialize();
+}
+
+TStatId UMeleeRpcStressSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeleeRpcStressSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UMeleeRpcStressSubsystem::IsTickable() const
+{
+	return IsRunning();
+}
+
+UMeleeRpcStressSubsystem* UMeleeRpcStressSubsystem::Get(const UObject* WorldContextObject)
+{
+	return FMeleeHarnessFixture::GetSubsystem<UMeleeRpcStressSubsystem>(WorldContextObject);
+}
+
+bool UMeleeRpcStressSubsystem::Start(int32 InSize, float InDuration, int32 InSeed)
+{
+	if (IsRunning())
+	{
+		TRACEWARN(LogWeapon, "Melee stress is already running");
+		return false;
+	}
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		TRACEERROR(LogWeapon, "Melee stress must run on the server");
+		return false;
+	}
+
+	RunSize = FMath::Max(InSize, 2);
+	FloodDuration = FMath::Max(InDuration, 1.0f);
+	Seed = InSeed;
+	Random.Initialize(Seed);
+	InputDebt = 0.0;
+	StaleDamageNum = 0;
+	DoubleDamageNum = 0;
+	InvalidTransitionNum = 0;
+	Violations.Reset();
+	Swings.Reset();
+	for (FMeleeStressInputStat& stat : InputStats)
+	{
+		stat = FMeleeStressInputStat();
+	}
+
+	if (!SpawnFighters(RunSize))
+	{
+		DestroyFighters();
+		return false;
+	}
+
+	TransitionHandle = FMeleeStateMachine::OnTransition.AddUObject(this, &UMeleeRpcStressSubsystem::OnTransition);
+	DamageDealtHandle = UAdvancedWeaponManager::OnDamageDealt.AddUObject(this,
+		&UMeleeRpcStressSubsystem::OnDamageDealt);
+	PhaseStartTime = GetWorld()->GetTimeSeconds();
+	Phase = EMeleeStressPhase::Warmup;
+	TRACE(LogWeapon, "Melee stress started: %d fighters, %.1f sec, seed %d", RunSize, FloodDuration, Seed);
+	return true;
+}
+
+void UMeleeRpcStressSubsystem::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	FMeleeStateMachine::OnTransition.Remove(TransitionHandle);
+	TransitionHandle.Reset();
+	UAdvancedWeaponManager::OnDamageDealt.Remove(DamageDealtHandle);
+	DamageDealtHandle.Reset();
+	Phase = EMeleeStressPhase::None;
+	DestroyFighters();
+	Swings.Reset();
+	TRACE(LogWeapon, "Melee stress stopped");
+}
+
+bool UMeleeRpcStressSubsystem::SpawnFighters(int32 InSize)
+{
+	const FMeleeHarnessFixture fixture = GetFixture();
+	UWeaponDataAsset* weapon = fixture.LoadWeapon();
+	TArray<UAdvancedWeaponManager*> managers;
+	const bool bSpawned = fixture.SpawnFighters(GetWorld(), InSize, managers);
+
+	Managers.Reserve(managers.Num());
+	for (UAdvancedWeaponManager* manager : managers)
+	{
+		if (weapon)
+		{
+			manager->AddNewWeapon(weapon);
+			manager->AddNewWeapon(weapon);
+		}
+		manager->ExecuteInput(FMeleeInputCommand(EMeleeInputType::Equip, 0));
+		Managers.Add(manager);
+	}
+	return bSpawned;
+}
+
+void UMeleeRpcStressSubsystem::DestroyFighters()
+{
+	for (const TWeakObjectPtr<UAdvancedWeaponManager>& manager : Managers)
+	{
+		if (manager.IsValid() && manager->GetOwner())
+		{
+			manager->GetOwner()->Destroy();
+		}
+	}
+	Managers.Reset();
+}
+
+bool UMeleeRpcStressSubsystem::CheckLimiter()
+{
+	if (IsRunning())
+	{
+		TRACEWARN(LogWeapon, "Melee stress is running");
+		return false;
+	}
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		TRACEERROR(LogWeapon, "Melee limiter check must run on the server");
+		return false;
+	}
+	UMeleeRpcLimiterSubsystem* limiter = UMeleeRpcLimiterSubsystem::Get(this);
+	IConsoleVariable* rateLimit = IConsoleManager::Get().FindConsoleVariable(TEXT("melee.Net.RateLimit"));
+	IConsoleVariable* coalesce = IConsoleManager::Get().FindConsoleVariable(TEXT("melee.Net.Coalesce"));
+	if (!limiter || !rateLimit || !coalesce)
+	{
+		TRACEERROR(LogWeapon, "Melee RPC limiter is not available");
+		return false;
+	}
+
+	TArray<FString> errors;
+	TArray<UAdvancedWeaponManager*> managers;
+	if (!GetFixture().SpawnFighters(GetWorld(), 2, managers) || managers.Num() < 2)
+	{
+		errors.Add(TEXT("Failed to spawn fighters"));
+	}
+	else
+	{
+		const bool bPreviousRateLimit = rateLimit->GetBool();
+		const bool bPreviousCoalesce = coalesce->GetBool();
+		rateLimit->Set(true, ECVF_SetByCode);
+		coalesce->Set(true, ECVF_SetByCode);
+
+		// Never opened, only identify a client for the limiter
+		UNetConnection* floodConnection = NewObject<UDemoNetConnection>(GetTransientPackage());
+		UNetConnection* orderConnection = NewObject<UDemoNetConnection>(GetTransientPackage());
+
+		// One frame, the bucket starts full and is not refilled
+		const int32 burst = FMath::Max(FMath::FloorToInt(limiter->GetBurstSize()), 0);
+		const int32 sent = burst + MeleeRpcStress::LimiterExtraInputNum;
+		// Directions differ, nothing is collapsed
+		for (int32 i = 0; i < sent; ++i)
+		{
+			limiter->AcceptInput(managers[0], floodConnection, FMeleeInputCommand(EMeleeInputType::StartAttack,
+				INDEX_NONE, static_cast<EWeaponDirection>(i % 4)));
+		}
+		// The bucket is empty, release input must pass and undo the last StartAttack
+		limiter->AcceptInput(managers[0], floodConnection, FMeleeInputCommand(EMeleeInputType::CancelCharge));
+		const int32 expectedCoalesced = burst > 0 ? 1 : 0;
+		if (const FMeleeRpcLimiterConnection* stats = limiter->FindConnection(floodConnection))
+		{
+			if (stats->Accepted != burst + 1 || stats->Dropped != sent - burst)
+			{
+				errors.Add(FString::Printf(TEXT("Flood: %lld accepted, %lld dropped, expected %d, %d"),
+					stats->Accepted, stats->Dropped, burst + 1, sent - burst));
+			}
+			if (stats->Coalesced != expectedCoalesced)
+			{
+				errors.Add(FString::Printf(TEXT("Flood: %lld coalesced, expected %d"), stats->Coalesced,
+					expectedCoalesced));
+			}
+		}
+		else
+		{
+			errors.Add(TEXT("Flood: connection is not tracked"));
+		}
+		const FMeleeRpcLimiterQueue* floodQueue = limiter->FindQueue(managers[0]);
+		if (!floodQueue || floodQueue->Commands.Num() != burst - expectedCoalesced + 1
+			|| floodQueue->Commands.Last().Type != EMeleeInputType::CancelCharge)
+		{
+			errors.Add(TEXT("Flood: accepted StartAttacks and the final CancelCharge are not queued in order"));
+		}
+
+		// Arrival order is kept, only the tail is collapsed by a duplicate or an inverse
+		const FMeleeInputCommand sentOrder[] = {
+			FMeleeInputCommand(EMeleeInputType::Block, INDEX_NONE, EWeaponDirection::Left),
+			FMeleeInputCommand(EMeleeInputType::Equip, 1),
+			FMeleeInputCommand(EMeleeInputType::Block, INDEX_NONE, EWeaponDirection::Right),
+			FMeleeInputCommand(EMeleeInputType::Block, INDEX_NONE, EWeaponDirection::Right),
+			FMeleeInputCommand(EMeleeInputType::UnBlock)
+		};
+		const FMeleeInputCommand expectedOrder[] = {sentOrder[0], sentOrder[1], sentOrder[4]};
+		const int32 expectedNum = UE_ARRAY_COUNT(expectedOrder);
+		for (const FMeleeInputCommand& command : sentOrder)
+		{
+			limiter->AcceptInput(managers[1], orderConnection, command);
+		}
+		const FMeleeRpcLimiterQueue* orderQueue = limiter->FindQueue(managers[1]);
+		bool bOrderMatched = orderQueue && orderQueue->Commands.Num() == expectedNum;
+		for (int32 i = 0; bOrderMatched && i < expectedNum; ++i)
+		{
+			bOrderMatched = UMeleeRpcLimiterSubsystem::IsSameInput(orderQueue->Commands[i], expectedOrder[i]);
+		}
+		if (!bOrderMatched)
+		{
+			errors.Add(TEXT("Order: Block, Equip, Block, Block, UnBlock is not queued as Block, Equip, UnBlock"));
+		}
+
+		rateLimit->Set(bPreviousRateLimit, ECVF_SetByCode);
+		coalesce->Set(bPreviousCoalesce, ECVF_SetByCode);
+		limiter->RemoveConnection(floodConnection);
+		limiter->RemoveConnection(orderConnection);
+	}
+
+	// Queued input of destroyed managers is skipped by the limiter
+	for (const UAdvancedWeaponManager* manager : managers)
+	{
+		if (IsValid(manager) && manager->GetOwner())
+		{
+			manager->GetOwner()->Destroy();
+		}
+	}
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("burstSize"), limiter->GetBurstSize());
+	json->SetBoolField(TEXT("passed"), errors.Num() == 0);
+	TArray<TSharedPtr<FJsonValue>> errorValues;
+	for (const FString& error : errors)
+	{
+		TRACEERROR(LogWeapon, "Melee limiter check: %s", *error);
+		errorValues.Add(MakeShared<FJsonValueString>(error));
+	}
+	json->SetArrayField(TEXT("errors"), errorValues);
+	const FString path = FMeleeHarnessFixture::WriteResults(json, TEXT("MeleeStress"), TEXT("Limiter"));
+	TRACE(LogWeapon, "Melee limiter check %s: %s", errors.Num() == 0 ? TEXT("passed") : TEXT("failed"), *path);
+	return errors.Num() == 0;
+}
+
+FMeleeInputCommand UMeleeRpcStressSubsystem::MakeRandomInput(const UAdvancedWeaponManager* InManager)
+{
+	using namespace MeleeRpcStress;
+
+	FMeleeInputCommand command;
+	command.Type = InputTypes[Random.RandRange(0, UE_ARRAY_COUNT(InputTypes) - 1)];
+	command.Direction = static_cast<EWeaponDirection>(Random.RandRange(0, 3));
+	// Invalid indices are part of the stress
+	command.Index = Random.RandRange(INDEX_NONE, InManager->WeaponNum());
+	return command;
+}
+
+void UMeleeRpcStressSubsystem::Flood(float InDeltaTime)
+{
+	InputDebt += static_cast<double>(InputRate) * InDeltaTime * Managers.Num();
+	const int32 num = FMath::FloorToInt(InputDebt);
+	InputDebt -= num;
+
+	Batch.Reset(num * 2);
+	for (int32 i = 0; i < num; ++i)
+	{
+		const int32 managerIndex = Random.RandRange(0, Managers.Num() - 1);
+		const UAdvancedWeaponManager* manager = Managers[managerIndex].Get();
+		if (!manager)
+			continue;
+
+		const FMeleeInputCommand command = MakeRandomInput(manager);
+		Batch.Emplace(managerIndex, command);
+		if (Random.FRand() < DuplicateChance)
+		{
+			Batch.Emplace(managerIndex, command);
+		}
+	}
+
+	// Reorder input of the frame
+	for (int32 i = Batch.Num() - 1; i > 0; --i)
+	{
+		Batch.Swap(i, Random.RandRange(0, i));
+	}
+
+	const double nsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1e9;
+	for (const TPair<int32, FMeleeInputCommand>& input : Batch)
+	{
+		UAdvancedWeaponManager* manager = Managers[input.Key].Get();
+		if (!manager)
+			continue;
+
+		const uint64 startCycles = FPlatformTime::Cycles64();
+		manager->ExecuteInput(input.Value);
+		const uint64 cycles = FPlatformTime::Cycles64() - startCycles;
+
+		FMeleeStressInputStat& stat = InputStats[static_cast<int32>(input.Value.Type)];
+		++stat.Num;
+		stat.Cycles += cycles;
+		stat.MaxCycles = FMath::Max(stat.MaxCycles, cycles);
+		stat.Histogram.Add(static_cast<uint64>(cycles * nsPerCycle));
+	}
+}
+
+void UMeleeRpcStressSubsystem::Release()
+{
+	for (const TWeakObjectPtr<UAdvancedWeaponManager>& manager : Managers)
+	{
+		if (!manager.IsValid())
+			continue;
+
+		const EWeaponFightingStatus status = manager->GetFightingStatus();
+		if (status == EWeaponFightingStatus::AttackCharging || status == EWeaponFightingStatus::RangeCharging)
+		{
+			manager->ExecuteInput(FMeleeInputCommand(EMeleeInputType::CancelCharge));
+		}
+		else if (status == EWeaponFightingStatus::BlockCharging)
+		{
+			manager->ExecuteInput(FMeleeInputCommand(EMeleeInputType::UnBlock));
+		}
+	}
+}
+
+void UMeleeRpcStressSubsystem::Tick(float DeltaTime)
+{
+	const double now = GetWorld()->GetTimeSeconds();
+	const double time = now - PhaseStartTime;
+	switch (Phase)
+	{
+	case EMeleeStressPhase::Warmup:
+		if (time >= WarmupTime)
+		{
+			PhaseStartTime = now;
+			Phase = EMeleeStressPhase::Flood;
+		}
+		break;
+	case EMeleeStressPhase::Flood:
+		Flood(DeltaTime);
+		if (time >= FloodDuration)
+		{
+			PhaseStartTime = now;
+			Phase = EMeleeStressPhase::Settle;
+		}
+		break;
+	case EMeleeStressPhase::Settle:
+		// Charges and blocks are held until released, pending timers finish on their own
+		Release();
+		if (time >= SettleTime)
+		{
+			CheckInvariants();
+			const FString path = WriteResults();
+			TRACE(LogWeapon, "Melee stress finished: %d violations, %s", Violations.Num(), *path);
+			Stop();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void UMeleeRpcStressSubsystem::OnTransition(UAdvancedWeaponManager* InManager,
+	const FMeleeStateTransition& InTransition)
+{
+	if (!Managers.Contains(InManager))
+		return;
+
+	if (!InTransition.bValid)
+	{
+		++InvalidTransitionNum;
+	}
+	if (InTransition.bManaging || InTransition.To != static_cast<uint8>(EWeaponFightingStatus::Attacking))
+		return;
+
+	// New swing, direction is already set
+	Swings.FindOrAdd(InManager).Hits.Reset();
+}
+
+void UMeleeRpcStressSubsystem::OnDamageDealt(UAdvancedWeaponManager* InCauser, AActor* InVictim,
+	EDamageReturn InResult, float InDamage)
+{
+	if (!IsRunning() || !IsValid(InVictim) || !Managers.Contains(InCauser))
+		return;
+
+	if (InCauser->GetFightingStatus() != EWeaponFightingStatus::Attacking)
+	{
+		++StaleDamageNum;
+		AddViolation(FString::Printf(TEXT("%s damaged %s in %s"), *GetNameSafe(InCauser->GetOwner()),
+			*InVictim->GetName(), *UEnum::GetDisplayValueAsText(InCauser->GetFightingStatus()).ToString()));
+		return;
+	}
+
+	FMeleeStressSwing* swing = Swings.Find(InCauser);
+	if (!swing)
+		return;
+
+	// Without the switch every hit path element reaching the victim deals damage
+	const UMeleeWeapon* weapon = Cast<UMeleeWeapon>(InCauser->GetCurrentWeapon());
+	const UMeleeWeaponDataAsset* data = weapon ? weapon->GetMeleeData() : nullptr;
+	if (!data || !data->bDamageOncePerSwing)
+		return;
+
+	const int32 hits = ++swing->Hits.FindOrAdd(InVictim);
+	if (hits > 1)
+	{
+		++DoubleDamageNum;
+		AddViolation(FString::Printf(TEXT("%s damaged %s %d times in one swing"),
+			*GetNameSafe(InCauser->GetOwner()), *InVictim->GetName(), hits));
+	}
+}
+
+void UMeleeRpcStressSubsystem::AddViolation(const FString& InViolation)
+{
+	if (Violations.Num() < MaxReportedViolations)
+	{
+		Violations.Add(InViolation);
+	}
+}
+
+void UMeleeRpcStressSubsystem::CheckInvariants()
+{
+	for (const TWeakObjectPtr<UAdvancedWeaponManager>& weakManager : Managers)
+	{
+		const UAdvancedWeaponManager* manager = weakManager.Get();
+		if (!manager)
+			continue;
+
+		const EWeaponManagingStatus managing = manager->GetManagingStatus();
+		const EWeaponFightingStatus fighting = manager->GetFightingStatus();
+		const bool bIdle = (managing == EWeaponManagingStatus::Idle || managing == EWeaponManagingStatus::NoWeapon)
+			&& fighting == EWeaponFightingStatus::Idle;
+		const int32 timers = manager->GetActiveTimerNum(true);
+		if (!bIdle)
+		{
+			AddViolation(FString::Printf(TEXT("%s stuck in %s / %s, %d timers"), *GetNameSafe(manager->GetOwner()),
+				*UEnum::GetDisplayValueAsText(managing).ToString(),
+				*UEnum::GetDisplayValueAsText(fighting).ToString(), timers));
+		}
+		else if (timers > 0)
+		{
+			AddViolation(FString::Printf(TEXT("%s is idle with %d combat timers"), *GetNameSafe(manager->GetOwner()),
+				timers));
+		}
+	}
+
+	if (InvalidTransitionNum > 0)
+	{
+		AddViolation(FString::Printf(TEXT("%d invalid state transitions"), InvalidTransitionNum));
+	}
+}
+
+FString UMeleeRpcStressSubsystem::WriteResults() const
+{
+	const double usPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1e6;
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("fighters"), RunSize);
+	json->SetNumberField(TEXT("seconds"), FloodDuration);
+	json->SetNumberField(TEXT("seed"), Seed);
+	json->SetNumberField(TEXT("inputRate"), InputRate);
+	json->SetNumberField(TEXT("duplicateChance"), DuplicateChance);
+
+	int64 inputNum = 0;
+	uint64 inputCycles = 0;
+	TSharedRef<FJsonObject> inputs = MakeShared<FJsonObject>();
+	for (const EMeleeInputType type : MeleeRpcStress::InputTypes)
+	{
+		const FMeleeStressInputStat& stat = InputStats[static_cast<int32>(type)];
+		inputNum += stat.Num;
+		inputCycles += stat.Cycles;
+
+		TSharedRef<FJsonObject> input = MakeShared<FJsonObject>();
+		input->SetNumberField(TEXT("num"), stat.Num);
+		input->SetNumberField(TEXT("meanUs"), stat.Num > 0 ? stat.Cycles * usPerCycle / stat.Num : 0.0);
+		input->SetNumberField(TEXT("p50Us"), stat.Histogram.GetPercentile(0.5f) / 1000.0);
+		input->SetNumberField(TEXT("p99Us"), stat.Histogram.GetPercentile(0.99f) / 1000.0);
+		input->SetNumberField(TEXT("maxUs"), stat.MaxCycles * usPerCycle);
+		inputs->SetObjectField(UEnum::GetValueAsString(type), input);
+	}
+	json->SetObjectField(TEXT("inputs"), inputs);
+	json->SetNumberField(TEXT("inputNum"), inputNum);
+	json->SetNumberField(TEXT("inputsPerSec"), inputNum / FloodDuration);
+	json->SetNumberField(TEXT("meanInputUs"), inputNum > 0 ? inputCycles * usPerCycle / inputNum : 0.0);
+	json->SetNumberField(TEXT("staleDamage"), StaleDamageNum);
+	json->SetNumberField(TEXT("doubleDamage"), DoubleDamageNum);
+	json->SetBoolField(TEXT("passed"), Violations.Num() == 0);
+
+	TArray<TSharedPtr<FJsonValue>> violations;
+	for (const FString& violation : Violations)
+	{
+		violations.Add(MakeShared<FJsonValueString>(violation));
+	}
+	json->SetArrayField(TEXT("violations"), violations);
+
+	return FMeleeHarnessFixture::WriteResults(json, TEXT("MeleeStress"), FString::Printf(TEXT("Rpc_%d"), RunSize));
+}
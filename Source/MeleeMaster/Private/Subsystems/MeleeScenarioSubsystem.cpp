@@ -0,0 +1,698 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeScenarioSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Algo/Count.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Curves/CurveFloat.h"
+#include "Data/MeleeWeaponAnimDataAsset.h"
+#include "Data/MeleeWeaponDataAsset.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "Misc/App.h"
+#include "Objects/MeleeWeapon.h"
+#include "Subsystems/LoggerLib.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMeleeScenarioRun(
+	TEXT("melee.Scenario.Run"),
+	TEXT("melee.Scenario.Run [Name] - runs state machine scenarios (all if no name), results are written to Saved/Profiling/MeleeScenario."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld) {
+		if (UMeleeScenarioSubsystem* scenario = UMeleeScenarioSubsystem::Get(InWorld))
+		{
+			scenario->Run(InArgs.Num() > 0 ? InArgs[0] : FString());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdMeleeScenarioStop(
+	TEXT("melee.Scenario.Stop"),
+	TEXT("Stops running scenarios and writes results gathered so far."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* InWorld) {
+		if (UMeleeScenarioSubsystem* scenario = UMeleeScenarioSubsystem::Get(InWorld))
+		{
+			scenario->Stop();
+		}
+	}));
+
+namespace MeleeScenario
+{
+	static const TCHAR* BuiltInNames[] = {
+		TEXT("Swing"),
+		TEXT("CancelCharge"),
+		TEXT("BlockRelease"),
+		TEXT("ChargeToBlock"),
+		TEXT("ParryStun"),
+		TEXT("ShieldDurability")
+	};
+
+	static void AddStep(FMeleeScenario& OutScenario, float InTime, EMeleeInputType InType, int32 InActor = 0)
+	{
+		FMeleeScenarioStep& step = OutScenario.Steps.AddDefaulted_GetRef();
+		step.Time = InTime;
+		step.Actor = InActor;
+		step.Input = FMeleeInputCommand(InType, INDEX_NONE, EWeaponDirection::Forward);
+	}
+
+	static void AddHit(FMeleeScenario& OutScenario, float InTime, int32 InActor, float InDamage)
+	{
+		FMeleeScenarioStep& step = OutScenario.Steps.AddDefaulted_GetRef();
+		step.Time = InTime;
+		step.Actor = InActor;
+		step.Action = EMeleeScenarioAction::Hit;
+		step.Damage = InDamage;
+	}
+
+	static void Expect(FMeleeScenario& OutScenario, EWeaponFightingStatus InStatus, float InTime, float InTolerance,
+		int32 InActor = 0)
+	{
+		FMeleeScenarioExpectation& expectation = OutScenario.Expected.AddDefaulted_GetRef();
+		expectation.Actor = InActor;
+		expectation.Status = InStatus;
+		expectation.MinTime = FMath::Max(InTime - InTolerance, 0.0f);
+		expectation.MaxTime = InTime + InTolerance;
+	}
+
+	/**
+	 * @brief Charging curve value InTime after the charge started, as UAdvancedWeaponManager::EvaluateCurrentCurve.
+	 */
+	static float EvaluateCharge(const FWeaponCurveData& InData, float InTime, float InMinimal)
+	{
+		const UCurveFloat* curve = InData.Curve.LoadSynchronous();
+		if (!curve)
+			return InMinimal;
+
+		// Past the charge the last key is held
+		const float time = InTime > InData.CurveTime && curve->FloatCurve.GetNumKeys() > 0
+			? curve->FloatCurve.GetLastKey().Time
+			: FMath::Max(InTime, 0.0f);
+		return curve->GetFloatValue(time);
+	}
+}
+
+bool UMeleeScenarioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return FMeleeHarnessFixture::DoesSupportWorldType(WorldType);
+}
+
+void UMeleeScenarioSubsystem::Deinitialize()
+{
+	if (IsRunning())
+	{
+		PendingNames.Reset();
+		FinishRun();
+	}
+	Super::Deinitialize();
+}
+
+TStatId UMeleeScenarioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeleeScenarioSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UMeleeScenarioSubsystem::IsTickable() const
+{
+	return IsRunning();
+}
+
+UMeleeScenarioSubsystem* UMeleeScenarioSubsystem::Get(const UObject* WorldContextObject)
+{
+	return FMeleeHarnessFixture::GetSubsystem<UMeleeScenarioSubsystem>(WorldContextObject);
+}
+
+bool UMeleeScenarioSubsystem::Run(const FString& InName, UWeaponDataAsset* InWeapon)
+{
+	if (IsRunning())
+	{
+		TRACEWARN(LogWeapon, "Melee scenarios are already running");
+		return false;
+	}
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		TRACEERROR(LogWeapon, "Melee scenarios must run on the server");
+		return false;
+	}
+
+	PendingNames.Reset();
+	if (InName.IsEmpty())
+	{
+		for (const TCHAR* name : MeleeScenario::BuiltInNames)
+		{
+			PendingNames.Add(name);
+		}
+		for (const FMeleeScenario& scenario : Scenarios)
+		{
+			PendingNames.AddUnique(scenario.Name);
+		}
+	}
+	else
+	{
+		PendingNames.Add(InName);
+	}
+
+	Results.Reset();
+	LastResults.Reset();
+	FailedNum = 0;
+	WeaponOverride = InWeapon;
+
+	// Timers advance by the same step every frame
+	bPreviousFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FMath::Max(FixedStep, KINDA_SMALL_NUMBER));
+
+	TransitionHandle = FMeleeStateMachine::OnTransition.AddUObject(this, &UMeleeScenarioSubsystem::OnTransition);
+	TRACE(LogWeapon, "Melee scenarios started: %d", PendingNames.Num());
+	return StartNext();
+}
+
+void UMeleeScenarioSubsystem::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	PendingNames.Reset();
+	FinishScenario(TEXT("Stopped"));
+}
+
+bool UMeleeScenarioSubsystem::StartNext()
+{
+	if (PendingNames.Num() == 0)
+	{
+		FinishRun();
+		return false;
+	}
+
+	Current = FMeleeScenario();
+	Current.Name = PendingNames[0];
+	PendingNames.RemoveAt(0);
+	Transitions.Reset();
+	PhaseStartTime = GetWorld()->GetTimeSeconds();
+	Phase = EMeleeScenarioPhase::Equipping;
+	if (!SpawnFighters())
+	{
+		FinishScenario(TEXT("Failed to spawn fighters"));
+		return false;
+	}
+	return true;
+}
+
+bool UMeleeScenarioSubsystem::SpawnFighters()
+{
+	FMeleeHarnessFixture fixture = GetFixture();
+	if (IsValid(WeaponOverride))
+	{
+		fixture.Weapon = WeaponOverride;
+	}
+	UWeaponDataAsset* weapon = fixture.LoadWeapon();
+	TArray<UAdvancedWeaponManager*> managers;
+	const bool bSpawned = fixture.SpawnFighters(GetWorld(), 2, managers);
+
+	// 0 - attacker, 1 - defender
+	for (int32 side = 0; side < managers.Num(); ++side)
+	{
+		UAdvancedWeaponManager* manager = managers[side];
+		Managers[side] = manager;
+
+		const int32 weaponIndex = weapon ? manager->AddNewWeapon(weapon) : 0;
+		manager->ExecuteInput(FMeleeInputCommand(EMeleeInputType::Equip, FMath::Max(weaponIndex, 0)));
+	}
+	return bSpawned;
+}
+
+void UMeleeScenarioSubsystem::DestroyFighters()
+{
+	for (TWeakObjectPtr<UAdvancedWeaponManager>& manager : Managers)
+	{
+		if (manager.IsValid() && manager->GetOwner())
+		{
+			manager->GetOwner()->Destroy();
+		}
+		manager.Reset();
+	}
+}
+
+void UMeleeScenarioSubsystem::MakeBuiltInScenarios(const UAdvancedWeaponManager* InManager,
+	TArray<FMeleeScenario>& OutScenarios) const
+{
+	using namespace MeleeScenario;
+
+	UMeleeWeapon* meleeWeapon = Cast<UMeleeWeapon>(InManager->GetCurrentWeapon());
+	if (!IsValid(meleeWeapon) || !IsValid(meleeWeapon->GetMeleeData()))
+		return;
+
+	const UMeleeWeaponDataAsset* meleeData = meleeWeapon->GetMeleeData();
+	const FMeleeCombinedData& data = meleeWeapon->GetCurrentMeleeCombinedData();
+	const FMeleeAttackCurveData& attack = data.Attack.Get(EWeaponDirection::Forward);
+	const FMeleeBlockCurveData& block = data.Block.Get(EWeaponDirection::Forward);
+	// Input and timers are handled on the first frame after their time
+	const float tolerance = 2.0f * FixedStep;
+	const float pre = attack.PreAttackLen;
+	const float hold = 0.5f;
+
+	{
+		// Full attack: charge, release, hit, cooldown
+		FMeleeScenario& scenario = OutScenarios.AddDefaulted_GetRef();
+		scenario.Name = TEXT("Swing");
+		AddStep(scenario, 0.0f, EMeleeInputType::StartAttack);
+		AddStep(scenario, pre + hold, EMeleeInputType::Attack);
+		const float hitStart = pre + hold;
+		const float postStart = hitStart + attack.HittingTime;
+		Expect(scenario, EWeaponFightingStatus::PreAttack, 0.0f, tolerance);
+		Expect(scenario, EWeaponFightingStatus::AttackCharging, pre, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Attacking, hitStart, tolerance);
+		Expect(scenario, EWeaponFightingStatus::PostAttack, postStart, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Idle, postStart + attack.PostAttackLen, tolerance);
+		scenario.Duration = postStart + attack.PostAttackLen + hold;
+	}
+	{
+		FMeleeScenario& scenario = OutScenarios.AddDefaulted_GetRef();
+		scenario.Name = TEXT("CancelCharge");
+		AddStep(scenario, 0.0f, EMeleeInputType::StartAttack);
+		AddStep(scenario, pre + hold, EMeleeInputType::CancelCharge);
+		Expect(scenario, EWeaponFightingStatus::PreAttack, 0.0f, tolerance);
+		Expect(scenario, EWeaponFightingStatus::AttackCharging, pre, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Idle, pre + hold, tolerance);
+		scenario.Duration = pre + 2.0f * hold;
+	}
+	{
+		FMeleeScenario& scenario = OutScenarios.AddDefaulted_GetRef();
+		scenario.Name = TEXT("BlockRelease");
+		AddStep(scenario, 0.0f, EMeleeInputType::Block);
+		AddStep(scenario, hold, EMeleeInputType::UnBlock);
+		Expect(scenario, EWeaponFightingStatus::BlockCharging, 0.0f, tolerance);
+		Expect(scenario, EWeaponFightingStatus::PostBlock, hold, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Idle, hold + block.PostBlockLen, tolerance);
+		scenario.Duration = 2.0f * hold + block.PostBlockLen;
+	}
+	{
+		// Block interrupts attack charging
+		FMeleeScenario& scenario = OutScenarios.AddDefaulted_GetRef();
+		scenario.Name = TEXT("ChargeToBlock");
+		AddStep(scenario, 0.0f, EMeleeInputType::StartAttack);
+		AddStep(scenario, pre + hold, EMeleeInputType::Block);
+		AddStep(scenario, pre + 2.0f * hold, EMeleeInputType::UnBlock);
+		Expect(scenario, EWeaponFightingStatus::PreAttack, 0.0f, tolerance);
+		Expect(scenario, EWeaponFightingStatus::AttackCharging, pre, tolerance);
+		Expect(scenario, EWeaponFightingStatus::BlockCharging, pre + hold, tolerance);
+		Expect(scenario, EWeaponFightingStatus::PostBlock, pre + 2.0f * hold, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Idle, pre + 2.0f * hold + block.PostBlockLen, tolerance);
+		scenario.Duration = pre + 3.0f * hold + block.PostBlockLen;
+	}
+	{
+		// Defender parries a weak swing: attacker is stunned, the block turns into a charged attack
+		FMeleeScenario& scenario = OutScenarios.AddDefaulted_GetRef();
+		scenario.Name = TEXT("ParryStun");
+		// Shield only blocks, defender removes it first
+		const bool bShield = meleeWeapon->IsShieldEquipped();
+		const float start = bShield ? meleeData->ShieldRemoveTime + hold : 0.0f;
+		const float release = start + pre + hold;
+		const float hit = release + 0.5f * attack.HittingTime;
+		const FMeleeBlockCurveData& parryBlock = meleeData->Base.Block.Get(EWeaponDirection::Forward);
+		const float minimal = InManager->GetMinimalCurveValue();
+		const float step = FMath::Max(FixedStep, 1.0f / 240.0f);
+
+		// Input is handled up to a step late, so curve values are taken at the worst neighbour
+		const float attackValue = FMath::Max3(EvaluateCharge(attack, hold - step, minimal),
+			EvaluateCharge(attack, hold, minimal), EvaluateCharge(attack, hold + step, minimal));
+		float blockLead = 0.0f;
+		float blockValue = -1.0f;
+		const float maxLead = FMath::Min(hit - start, parryBlock.CurveTime + 2.0f * step);
+		for (float lead = 2.0f * step; lead <= maxLead; lead += step)
+		{
+			const float value = FMath::Min3(EvaluateCharge(parryBlock, lead - step, minimal),
+				EvaluateCharge(parryBlock, lead, minimal), EvaluateCharge(parryBlock, lead + step, minimal));
+			if (value > blockValue)
+			{
+				blockValue = value;
+				blockLead = lead;
+			}
+		}
+
+		if (!IsValid(Cast<UMeleeWeaponAnimDataAsset>(meleeData->Animations)))
+		{
+			scenario.SkipReason = TEXT("Parry needs melee animation data");
+		}
+		else if (attackValue >= 1.0f || attackValue >= blockValue)
+		{
+			scenario.SkipReason = FString::Printf(TEXT("Swing power %.2f is not below block value %.2f"),
+				attackValue, blockValue);
+		}
+
+		if (bShield)
+		{
+			AddStep(scenario, 0.0f, EMeleeInputType::RemoveShield, 1);
+			Expect(scenario, EWeaponFightingStatus::Busy, 0.0f, tolerance, 1);
+			Expect(scenario, EWeaponFightingStatus::Idle, meleeData->ShieldRemoveTime, tolerance, 1);
+		}
+		AddStep(scenario, start, EMeleeInputType::StartAttack);
+		AddStep(scenario, release, EMeleeInputType::Attack);
+		AddStep(scenario, hit - blockLead, EMeleeInputType::Block, 1);
+		AddHit(scenario, hit, 1, attack.BasicDamage);
+		Expect(scenario, EWeaponFightingStatus::PreAttack, start, tolerance);
+		Expect(scenario, EWeaponFightingStatus::AttackCharging, start + pre, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Attacking, release, tolerance);
+		Expect(scenario, EWeaponFightingStatus::ParryStunned, hit, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Idle, hit + data.Attack.AttackStunLen, tolerance);
+		Expect(scenario, EWeaponFightingStatus::BlockCharging, hit - blockLead, tolerance, 1);
+		Expect(scenario, EWeaponFightingStatus::AttackCharging, hit, tolerance, 1);
+		scenario.Duration = hit + data.Attack.AttackStunLen + hold;
+	}
+	{
+		// Hit breaking the shield forces the defender out of the block, the swing goes on
+		FMeleeScenario& scenario = OutScenarios.AddDefaulted_GetRef();
+		scenario.Name = TEXT("ShieldDurability");
+		const float release = pre + hold;
+		const float hit = release + 0.5f * attack.HittingTime;
+		const float postStart = release + attack.HittingTime;
+
+		// Enough damage to break a full shield
+		float damage = FMath::Max(attack.BasicDamage, 1.0f);
+		if (!meleeWeapon->IsShieldEquipped())
+		{
+			scenario.SkipReason = TEXT("Weapon has no shield");
+		}
+		else
+		{
+			for (int32 i = 0; i < 16 && meleeWeapon->ConvertIncomingDamageToShieldDamage(damage) < 1.0f; ++i)
+			{
+				damage *= 2.0f;
+			}
+			if (meleeWeapon->ConvertIncomingDamageToShieldDamage(damage) < 1.0f)
+			{
+				scenario.SkipReason = TEXT("Swing damage does not break the shield");
+			}
+		}
+
+		AddStep(scenario, 0.0f, EMeleeInputType::Block, 1);
+		AddStep(scenario, 0.0f, EMeleeInputType::StartAttack);
+		AddStep(scenario, release, EMeleeInputType::Attack);
+		AddHit(scenario, hit, 1, damage);
+		Expect(scenario, EWeaponFightingStatus::PreAttack, 0.0f, tolerance);
+		Expect(scenario, EWeaponFightingStatus::AttackCharging, pre, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Attacking, release, tolerance);
+		Expect(scenario, EWeaponFightingStatus::PostAttack, postStart, tolerance);
+		Expect(scenario, EWeaponFightingStatus::Idle, postStart + attack.PostAttackLen, tolerance);
+		Expect(scenario, EWeaponFightingStatus::BlockCharging, 0.0f, tolerance, 1);
+		Expect(scenario, EWeaponFightingStatus::PostBlock, hit, tolerance, 1);
+		Expect(scenario, EWeaponFightingStatus::Idle, hit + block.PostBlockLen, tolerance, 1);
+		scenario.Duration = FMath::Max(postStart + attack.PostAttackLen, hit + block.PostBlockLen) + hold;
+	}
+}
+
+bool UMeleeScenarioSubsystem::FindScenario(const FString& InName, FMeleeScenario& OutScenario) const
+{
+	// Config overrides built-in scenarios of the same name
+	if (const FMeleeScenario* scenario = Scenarios.FindByPredicate([&InName](const FMeleeScenario& InScenario) {
+		return InScenario.Name == InName;
+	}))
+	{
+		OutScenario = *scenario;
+		return true;
+	}
+
+	const UAdvancedWeaponManager* attacker = Managers[0].Get();
+	if (!attacker)
+		return false;
+
+	TArray<FMeleeScenario> builtIn;
+	MakeBuiltInScenarios(attacker, builtIn);
+	if (const FMeleeScenario* scenario = builtIn.FindByPredicate([&InName](const FMeleeScenario& InScenario) {
+		return InScenario.Name == InName;
+	}))
+	{
+		OutScenario = *scenario;
+		return true;
+	}
+	return false;
+}
+
+void UMeleeScenarioSubsystem::Tick(float DeltaTime)
+{
+	const double now = GetWorld()->GetTimeSeconds();
+	if (Phase == EMeleeScenarioPhase::Equipping)
+	{
+		bool bReady = true;
+		for (const TWeakObjectPtr<UAdvancedWeaponManager>& manager : Managers)
+		{
+			bReady &= manager.IsValid()
+				&& IsValid(manager->GetCurrentWeapon())
+				&& manager->GetManagingStatus() == EWeaponManagingStatus::Idle
+				&& manager->GetFightingStatus() == EWeaponFightingStatus::Idle;
+		}
+		if (!bReady)
+		{
+			if (now - PhaseStartTime > EquipTimeout)
+			{
+				FinishScenario(TEXT("Equip timeout"));
+			}
+			return;
+		}
+
+		const FString name = Current.Name;
+		if (!FindScenario(name, Current))
+		{
+			FinishScenario(TEXT("Unknown scenario, built-in ones need a melee weapon"));
+			return;
+		}
+		if (!Current.SkipReason.IsEmpty())
+		{
+			FinishScenario(FString());
+			return;
+		}
+
+		// Steps run in time order, whatever order they are listed in
+		Current.Steps.StableSort([](const FMeleeScenarioStep& InA, const FMeleeScenarioStep& InB) {
+			return InA.Time < InB.Time;
+		});
+
+		// Scenario time starts now, equip transitions are not compared
+		Transitions.Reset();
+		NextStep = 0;
+		PhaseStartTime = now;
+		Phase = EMeleeScenarioPhase::Running;
+	}
+
+	const float time = static_cast<float>(now - PhaseStartTime);
+	for (; NextStep < Current.Steps.Num() && Current.Steps[NextStep].Time <= time; ++NextStep)
+	{
+		const FMeleeScenarioStep& step = Current.Steps[NextStep];
+		const int32 actor = FMath::Clamp(step.Actor, 0, 1);
+		UAdvancedWeaponManager* manager = Managers[actor].Get();
+		UAdvancedWeaponManager* opponent = Managers[1 - actor].Get();
+		if (!manager || !opponent)
+		{
+			FinishScenario(TEXT("Fighter destroyed"));
+			return;
+		}
+
+		if (step.Action == EMeleeScenarioAction::Hit)
+		{
+			ApplyHit(manager, opponent, step.Damage);
+		}
+		else
+		{
+			manager->ExecuteInput(step.Input);
+		}
+	}
+
+	if (time >= Current.Duration)
+	{
+		FinishScenario(FString());
+	}
+}
+
+void UMeleeScenarioSubsystem::ApplyHit(UAdvancedWeaponManager* InVictim, UAdvancedWeaponManager* InCauser,
+	float InDamage) const
+{
+	AActor* victim = InVictim->GetOwner();
+	AActor* causer = InCauser->GetOwner();
+
+	// Side block is checked from the trace start
+	FHitResult hit(victim, nullptr, victim->GetActorLocation(),
+		(causer->GetActorLocation() - victim->GetActorLocation()).GetSafeNormal());
+	hit.TraceStart = causer->GetActorLocation();
+	hit.TraceEnd = hit.Location;
+
+	EDamageReturn damageReturn;
+	float damage;
+	InVictim->ProcessWeaponDamage(causer, InDamage, hit, UDamageType::StaticClass(), damageReturn, damage);
+}
+
+void UMeleeScenarioSubsystem::OnTransition(UAdvancedWeaponManager* InManager,
+	const FMeleeStateTransition& InTransition)
+{
+	if (!IsRunning())
+		return;
+
+	const int32 actor = Managers[0].Get() == InManager ? 0 : Managers[1].Get() == InManager ? 1 : INDEX_NONE;
+	if (actor == INDEX_NONE)
+		return;
+
+	FMeleeScenarioTransition& transition = Transitions.AddDefaulted_GetRef();
+	transition.Actor = actor;
+	transition.Transition = InTransition;
+	transition.Transition.Time -= PhaseStartTime;
+}
+
+void UMeleeScenarioSubsystem::FinishScenario(const FString& InError)
+{
+	TArray<FString> errors;
+	if (!InError.IsEmpty())
+	{
+		errors.Add(InError);
+	}
+
+	TArray<TSharedPtr<FJsonValue>> transitions;
+	TArray<const FMeleeStateTransition*> actual[2];
+	int32 violations = 0;
+	for (const FMeleeScenarioTransition& transition : Transitions)
+	{
+		const FMeleeStateTransition& value = transition.Transition;
+		TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+		json->SetNumberField(TEXT("actor"), transition.Actor);
+		json->SetStringField(TEXT("type"), value.bManaging ? TEXT("managing") : TEXT("fighting"));
+		json->SetStringField(TEXT("from"), FMeleeStateMachine::GetStatusName(value, false));
+		json->SetStringField(TEXT("to"), FMeleeStateMachine::GetStatusName(value, true));
+		json->SetNumberField(TEXT("time"), value.Time);
+		json->SetBoolField(TEXT("valid"), value.bValid);
+		transitions.Add(MakeShared<FJsonValueObject>(json));
+
+		if (!value.bValid)
+		{
+			++violations;
+		}
+		if (!value.bManaging && value.From != value.To)
+		{
+			actual[transition.Actor].Add(&value);
+		}
+	}
+
+	if (violations > 0)
+	{
+		errors.Add(FString::Printf(TEXT("%d invalid transitions"), violations));
+	}
+
+	// Compared only when the scenario ran to the end
+	const bool bSkipped = !Current.SkipReason.IsEmpty();
+	if (InError.IsEmpty() && !bSkipped)
+	{
+		for (int32 actor = 0; actor < 2; ++actor)
+		{
+			TArray<const FMeleeScenarioExpectation*> expected;
+			for (const FMeleeScenarioExpectation& expectation : Current.Expected)
+			{
+				if (expectation.Actor == actor)
+				{
+					expected.Add(&expectation);
+				}
+			}
+
+			const int32 num = FMath::Max(expected.Num(), actual[actor].Num());
+			for (int32 i = 0; i < num; ++i)
+			{
+				if (!expected.IsValidIndex(i))
+				{
+					errors.Add(FString::Printf(TEXT("Actor %d: unexpected %s at %.3f"), actor,
+						*FMeleeStateMachine::GetStatusName(*actual[actor][i], true), actual[actor][i]->Time));
+					continue;
+				}
+
+				const FString expectedName = UEnum::GetDisplayValueAsText(expected[i]->Status).ToString();
+				if (!actual[actor].IsValidIndex(i))
+				{
+					errors.Add(FString::Printf(TEXT("Actor %d: missing %s"), actor, *expectedName));
+					continue;
+				}
+
+				const FMeleeStateTransition& transition = *actual[actor][i];
+				if (transition.To != static_cast<uint8>(expected[i]->Status))
+				{
+					errors.Add(FString::Printf(TEXT("Actor %d: %s instead of %s at %.3f"), actor,
+						*FMeleeStateMachine::GetStatusName(transition, true), *expectedName, transition.Time));
+					continue;
+				}
+
+				const bool bEarly = expected[i]->MinTime >= 0.0f && transition.Time < expected[i]->MinTime;
+				const bool bLate = expected[i]->MaxTime >= 0.0f && transition.Time > expected[i]->MaxTime;
+				if (bEarly || bLate)
+				{
+					errors.Add(FString::Printf(TEXT("Actor %d: %s at %.3f, expected %.3f - %.3f"), actor,
+						*expectedName, transition.Time, expected[i]->MinTime, expected[i]->MaxTime));
+				}
+			}
+		}
+	}
+
+	const bool bPassed = errors.Num() == 0;
+	FailedNum += bPassed ? 0 : 1;
+	if (bSkipped && bPassed)
+	{
+		TRACE(LogWeapon, "Melee scenario %s skipped: %s", *Current.Name, *Current.SkipReason);
+	}
+	else if (bPassed)
+	{
+		TRACE(LogWeapon, "Melee scenario %s passed", *Current.Name);
+	}
+	else
+	{
+		TRACEWARN(LogWeapon, "Melee scenario %s failed: %s", *Current.Name, *FString::Join(errors, TEXT("; ")));
+	}
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetStringField(TEXT("name"), Current.Name);
+	json->SetBoolField(TEXT("passed"), bPassed);
+	json->SetBoolField(TEXT("skipped"), bSkipped);
+	if (bSkipped)
+	{
+		json->SetStringField(TEXT("skipReason"), Current.SkipReason);
+	}
+	TArray<TSharedPtr<FJsonValue>> errorValues;
+	for (const FString& error : errors)
+	{
+		errorValues.Add(MakeShared<FJsonValueString>(error));
+	}
+	json->SetArrayField(TEXT("errors"), errorValues);
+	json->SetArrayField(TEXT("transitions"), transitions);
+	Results.Add(MakeShared<FJsonValueObject>(json));
+
+	FMeleeScenarioResult& result = LastResults.AddDefaulted_GetRef();
+	result.Name = Current.Name;
+	result.bPassed = bPassed;
+	result.bSkipped = bSkipped;
+	result.Errors = MoveTemp(errors);
+	result.Transitions = Transitions;
+
+	Phase = EMeleeScenarioPhase::None;
+	Transitions.Reset();
+	DestroyFighters();
+	StartNext();
+}
+
+void UMeleeScenarioSubsystem::FinishRun()
+{
+	Phase = EMeleeScenarioPhase::None;
+	FMeleeStateMachine::OnTransition.Remove(TransitionHandle);
+	TransitionHandle.Reset();
+	FApp::SetUseFixedTimeStep(bPreviousFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+	WeaponOverride = nullptr;
+
+	const int32 skippedNum = Algo::CountIf(LastResults, [](const FMeleeScenarioResult& InResult) {
+		return InResult.bSkipped && InResult.bPassed;
+	});
+	const int32 passedNum = Results.Num() - FailedNum - skippedNum;
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("fixedStep"), FixedStep);
+	json->SetNumberField(TEXT("passed"), passedNum);
+	json->SetNumberField(TEXT("failed"), FailedNum);
+	json->SetNumberField(TEXT("skipped"), skippedNum);
+	json->SetArrayField(TEXT("scenarios"), Results);
+
+	const FString path = FMeleeHarnessFixture::WriteResults(json, TEXT("MeleeScenario"), TEXT("Scenario"));
+	TRACE(LogWeapon, "Melee scenarios finished: %d passed, %d failed, %d skipped, %s", passedNum, FailedNum,
+		skippedNum, *path);
+	Results.Reset();
+}
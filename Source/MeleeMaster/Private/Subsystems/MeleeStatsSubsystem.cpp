@@ -0,0 +1,165 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeStatsSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "EngineUtils.h"
+#include "Actors/WeaponVisual.h"
+#include "Components/AdvancedWeaponManager.h"
+#include "Engine/Channel.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "Objects/WeaponModifierManager.h"
+
+static TAutoConsoleVariable<float> CVarMeleeStatsLogInterval(
+	TEXT("melee.Stats.LogInterval"),
+	60.0f,
+	TEXT("Seconds between combat health summaries in the log (server only). <= 0 disables the summary."));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdMeleeStats(
+	TEXT("melee.Stats"),
+	TEXT("Prints combat health of the last second: traces, hits, swings, timers, RPC queues, phase percentiles."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& InArgs, UWorld* InWorld, FOutputDevice& Ar) {
+			if (UMeleeStatsSubsystem* stats = UMeleeStatsSubsystem::Get(InWorld))
+			{
+				stats->Dump(Ar);
+			}
+		}));
+
+bool UMeleeStatsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UMeleeStatsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeleeStatsSubsystem, STATGROUP_MeleeMaster);
+}
+
+UMeleeStatsSubsystem* UMeleeStatsSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UMeleeStatsSubsystem>();
+	}
+	return nullptr;
+}
+
+void UMeleeStatsSubsystem::Tick(float DeltaTime)
+{
+	const double currentTime = FPlatformTime::Seconds();
+	if (WindowStartTime <= 0.0)
+	{
+		WindowStartTime = currentTime;
+		LastLogTime = currentTime;
+		PreviousCounters = FMeleeCounters::Get();
+		return;
+	}
+	if (currentTime - WindowStartTime < 1.0)
+		return;
+
+	FinishWindow(currentTime - WindowStartTime);
+	WindowStartTime = currentTime;
+
+	const float logInterval = CVarMeleeStatsLogInterval.GetValueOnGameThread();
+	if (logInterval > 0.0f && GetWorld()->GetNetMode() != NM_Client && currentTime - LastLogTime >= logInterval)
+	{
+		LastLogTime = currentTime;
+		Dump(*GLog);
+	}
+}
+
+void UMeleeStatsSubsystem::FinishWindow(double InSeconds)
+{
+	// Counters are summed over all worlds of the process
+	const FMeleeCounters counters = FMeleeCounters::Get();
+	const float seconds = static_cast<float>(FMath::Max(InSeconds, KINDA_SMALL_NUMBER));
+	FMeleeStatsWindow window;
+	window.Seconds = seconds;
+	window.Traces = (counters.Traces - PreviousCounters.Traces) / seconds;
+	window.TracesSkipped = (counters.TracesSkipped - PreviousCounters.TracesSkipped) / seconds;
+	window.Hits = (counters.Hits - PreviousCounters.Hits) / seconds;
+	window.Blocks = (counters.Blocks - PreviousCounters.Blocks) / seconds;
+	window.Parries = (counters.Parries - PreviousCounters.Parries) / seconds;
+	window.Rpcs = (counters.Rpcs - PreviousCounters.Rpcs) / seconds;
+	const int64 traces = counters.Traces - PreviousCounters.Traces;
+	window.TargetsPerTrace = traces > 0
+		? static_cast<float>(counters.TraceTargets - PreviousCounters.TraceTargets) / traces
+		: 0.0f;
+	for (int32 i = 0; i < static_cast<int32>(EMeleePhase::Num); ++i)
+	{
+		window.PhaseHistograms[i] = counters.PhaseHistograms[i] - PreviousCounters.PhaseHistograms[i];
+	}
+	SampleGauges(window);
+
+	PreviousCounters = counters;
+	Last = window;
+}
+
+void UMeleeStatsSubsystem::SampleGauges(FMeleeStatsWindow& OutWindow) const
+{
+	UWorld* world = GetWorld();
+	UAdvancedWeaponManager::ForEachRegistered([&](UAdvancedWeaponManager* InManager) {
+		if (InManager->GetWorld() != world)
+			return;
+
+		++OutWindow.Managers;
+		OutWindow.ActiveSwings += InManager->GetFightingStatus() == EWeaponFightingStatus::Attacking ? 1 : 0;
+		OutWindow.ActiveTimers += InManager->GetActiveTimerNum();
+	});
+
+	for (TActorIterator<AWeaponVisual> it(world); it; ++it)
+	{
+		++OutWindow.WeaponVisuals;
+	}
+	for (TActorIterator<AWeaponModifierManager> it(world); it; ++it)
+	{
+		++OutWindow.ModifierManagers;
+	}
+
+	const UNetDriver* driver = world->GetNetDriver();
+	if (!driver || driver->ClientConnections.Num() == 0)
+		return;
+
+	int64 queueSum = 0;
+	for (const UNetConnection* connection : driver->ClientConnections)
+	{
+		int32 queue = 0;
+		for (const UChannel* channel : connection->OpenChannels)
+		{
+			queue += channel ? channel->NumOutRec : 0;
+		}
+		queueSum += queue;
+		OutWindow.MaxReliableQueue = FMath::Max(OutWindow.MaxReliableQueue, queue);
+	}
+	OutWindow.AvgReliableQueue = static_cast<float>(queueSum) / driver->ClientConnections.Num();
+}
+
+void UMeleeStatsSubsystem::Dump(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("MeleeMaster stats (%s, %.2f sec)"), *GetWorld()->GetName(), Last.Seconds);
+	Ar.Logf(TEXT("  Traces %.1f/s, skipped %.1f/s, targets per trace %.2f"), Last.Traces, Last.TracesSkipped,
+		Last.TargetsPerTrace);
+	Ar.Logf(TEXT("  Hits %.1f/s, blocks %.1f/s, parries %.1f/s, RPCs sent %.1f/s"), Last.Hits, Last.Blocks,
+		Last.Parries, Last.Rpcs);
+	Ar.Logf(TEXT("  Managers %d, active swings %d, timers %d, weapon visuals %d, modifier managers %d"),
+		Last.Managers, Last.ActiveSwings, Last.ActiveTimers, Last.WeaponVisuals, Last.ModifierManagers);
+	Ar.Logf(TEXT("  Reliable queue max %d, avg %.1f"), Last.MaxReliableQueue, Last.AvgReliableQueue);
+	for (int32 i = 0; i < static_cast<int32>(EMeleePhase::Num); ++i)
+	{
+		const FMeleeHistogram& histogram = Last.PhaseHistograms[i];
+		if (histogram.Num() == 0)
+			continue;
+
+		Ar.Logf(TEXT("  %-24s n %6llu  p50 %8.2f us  p95 %8.2f us  p99 %8.2f us"),
+			FMeleeCounters::GetPhaseName(static_cast<EMeleePhase>(i)), histogram.Num(),
+			histogram.GetPercentile(0.5f) / 1000.0, histogram.GetPercentile(0.95f) / 1000.0,
+			histogram.GetPercentile(0.99f) / 1000.0);
+	}
+}
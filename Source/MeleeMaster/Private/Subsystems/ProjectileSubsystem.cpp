@@ -0,0 +1,633 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/ProjectileSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "Libs/MeleeCounters.h"
+#include "Subsystems/VisualPoolSubsystem.h"
+
+static TAutoConsoleVariable<float> CVarMeleeProjectileFixedStep(
+	TEXT("melee.Projectile.FixedStep"),
+	1.0f / 120.0f,
+	TEXT("Fixed simulation step of projectiles (sec). Sweeps are done per step, so fast arrows do not tunnel at low tick rate."));
+
+static TAutoConsoleVariable<int32> CVarMeleeProjectileMaxSubSteps(
+	TEXT("melee.Projectile.MaxSubSteps"),
+	16,
+	TEXT("Maximum number of fixed projectile steps per frame. Remaining time is dropped."));
+
+static TAutoConsoleVariable<bool> CVarMeleeProjectileLagCompensation(
+	TEXT("melee.Projectile.LagCompensation"),
+	true,
+	TEXT("Record target history and rewind targets for projectiles launched with rewind time (server only)."));
+
+static constexpr int32 RewindHistoryCapacity = 64;
+
+static TAutoConsoleVariable<int32> CVarMeleeProjectileParallelThreshold(
+	TEXT("melee.Projectile.ParallelThreshold"),
+	256,
+	TEXT("Minimal number of in-flight projectiles to integrate them with ParallelFor. <= 0 never runs in parallel."));
+
+bool UProjectileSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectileSubsystem::Deinitialize()
+{
+	// Visual actors are destroyed with the world
+	Ids.Empty();
+	Positions.Empty();
+	PreviousPositions.Empty();
+	Velocities.Empty();
+	Gravities.Empty();
+	Drags.Empty();
+	Radii.Empty();
+	TimeLeft.Empty();
+	Infos.Empty();
+	StuckVisuals.Empty();
+	PendingImpacts.Empty();
+	RewindTargets.Empty();
+	RewindProjectileNum = 0;
+	RewindRecordFramesLeft = 0;
+	Super::Deinitialize();
+}
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UProjectileSubsystem::IsTickable() const
+{
+	return Ids.Num() > 0 || StuckVisuals.Num() > 0 || RewindRecordFramesLeft > 0;
+}
+
+UProjectileSubsystem* UProjectileSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UProjectileSubsystem>();
+	}
+	return nullptr;
+}
+
+int32 UProjectileSubsystem::Launch(const FProjectileLaunchParams& InParams)
+{
+	if (InParams.LifeTime <= 0.0f)
+		return INDEX_NONE;
+
+	FVector origin = InParams.Origin;
+	FVector velocity = InParams.Velocity;
+	float lifeTime = InParams.LifeTime;
+	FHitResult catchUpHit;
+	bool bCatchUpHit = false;
+	if (InParams.FastForwardTime > 0.0f)
+	{
+		// Catch up with the same fixed steps
+		const float step = FMath::Max(CVarMeleeProjectileFixedStep.GetValueOnGameThread(), KINDA_SMALL_NUMBER);
+		const int32 steps = FMath::Min(FMath::FloorToInt(InParams.FastForwardTime / step),
+			FMath::FloorToInt(lifeTime / step));
+		for (int32 i = 0; i < steps; ++i)
+		{
+			IntegrateStep(origin, velocity, InParams.Gravity, InParams.Drag, step);
+		}
+		lifeTime -= steps * step;
+
+		// One sweep over the skipped path, so the copy stops at the wall or shield the shot already hit
+		if (steps > 0 && InParams.bReportImpacts)
+		{
+			const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(MeleeProjectileSweep), false,
+				InParams.Causer.Get());
+			bCatchUpHit = SweepWorld(InParams.Origin, origin, InParams.Radius, InParams.TraceChannel, queryParams,
+				catchUpHit);
+			if (bCatchUpHit)
+			{
+				origin = catchUpHit.Location;
+			}
+		}
+		if (lifeTime <= 0.0f && !bCatchUpHit)
+			return INDEX_NONE;
+	}
+
+	const int32 id = ++LastProjectileId;
+	Ids.Add(id);
+	Positions.Add(origin);
+	PreviousPositions.Add(origin);
+	Velocities.Add(velocity);
+	Gravities.Add(InParams.Gravity);
+	Drags.Add(InParams.Drag);
+	Radii.Add(InParams.Radius);
+	TimeLeft.Add(lifeTime);
+
+	FProjectileInfo& info = Infos.AddDefaulted_GetRef();
+	info.StuckLifeTime = InParams.StuckLifeTime;
+	info.Damage = InParams.Damage;
+	info.RewindTime = InParams.RewindTime;
+	info.TraceChannel = InParams.TraceChannel;
+	info.bReportImpacts = InParams.bReportImpacts;
+	info.Causer = InParams.Causer;
+	info.OnImpact = InParams.OnImpact;
+	if (info.RewindTime > 0.0f && info.bReportImpacts)
+	{
+		++RewindProjectileNum;
+	}
+
+	if (InParams.VisualClass && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		if (UVisualPoolSubsystem* pool = UVisualPoolSubsystem::Get(this))
+		{
+			const FTransform transform(velocity.Rotation(), origin);
+			if (AActor* visual = pool->Acquire(InParams.VisualClass.Get(), transform, InParams.Causer.Get()))
+			{
+				// Sweeps of other projectiles must not hit visuals
+				visual->SetActorEnableCollision(false);
+				info.Visual = visual;
+			}
+		}
+	}
+
+	INC_DWORD_STAT(STAT_MeleeProjectilesLaunched);
+	if (bCatchUpHit)
+	{
+		HandleImpact(Ids.Num() - 1, catchUpHit);
+		ReportImpacts();
+	}
+	return id;
+}
+
+bool UProjectileSubsystem::Cancel(int32 InProjectileId)
+{
+	const int32 index = Ids.IndexOfByKey(InProjectileId);
+	if (index == INDEX_NONE)
+		return false;
+
+	RemoveAtSwap(index, true);
+	return true;
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeleeProjectileTick);
+	Super::Tick(DeltaTime);
+
+	RecordRewindHistory();
+
+	if (Ids.Num() > 0)
+	{
+		const float step = FMath::Max(CVarMeleeProjectileFixedStep.GetValueOnGameThread(), KINDA_SMALL_NUMBER);
+		const int32 maxSteps = FMath::Max(CVarMeleeProjectileMaxSubSteps.GetValueOnGameThread(), 1);
+
+		StepAccumulator += DeltaTime;
+		int32 steps = 0;
+		while (StepAccumulator >= step && steps < maxSteps && Ids.Num() > 0)
+		{
+			SimulateStep(step);
+			StepAccumulator -= step;
+			++steps;
+		}
+		// Too slow frame, drop the backlog instead of spiralling
+		StepAccumulator = FMath::Min(StepAccumulator, step);
+
+		UpdateVisuals(StepAccumulator);
+	}
+	else
+	{
+		StepAccumulator = 0.0f;
+	}
+
+	ReleaseStuckVisuals();
+	SET_DWORD_STAT(STAT_MeleeProjectilesInFlight, Ids.Num());
+}
+
+void UProjectileSubsystem::SimulateStep(float InStep)
+{
+	Integrate(InStep);
+
+	TArray<TPair<int32, FHitResult>> impacts;
+	Sweep(impacts);
+
+	// Descending order keeps lower indices valid while removing with swap
+	impacts.Sort([](const TPair<int32, FHitResult>& A, const TPair<int32, FHitResult>& B) {
+		return A.Key > B.Key;
+	});
+	for (const TPair<int32, FHitResult>& impact : impacts)
+	{
+		HandleImpact(impact.Key, impact.Value);
+	}
+
+	for (int32 i = Ids.Num() - 1; i >= 0; --i)
+	{
+		if (TimeLeft[i] <= 0.0f)
+		{
+			RemoveAtSwap(i, true);
+		}
+	}
+
+	ReportImpacts();
+}
+
+void UProjectileSubsystem::Integrate(float InDeltaTime)
+{
+	const int32 num = Ids.Num();
+	const int32 threshold = CVarMeleeProjectileParallelThreshold.GetValueOnGameThread();
+	const bool bSingleThread = threshold <= 0 || num < threshold;
+
+	FVector* positions = Positions.GetData();
+	FVector* previousPositions = PreviousPositions.GetData();
+	FVector* velocities = Velocities.GetData();
+	const float* gravities = Gravities.GetData();
+	const float* drags = Drags.GetData();
+	float* timeLeft = TimeLeft.GetData();
+
+	// Every element is independent
+	ParallelFor(num, [=](int32 i) {
+		previousPositions[i] = positions[i];
+		IntegrateStep(positions[i], velocities[i], gravities[i], drags[i], InDeltaTime);
+		timeLeft[i] -= InDeltaTime;
+	}, bSingleThread);
+}
+
+void UProjectileSubsystem::IntegrateStep(FVector& InOutPosition, FVector& InOutVelocity, float InGravity, float InDrag,
+	float InStep)
+{
+	// Semi-implicit Euler
+	const float speed = InOutVelocity.Size();
+	InOutVelocity.Z += InGravity * InStep;
+	InOutVelocity -= InOutVelocity * FMath::Min(InDrag * speed * InStep, 1.0f);
+	InOutPosition += InOutVelocity * InStep;
+}
+
+void UProjectileSubsystem::Sweep(TArray<TPair<int32, FHitResult>>& OutImpacts) const
+{
+	UWorld* world = GetWorld();
+	const double now = world->GetTimeSeconds();
+	const bool bLagCompensation = CVarMeleeProjectileLagCompensation.GetValueOnGameThread() && RewindTargets.Num() > 0;
+	const int32 num = Ids.Num();
+	for (int32 i = 0; i < num; ++i)
+	{
+		const FProjectileInfo& info = Infos[i];
+		if (!info.bReportImpacts)
+			continue;
+
+		FCollisionQueryParams queryParams(SCENE_QUERY_STAT(MeleeProjectileSweep), false, info.Causer.Get());
+		queryParams.bReturnPhysicalMaterial = true;
+
+		const bool bRewind = bLagCompensation && info.RewindTime > 0.0f;
+		if (bRewind)
+		{
+			// Targets are tested at their past location instead
+			for (const FProjectileRewindTarget& target : RewindTargets)
+			{
+				queryParams.AddIgnoredActor(target.Actor.Get());
+			}
+		}
+
+		FHitResult hit;
+		bool bHit = SweepWorld(PreviousPositions[i], Positions[i], Radii[i], info.TraceChannel, queryParams, hit);
+
+		FHitResult rewindHit;
+		if (bRewind && SweepRewindTargets(PreviousPositions[i], Positions[i], Radii[i], now - info.RewindTime,
+			info.Causer.Get(), rewindHit))
+		{
+			if (!bHit || rewindHit.Time < hit.Time)
+			{
+				hit = rewindHit;
+				bHit = true;
+			}
+		}
+
+		if (bHit)
+		{
+			OutImpacts.Emplace(i, hit);
+		}
+	}
+}
+
+bool UProjectileSubsystem::SweepWorld(const FVector& InStart, const FVector& InEnd, float InRadius,
+	ECollisionChannel InChannel, const FCollisionQueryParams& InQueryParams, FHitResult& OutHit) const
+{
+	FMeleeCounters::AddTrace();
+	if (InRadius > 0.0f)
+	{
+		return GetWorld()->SweepSingleByChannel(OutHit, InStart, InEnd, FQuat::Identity, InChannel,
+			FCollisionShape::MakeSphere(InRadius), InQueryParams);
+	}
+	return GetWorld()->LineTraceSingleByChannel(OutHit, InStart, InEnd, InChannel, InQueryParams);
+}
+
+/**
+ * @brief Entry point of the segment into the capsule (segment CapA-CapB inflated by radius).
+ * Distance to a segment is convex along the ray, so the entry is found by bisection before the closest point.
+ */
+static bool SegmentCapsuleEntry(const FVector& InStart, const FVector& InEnd,
+	const FVector& InCapA, const FVector& InCapB, float InRadius, float& OutTime)
+{
+	FVector onSegment, onCapsule;
+	FMath::SegmentDistToSegmentSafe(InStart, InEnd, InCapA, InCapB, onSegment, onCapsule);
+	const float radiusSq = InRadius * InRadius;
+	if (FVector::DistSquared(onSegment, onCapsule) > radiusSq)
+		return false;
+
+	auto distSq = [&](float InT) {
+		const FVector point = FMath::Lerp(InStart, InEnd, InT);
+		return FVector::DistSquared(point, FMath::ClosestPointOnSegment(point, InCapA, InCapB));
+	};
+	if (distSq(0.0f) <= radiusSq)
+	{
+		OutTime = 0.0f;
+		return true;
+	}
+
+	const float length = FVector::Dist(InStart, InEnd);
+	float low = 0.0f;
+	float high = length > KINDA_SMALL_NUMBER ? FVector::Dist(InStart, onSegment) / length : 0.0f;
+	for (int32 i = 0; i < 16; ++i)
+	{
+		const float mid = (low + high) * 0.5f;
+		if (distSq(mid) <= radiusSq)
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid;
+		}
+	}
+	OutTime = high;
+	return true;
+}
+
+bool UProjectileSubsystem::SweepRewindTargets(const FVector& InStart, const FVector& InEnd, float InRadius,
+	double InTime, const AActor* InIgnore, FHitResult& OutHit) const
+{
+	float bestTime = TNumericLimits<float>::Max();
+	const FProjectileRewindTarget* bestTarget = nullptr;
+	FVector bestLocation = FVector::ZeroVector;
+
+	for (const FProjectileRewindTarget& target : RewindTargets)
+	{
+		const AActor* actor = target.Actor.Get();
+		if (!actor || actor == InIgnore)
+			continue;
+
+		FVector location;
+		if (!target.GetLocationAt(InTime, location))
+			continue;
+
+		const FVector axis(0.0f, 0.0f, FMath::Max(target.HalfHeight - target.Radius, 0.0f));
+		float time;
+		if (SegmentCapsuleEntry(InStart, InEnd, location - axis, location + axis, target.Radius + InRadius, time)
+			&& time < bestTime)
+		{
+			bestTime = time;
+			bestTarget = &target;
+			bestLocation = location;
+		}
+	}
+
+	if (!bestTarget)
+		return false;
+
+	// Report the hit relative to where the target is now
+	const FVector offset = bestTarget->Actor->GetActorLocation() - bestLocation;
+	const FVector axis(0.0f, 0.0f, FMath::Max(bestTarget->HalfHeight - bestTarget->Radius, 0.0f));
+	const FVector location = FMath::Lerp(InStart, InEnd, bestTime);
+	const FVector onAxis = FMath::ClosestPointOnSegment(location, bestLocation - axis, bestLocation + axis);
+	const FVector normal = (location - onAxis).GetSafeNormal();
+
+	OutHit = FHitResult(bestTarget->Actor.Get(), bestTarget->Component.Get(), location + offset, normal);
+	OutHit.ImpactPoint = onAxis + normal * bestTarget->Radius + offset;
+	OutHit.ImpactNormal = normal;
+	OutHit.TraceStart = InStart;
+	OutHit.TraceEnd = InEnd;
+	OutHit.Time = bestTime;
+	OutHit.Distance = FVector::Dist(InStart, location);
+	OutHit.bBlockingHit = true;
+	return true;
+}
+
+void UProjectileSubsystem::RecordRewindHistory()
+{
+	if (RewindTargets.Num() <= 0 || !CVarMeleeProjectileLagCompensation.GetValueOnGameThread())
+	{
+		RewindRecordFramesLeft = 0;
+		return;
+	}
+
+	if (RewindProjectileNum > 0)
+	{
+		if (RewindRecordFramesLeft <= 0)
+		{
+			// Samples from before the pause would be interpolated across it
+			for (FProjectileRewindTarget& target : RewindTargets)
+			{
+				target.Locations.Reset();
+				target.Times.Reset();
+				target.Head = 0;
+			}
+		}
+		RewindRecordFramesLeft = RewindHistoryCapacity;
+	}
+	else if (RewindRecordFramesLeft <= 0)
+	{
+		return;
+	}
+	else
+	{
+		--RewindRecordFramesLeft;
+	}
+
+	const double now = GetWorld()->GetTimeSeconds();
+	for (int32 i = RewindTargets.Num() - 1; i >= 0; --i)
+	{
+		FProjectileRewindTarget& target = RewindTargets[i];
+		if (!target.Actor.IsValid())
+		{
+			RewindTargets.RemoveAtSwap(i);
+			continue;
+		}
+		target.AddSample(target.Actor->GetActorLocation(), now, RewindHistoryCapacity);
+	}
+}
+
+void UProjectileSubsystem::RegisterRewindTarget(AActor* InActor, UPrimitiveComponent* InComponent, float InRadius,
+	float InHalfHeight)
+{
+	if (!IsValid(InActor))
+		return;
+
+	UnregisterRewindTarget(InActor);
+	FProjectileRewindTarget& target = RewindTargets.AddDefaulted_GetRef();
+	target.Actor = InActor;
+	target.Component = InComponent;
+	target.Radius = InRadius;
+	target.HalfHeight = InHalfHeight;
+	target.Locations.Reserve(RewindHistoryCapacity);
+	target.Times.Reserve(RewindHistoryCapacity);
+}
+
+void UProjectileSubsystem::UnregisterRewindTarget(AActor* InActor)
+{
+	RewindTargets.RemoveAllSwap([InActor](const FProjectileRewindTarget& InTarget) {
+		return InTarget.Actor.Get() == InActor;
+	});
+}
+
+void FProjectileRewindTarget::AddSample(const FVector& InLocation, double InTime, int32 InCapacity)
+{
+	if (Locations.Num() < InCapacity)
+	{
+		Locations.Add(InLocation);
+		Times.Add(InTime);
+		Head = Locations.Num() % InCapacity;
+		return;
+	}
+	Locations[Head] = InLocation;
+	Times[Head] = InTime;
+	Head = (Head + 1) % InCapacity;
+}
+
+bool FProjectileRewindTarget::GetLocationAt(double InTime, FVector& OutLocation) const
+{
+	const int32 num = Locations.Num();
+	if (num <= 0)
+		return false;
+
+	// Walk from the newest sample back in time
+	int32 newer = (Head - 1 + num) % num;
+	if (InTime >= Times[newer])
+	{
+		OutLocation = Locations[newer];
+		return true;
+	}
+	for (int32 i = 1; i < num; ++i)
+	{
+		const int32 older = (newer - 1 + num) % num;
+		if (Times[older] <= InTime)
+		{
+			const double span = Times[newer] - Times[older];
+			const float alpha = span > UE_DOUBLE_SMALL_NUMBER ? static_cast<float>((InTime - Times[older]) / span) : 0.0f;
+			OutLocation = FMath::Lerp(Locations[older], Locations[newer], alpha);
+			return true;
+		}
+		newer = older;
+	}
+	OutLocation = Locations[newer];
+	return true;
+}
+
+void UProjectileSubsystem::UpdateVisuals(float InExtrapolation)
+{
+	const int32 num = Ids.Num();
+	for (int32 i = 0; i < num; ++i)
+	{
+		if (AActor* visual = Infos[i].Visual.Get())
+		{
+			visual->SetActorLocationAndRotation(Positions[i] + Velocities[i] * InExtrapolation,
+				Velocities[i].Rotation());
+		}
+	}
+}
+
+void UProjectileSubsystem::HandleImpact(int32 InIndex, const FHitResult& InHit)
+{
+	FProjectileInfo& info = Infos[InIndex];
+
+	FProjectileImpact impact;
+	impact.ProjectileId = Ids[InIndex];
+	impact.Hit = InHit;
+	impact.Velocity = Velocities[InIndex];
+	impact.Damage = info.Damage;
+	impact.Causer = info.Causer;
+	if (info.OnImpact.IsBound())
+	{
+		PendingImpacts.Emplace(info.OnImpact, MoveTemp(impact));
+	}
+
+	bool bKeepVisual = false;
+	AActor* visual = info.Visual.Get();
+	if (visual && info.StuckLifeTime > 0.0f)
+	{
+		// Materialize stuck arrow where it hit
+		visual->SetActorLocationAndRotation(InHit.Location, Velocities[InIndex].Rotation());
+		if (USceneComponent* hitComponent = InHit.GetComponent())
+		{
+			visual->AttachToComponent(hitComponent, FAttachmentTransformRules::KeepWorldTransform, InHit.BoneName);
+		}
+		StuckVisuals.Add({visual, GetWorld()->GetTimeSeconds() + info.StuckLifeTime});
+		bKeepVisual = true;
+	}
+	RemoveAtSwap(InIndex, !bKeepVisual);
+}
+
+void UProjectileSubsystem::ReportImpacts()
+{
+	if (PendingImpacts.Num() <= 0)
+		return;
+
+	// Callbacks may launch projectiles that queue their own catch-up impact
+	TArray<TPair<FOnProjectileImpact, FProjectileImpact>> impacts = MoveTemp(PendingImpacts);
+	PendingImpacts.Reset();
+	for (const TPair<FOnProjectileImpact, FProjectileImpact>& impact : impacts)
+	{
+		impact.Key.ExecuteIfBound(impact.Value);
+	}
+}
+
+void UProjectileSubsystem::RemoveAtSwap(int32 InIndex, bool bReleaseVisual)
+{
+	if (bReleaseVisual)
+	{
+		ReleaseVisual(Infos[InIndex].Visual.Get());
+	}
+	if (Infos[InIndex].RewindTime > 0.0f && Infos[InIndex].bReportImpacts)
+	{
+		--RewindProjectileNum;
+	}
+
+	Ids.RemoveAtSwap(InIndex);
+	Positions.RemoveAtSwap(InIndex);
+	PreviousPositions.RemoveAtSwap(InIndex);
+	Velocities.RemoveAtSwap(InIndex);
+	Gravities.RemoveAtSwap(InIndex);
+	Drags.RemoveAtSwap(InIndex);
+	Radii.RemoveAtSwap(InIndex);
+	TimeLeft.RemoveAtSwap(InIndex);
+	Infos.RemoveAtSwap(InIndex);
+}
+
+void UProjectileSubsystem::ReleaseVisual(AActor* InVisual) const
+{
+	if (!IsValid(InVisual))
+		return;
+
+	InVisual->SetActorEnableCollision(true);
+	if (UVisualPoolSubsystem* pool = UVisualPoolSubsystem::Get(this))
+	{
+		pool->Release(InVisual);
+	}
+	else
+	{
+		InVisual->Destroy();
+	}
+}
+
+void UProjectileSubsystem::ReleaseStuckVisuals()
+{
+	const double now = GetWorld()->GetTimeSeconds();
+	for (int32 i = StuckVisuals.Num() - 1; i >= 0; --i)
+	{
+		if (StuckVisuals[i].ReleaseTime <= now || !StuckVisuals[i].Actor.IsValid())
+		{
+			ReleaseVisual(StuckVisuals[i].Actor.Get());
+			StuckVisuals.RemoveAtSwap(i);
+		}
+	}
+}
@@ -0,0 +1,269 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/TrailSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceArrayFunctionLibrary.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Subsystems/LoggerLib.h"
+
+static TAutoConsoleVariable<int32> CVarMeleeTrailMaxTrails(
+	TEXT("melee.Trail.MaxTrails"),
+	0,
+	TEXT("Maximum number of simultaneous batched weapon trails. <= 0 uses MaxTrails from config."));
+
+bool UTrailSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTrailSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Trails are cosmetic
+	if (InWorld.GetNetMode() == NM_DedicatedServer || TrailSystem.IsNull())
+		return;
+
+	UNiagaraSystem* system = TrailSystem.LoadSynchronous();
+	if (!IsValid(system))
+	{
+		TRACEWARN(LogWeapon, "Invalid trail system '%s'", *TrailSystem.ToString());
+		return;
+	}
+
+	TrailComponent = UNiagaraFunctionLibrary::SpawnSystemAtLocation(&InWorld, system, FVector::ZeroVector,
+		FRotator::ZeroRotator, FVector::OneVector, false, true, ENCPoolMethod::None);
+	EnsureBuffers();
+	PushToSystem();
+}
+
+void UTrailSubsystem::Deinitialize()
+{
+	// Component is destroyed with the world
+	TrailComponent = nullptr;
+	Slots.Empty();
+	StartSamples.Empty();
+	EndSamples.Empty();
+	Heads.Empty();
+	Counts.Empty();
+	UsedSlots = 0;
+	Super::Deinitialize();
+}
+
+TStatId UTrailSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTrailSubsystem, STATGROUP_MeleeMaster);
+}
+
+bool UTrailSubsystem::IsTickable() const
+{
+	return UsedSlots > 0 || bPushPending;
+}
+
+UTrailSubsystem* UTrailSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UTrailSubsystem>();
+	}
+	return nullptr;
+}
+
+bool UTrailSubsystem::IsAvailable() const
+{
+	return IsValid(TrailComponent);
+}
+
+int32 UTrailSubsystem::GetMaxTrails() const
+{
+	const int32 budget = CVarMeleeTrailMaxTrails.GetValueOnGameThread();
+	return FMath::Max(budget > 0 ? budget : MaxTrails, 1);
+}
+
+void UTrailSubsystem::EnsureBuffers()
+{
+	const int32 maxTrails = GetMaxTrails();
+	const int32 samples = FMath::Max(SamplesPerTrail, 2);
+	if (Slots.Num() == maxTrails && StartSamples.Num() == maxTrails * samples)
+		return;
+
+	// Budget changed, running trails are dropped
+	Slots.Reset();
+	Slots.SetNum(maxTrails);
+	StartSamples.Init(FVector::ZeroVector, maxTrails * samples);
+	EndSamples.Init(FVector::ZeroVector, maxTrails * samples);
+	Heads.Init(INDEX_NONE, maxTrails);
+	Counts.Init(0, maxTrails);
+	UsedSlots = 0;
+	bPushPending = true;
+}
+
+float UTrailSubsystem::EvaluatePriority(const USceneComponent* InMesh) const
+{
+	const AActor* owner = InMesh->GetOwner();
+	const APawn* pawn = IsValid(owner) ? Cast<APawn>(owner->GetOwner()) : nullptr;
+	if (IsValid(pawn) && pawn->IsLocallyControlled())
+		return 0.0f;
+
+	const APlayerController* pc = GetWorld()->GetFirstPlayerController();
+	if (!IsValid(pc))
+		return 0.0f;
+
+	FVector viewLocation;
+	FRotator viewRotation;
+	pc->GetPlayerViewPoint(viewLocation, viewRotation);
+	return FVector::DistSquared(viewLocation, InMesh->GetComponentLocation());
+}
+
+int32 UTrailSubsystem::FindSlot(float InPriority) const
+{
+	int32 candidate = INDEX_NONE;
+	for (int32 i = 0; i < Slots.Num(); ++i)
+	{
+		const FTrailSlot& slot = Slots[i];
+		if (!slot.IsUsed())
+			return i;
+
+		// Fading trails are evicted first, then the farthest
+		if (candidate == INDEX_NONE
+			|| (slot.bEnded && !Slots[candidate].bEnded)
+			|| (slot.bEnded == Slots[candidate].bEnded && slot.Priority > Slots[candidate].Priority))
+		{
+			candidate = i;
+		}
+	}
+
+	if (candidate != INDEX_NONE && (Slots[candidate].bEnded || Slots[candidate].Priority > InPriority))
+		return candidate;
+	return INDEX_NONE;
+}
+
+int32 UTrailSubsystem::BeginTrail(USceneComponent* InMesh, FName InStartSocket, FName InEndSocket)
+{
+	if (!IsAvailable() || !IsValid(InMesh))
+		return INDEX_NONE;
+
+	EnsureBuffers();
+	const float priority = EvaluatePriority(InMesh);
+	const int32 slotIndex = FindSlot(priority);
+	if (slotIndex == INDEX_NONE)
+		return INDEX_NONE;
+
+	if (Slots[slotIndex].IsUsed())
+	{
+		FreeSlot(slotIndex);
+	}
+
+	FTrailSlot& slot = Slots[slotIndex];
+	slot.Mesh = InMesh;
+	slot.StartSocket = InStartSocket;
+	slot.EndSocket = InEndSocket;
+	slot.TrailId = ++LastTrailId;
+	slot.Head = INDEX_NONE;
+	slot.Count = 0;
+	slot.bEnded = false;
+	slot.Priority = priority;
+	++UsedSlots;
+	RecordSample(slot, slotIndex);
+	return slot.TrailId;
+}
+
+void UTrailSubsystem::EndTrail(int32 InTrailId)
+{
+	if (InTrailId == INDEX_NONE)
+		return;
+
+	for (FTrailSlot& slot : Slots)
+	{
+		if (slot.TrailId == InTrailId)
+		{
+			slot.bEnded = true;
+			return;
+		}
+	}
+}
+
+void UTrailSubsystem::RecordSample(FTrailSlot& InSlot, int32 InSlotIndex)
+{
+	const USceneComponent* mesh = InSlot.Mesh.Get();
+	if (!IsValid(mesh))
+	{
+		InSlot.bEnded = true;
+		return;
+	}
+
+	const int32 samples = StartSamples.Num() / Slots.Num();
+	InSlot.Head = (InSlot.Head + 1) % samples;
+	InSlot.Count = FMath::Min(InSlot.Count + 1, samples);
+	const int32 sampleIndex = InSlotIndex * samples + InSlot.Head;
+	StartSamples[sampleIndex] = mesh->GetSocketLocation(InSlot.StartSocket);
+	EndSamples[sampleIndex] = mesh->GetSocketLocation(InSlot.EndSocket);
+	Heads[InSlotIndex] = InSlot.Head;
+	Counts[InSlotIndex] = InSlot.Count;
+	bPushPending = true;
+}
+
+void UTrailSubsystem::FreeSlot(int32 InSlotIndex)
+{
+	Slots[InSlotIndex] = FTrailSlot();
+	Heads[InSlotIndex] = INDEX_NONE;
+	Counts[InSlotIndex] = 0;
+	--UsedSlots;
+	bPushPending = true;
+}
+
+void UTrailSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeleeTrailTick);
+	SET_DWORD_STAT(STAT_MeleeTrailsActive, UsedSlots);
+
+	for (int32 i = 0; i < Slots.Num(); ++i)
+	{
+		FTrailSlot& slot = Slots[i];
+		if (!slot.IsUsed())
+			continue;
+
+		if (!slot.bEnded)
+		{
+			RecordSample(slot, i);
+			continue;
+		}
+
+		// Ended trail shrinks from its tail
+		if (--slot.Count <= 0)
+		{
+			FreeSlot(i);
+			continue;
+		}
+		Counts[i] = slot.Count;
+		bPushPending = true;
+	}
+
+	if (bPushPending)
+	{
+		PushToSystem();
+	}
+}
+
+void UTrailSubsystem::PushToSystem()
+{
+	bPushPending = false;
+	if (!IsValid(TrailComponent))
+		return;
+
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(TrailComponent, StartsParameter, StartSamples);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(TrailComponent, EndsParameter, EndSamples);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(TrailComponent, HeadsParameter, Heads);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(TrailComponent, CountsParameter, Counts);
+	TrailComponent->SetVariableInt(SamplesParameter, Slots.Num() > 0 ? StartSamples.Num() / Slots.Num() : 0);
+}
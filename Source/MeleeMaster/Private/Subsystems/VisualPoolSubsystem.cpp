@@ -0,0 +1,236 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/VisualPoolSubsystem.h"
+
+#include "MeleeMaster.h"
+#include "Data/Interfaces/PooledVisual.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Subsystems/LoggerLib.h"
+
+static FAutoConsoleCommandWithWorld CmdMeleePoolStats(
+	TEXT("melee.Pool.Stats"),
+	TEXT("Logs hit-rate and high-water mark of weapon/arrow visual pool."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* InWorld) {
+		if (UVisualPoolSubsystem* pool = UVisualPoolSubsystem::Get(InWorld))
+		{
+			pool->DumpStats();
+		}
+	}));
+
+bool UVisualPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UVisualPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Visuals are cosmetic, dedicated server never acquires them
+	if (InWorld.GetNetMode() == NM_DedicatedServer)
+		return;
+
+	for (const FVisualPoolPrewarm& entry : Prewarm)
+	{
+		if (UClass* actorClass = entry.ActorClass.LoadSynchronous())
+		{
+			PrewarmClass(actorClass, entry.Count);
+		}
+		else
+		{
+			TRACEWARN(LogWeapon, "Invalid visual pool prewarm class '%s'", *entry.ActorClass.ToString());
+		}
+	}
+}
+
+void UVisualPoolSubsystem::Deinitialize()
+{
+	// Actors are destroyed with the world
+	Buckets.Empty();
+	AcquiredActors.Empty();
+	Super::Deinitialize();
+}
+
+UVisualPoolSubsystem* UVisualPoolSubsystem::Get(const UObject* WorldContextObject)
+{
+	if (!WorldContextObject)
+		return nullptr;
+
+	if (UWorld* world = WorldContextObject->GetWorld())
+	{
+		return world->GetSubsystem<UVisualPoolSubsystem>();
+	}
+	return nullptr;
+}
+
+AActor* UVisualPoolSubsystem::SpawnPooledActor(UClass* InClass, const FTransform& InTransform)
+{
+	LLM_SCOPE_BYTAG(MeleeMaster);
+	AActor* actor = GetWorld()->SpawnActorDeferred<AActor>(InClass, InTransform, nullptr, nullptr,
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!IsValid(actor))
+		return nullptr;
+
+	// Pooled actors are local cosmetics and never open an actor channel
+	actor->SetReplicates(false);
+	actor->FinishSpawning(InTransform);
+	return actor;
+}
+
+void UVisualPoolSubsystem::PrewarmClass(UClass* InClass, int32 InCount)
+{
+	if (!IsValid(InClass) || !InClass->IsChildOf(AActor::StaticClass()))
+		return;
+
+	FVisualPoolBucket& bucket = Buckets.FindOrAdd(InClass);
+	bucket.FreeActors.Reserve(bucket.FreeActors.Num() + InCount);
+	for (int32 i = 0; i < InCount; ++i)
+	{
+		AActor* actor = SpawnPooledActor(InClass, FTransform::Identity);
+		if (!IsValid(actor))
+			break;
+
+		if (actor->Implements<UPooledVisual>())
+		{
+			IPooledVisual::Execute_OnReleasedToPool(actor);
+		}
+		else
+		{
+			actor->SetActorHiddenInGame(true);
+		}
+		bucket.FreeActors.Add(actor);
+	}
+	bucket.Stats.Free = bucket.FreeActors.Num();
+}
+
+AActor* UVisualPoolSubsystem::Acquire(UClass* InClass, const FTransform& InTransform, AActor* InOwner)
+{
+	if (!IsValid(InClass) || !InClass->IsChildOf(AActor::StaticClass()))
+		return nullptr;
+
+	FVisualPoolBucket& bucket = Buckets.FindOrAdd(InClass);
+
+	AActor* actor = nullptr;
+	while (!actor && bucket.FreeActors.Num() > 0)
+	{
+		AActor* candidate = bucket.FreeActors.Pop();
+		if (IsValid(candidate) && !candidate->IsActorBeingDestroyed())
+		{
+			actor = candidate;
+		}
+	}
+
+	if (actor)
+	{
+		++bucket.Stats.Hits;
+		actor->SetActorTransform(InTransform, false, nullptr, ETeleportType::ResetPhysics);
+	}
+	else
+	{
+		actor = SpawnPooledActor(InClass, InTransform);
+		if (!actor)
+			return nullptr;
+		++bucket.Stats.Misses;
+	}
+
+	actor->SetOwner(InOwner);
+	actor->SetInstigator(Cast<APawn>(InOwner));
+
+	++bucket.Stats.InUse;
+	bucket.Stats.HighWater = FMath::Max(bucket.Stats.HighWater, bucket.Stats.InUse);
+	bucket.Stats.Free = bucket.FreeActors.Num();
+	AcquiredActors.Add(actor, InClass);
+
+	if (actor->Implements<UPooledVisual>())
+	{
+		IPooledVisual::Execute_OnAcquiredFromPool(actor);
+	}
+	else
+	{
+		actor->SetActorHiddenInGame(false);
+	}
+	return actor;
+}
+
+void UVisualPoolSubsystem::Release(AActor* InActor)
+{
+	if (!IsValid(InActor) || InActor->IsActorBeingDestroyed())
+		return;
+
+	UClass* actorClass = nullptr;
+	if (!AcquiredActors.RemoveAndCopyValue(InActor, actorClass))
+	{
+		InActor->Destroy();
+		return;
+	}
+
+	FVisualPoolBucket* bucket = Buckets.Find(actorClass);
+	if (!bucket)
+	{
+		InActor->Destroy();
+		return;
+	}
+	bucket->Stats.InUse = FMath::Max(bucket->Stats.InUse - 1, 0);
+
+	// World is going away, nothing to reuse
+	UWorld* world = GetWorld();
+	if (!world || world->bIsTearingDown || bucket->FreeActors.Num() >= MaxFreePerClass)
+	{
+		InActor->Destroy();
+		return;
+	}
+
+	InActor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	if (InActor->Implements<UPooledVisual>())
+	{
+		IPooledVisual::Execute_OnReleasedToPool(InActor);
+	}
+	else
+	{
+		InActor->SetActorHiddenInGame(true);
+	}
+	InActor->SetOwner(nullptr);
+	InActor->SetInstigator(nullptr);
+
+	bucket->FreeActors.Add(InActor);
+	bucket->Stats.Free = bucket->FreeActors.Num();
+}
+
+FVisualPoolStats UVisualPoolSubsystem::GetStats(UClass* InClass) const
+{
+	if (InClass)
+	{
+		if (const FVisualPoolBucket* bucket = Buckets.Find(InClass))
+		{
+			return bucket->Stats;
+		}
+		return FVisualPoolStats();
+	}
+
+	FVisualPoolStats total;
+	for (const TPair<UClass*, FVisualPoolBucket>& pair : Buckets)
+	{
+		total.Hits += pair.Value.Stats.Hits;
+		total.Misses += pair.Value.Stats.Misses;
+		total.InUse += pair.Value.Stats.InUse;
+		total.HighWater += pair.Value.Stats.HighWater;
+		total.Free += pair.Value.Stats.Free;
+	}
+	return total;
+}
+
+void UVisualPoolSubsystem::DumpStats() const
+{
+	for (const TPair<UClass*, FVisualPoolBucket>& pair : Buckets)
+	{
+		const FVisualPoolStats& stats = pair.Value.Stats;
+		TRACE(LogWeapon, "VisualPool %s: hits %d, misses %d (hit-rate %.1f%%), in use %d, high-water %d, free %d",
+			*GetNameSafe(pair.Key), stats.Hits, stats.Misses, stats.GetHitRate() * 100.0f,
+			stats.InUse, stats.HighWater, stats.Free);
+	}
+	const FVisualPoolStats total = GetStats();
+	TRACE(LogWeapon, "VisualPool total: hits %d, misses %d (hit-rate %.1f%%), in use %d, high-water %d, free %d",
+		total.Hits, total.Misses, total.GetHitRate() * 100.0f, total.InUse, total.HighWater, total.Free);
+}
@@ -0,0 +1,75 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeCombatMath.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Misc/AutomationTest.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeleeCombatMathBlockTest, "MeleeMaster.CombatMath.Block",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMeleeCombatMathBlockTest::RunTest(const FString& Parameters)
+{
+	using EDir = EWeaponDirection;
+
+	TestTrue(TEXT("Forward blocks Forward"), FMeleeCombatMath::IsBlockDirectionMatched(EDir::Forward, EDir::Forward));
+	TestTrue(TEXT("Backward blocks Backward"), FMeleeCombatMath::IsBlockDirectionMatched(EDir::Backward, EDir::Backward));
+	TestTrue(TEXT("Left blocks Right"), FMeleeCombatMath::IsBlockDirectionMatched(EDir::Right, EDir::Left));
+	TestTrue(TEXT("Right blocks Left"), FMeleeCombatMath::IsBlockDirectionMatched(EDir::Left, EDir::Right));
+	TestFalse(TEXT("Right does not block Right"), FMeleeCombatMath::IsBlockDirectionMatched(EDir::Right, EDir::Right));
+	TestFalse(TEXT("Left does not block Forward"), FMeleeCombatMath::IsBlockDirectionMatched(EDir::Forward, EDir::Left));
+
+	TestTrue(TEXT("Shield"), FMeleeCombatMath::ResolveBlock(true, EWeaponTier::Light, EWeaponTier::High, 0.3f, 0.8f)
+		== EBlockResult::ShieldBlock);
+	TestTrue(TEXT("Parry"), FMeleeCombatMath::ResolveBlock(false, EWeaponTier::Medium, EWeaponTier::Medium, 0.3f, 0.8f)
+		== EBlockResult::Parry);
+	TestTrue(TEXT("Higher tier is not parried"),
+		FMeleeCombatMath::ResolveBlock(false, EWeaponTier::Light, EWeaponTier::Medium, 0.3f, 0.8f) == EBlockResult::Block);
+	TestTrue(TEXT("Stronger attack is blocked"),
+		FMeleeCombatMath::ResolveBlock(false, EWeaponTier::High, EWeaponTier::Light, 0.8f, 0.3f) == EBlockResult::Block);
+	TestTrue(TEXT("Full power attack is blocked"),
+		FMeleeCombatMath::ResolveBlock(false, EWeaponTier::High, EWeaponTier::Light, 1.0f, 2.0f) == EBlockResult::Block);
+
+	TestTrue(TEXT("Front is in block angle"),
+		FMeleeCombatMath::IsInBlockAngle(FVector::ForwardVector, FVector(100.0f, 0.0f, 500.0f), 90.0f));
+	TestTrue(TEXT("Side is in wide block angle"),
+		FMeleeCombatMath::IsInBlockAngle(FVector::ForwardVector, FVector(10.0f, 100.0f, 0.0f), 180.0f));
+	TestFalse(TEXT("Side is out of block angle"),
+		FMeleeCombatMath::IsInBlockAngle(FVector::ForwardVector, FVector::RightVector, 170.0f));
+	TestFalse(TEXT("Back is out of block angle"),
+		FMeleeCombatMath::IsInBlockAngle(FVector::ForwardVector, -FVector::ForwardVector, 270.0f));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeleeCombatMathAttackTest, "MeleeMaster.CombatMath.Attack",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMeleeCombatMathAttackTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Curve time at start"), FMeleeCombatMath::GetChargingCurveTime(10.0f, 11.5f, 10.0f), 0.0f);
+	TestEqual(TEXT("Curve time in the middle"), FMeleeCombatMath::GetChargingCurveTime(10.0f, 11.5f, 10.5f), 0.5f,
+		KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("Curve time at finish"), FMeleeCombatMath::GetChargingCurveTime(10.0f, 11.5f, 11.5f), 1.5f,
+		KINDA_SMALL_NUMBER);
+
+	TestEqual(TEXT("No combo"), FMeleeCombatMath::EvaluateComboDamage(20.0f, 0.0f), 20.0f);
+	TestEqual(TEXT("Combo bonus"), FMeleeCombatMath::EvaluateComboDamage(20.0f, 0.25f), 25.0f);
+
+	FWeaponHitDataElement element;
+	element.Start = FVector(0.0f, 100.0f, 0.0f);
+	element.End = FVector(50.0f, 100.0f, 0.0f);
+	FVector start;
+	FVector end;
+	FRotator rotation;
+	FMeleeCombatMath::TransformHitSegment(FRotator(45.0f, 90.0f, 0.0f), FVector(0.0f, 0.0f, 100.0f), 20.0f, element,
+		start, end, rotation);
+	// Yaw 90 faces +Y as the path is authored, so it is only offset, pitch is ignored
+	TestTrue(TEXT("Hit segment start"), start.Equals(FVector(0.0f, 100.0f, 120.0f), 0.01f));
+	TestTrue(TEXT("Hit segment end"), end.Equals(FVector(50.0f, 100.0f, 120.0f), 0.01f));
+	TestEqual(TEXT("Hit segment pitch"), rotation.Pitch, 0.0f);
+	return true;
+}
+
+#endif
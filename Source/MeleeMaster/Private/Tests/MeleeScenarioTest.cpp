@@ -0,0 +1,236 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Subsystems/MeleeScenarioSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Curves/CurveFloat.h"
+#include "Data/MeleeWeaponAnimDataAsset.h"
+#include "Data/MeleeWeaponDataAsset.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/MeleeTestWeapon.h"
+#include "UObject/StrongObjectPtr.h"
+
+namespace MeleeScenarioTest
+{
+	/** World frames a run may take */
+	static constexpr int32 MaxFrames = 60 * 120;
+
+	/** World frames per latent update */
+	static constexpr int32 FramesPerUpdate = 10;
+
+	static const TCHAR* BuiltInNames[] = {
+		TEXT("Swing"),
+		TEXT("CancelCharge"),
+		TEXT("BlockRelease"),
+		TEXT("ChargeToBlock"),
+		TEXT("ParryStun"),
+		TEXT("ShieldDurability")
+	};
+
+	/**
+	 * @brief Game world the scenarios run in, ticked by the latent commands only.
+	 */
+	struct FContext
+	{
+		~FContext()
+		{
+			if (World.IsValid())
+			{
+				World->DestroyWorld(false);
+			}
+		}
+
+		TStrongObjectPtr<UWorld> World;
+		TStrongObjectPtr<UMeleeWeaponDataAsset> Weapon;
+		int32 Frames{0};
+		bool bStarted{false};
+	};
+
+	static UCurveFloat* MakeCurve(UObject* InOuter, float InValue)
+	{
+		UCurveFloat* curve = NewObject<UCurveFloat>(InOuter);
+		curve->FloatCurve.AddKey(0.0f, InValue);
+		return curve;
+	}
+
+	/**
+	 * @brief Shield weapon whose swing is weaker than its block, so a block in time parries.
+	 */
+	static UMeleeWeaponDataAsset* MakeWeapon()
+	{
+		UMeleeWeaponDataAsset* weapon = NewObject<UMeleeWeaponDataAsset>(GetTransientPackage(), NAME_None,
+			RF_Transient);
+		weapon->WeaponClass = UMeleeTestWeapon::StaticClass();
+		weapon->Animations = NewObject<UMeleeWeaponAnimDataAsset>(weapon);
+		weapon->EquipTime = 0.2f;
+		weapon->DeEquipTime = 0.2f;
+		weapon->bHasShield = true;
+		weapon->ShieldGetTime = 0.2f;
+		weapon->ShieldRemoveTime = 0.2f;
+		weapon->Base.Attack.Forward.Curve = MakeCurve(weapon, 0.3f);
+		weapon->Base.Block.Forward.Curve = MakeCurve(weapon, 0.8f);
+		weapon->Shield = weapon->Base;
+		return weapon;
+	}
+
+	static UWorld* CreateWorld()
+	{
+		UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MeleeScenarioTest"));
+		world->InitializeActorsForPlay(FURL());
+
+		// Charging reads the server time from the game state, no game mode spawns it here
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.ObjectFlags = RF_Transient;
+		AGameStateBase* gameState = world->SpawnActor<AGameStateBase>(spawnParameters);
+		world->SetGameState(gameState);
+		gameState->HandleBeginPlay();
+		return world;
+	}
+
+	/**
+	 * @brief Fighting statuses InActor entered in order.
+	 */
+	static FString GetSequence(const FMeleeScenarioResult& InResult, int32 InActor)
+	{
+		TArray<FString> names;
+		for (const FMeleeScenarioTransition& transition : InResult.Transitions)
+		{
+			const FMeleeStateTransition& value = transition.Transition;
+			if (transition.Actor == InActor && !value.bManaging && value.From != value.To)
+			{
+				names.Add(FMeleeStateMachine::GetStatusName(value, true));
+			}
+		}
+		return FString::Join(names, TEXT(", "));
+	}
+
+	static FString MakeSequence(const TArray<EWeaponFightingStatus>& InStatuses)
+	{
+		TArray<FString> names;
+		for (const EWeaponFightingStatus status : InStatuses)
+		{
+			names.Add(UEnum::GetDisplayValueAsText(status).ToString());
+		}
+		return FString::Join(names, TEXT(", "));
+	}
+}
+
+/**
+ * @brief Ticks the test world until the scenarios finish.
+ */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FMeleeScenarioRunCommand,
+	TSharedRef<MeleeScenarioTest::FContext>, Context, FAutomationTestBase*, Test);
+
+bool FMeleeScenarioRunCommand::Update()
+{
+	using namespace MeleeScenarioTest;
+
+	UWorld* world = Context->World.Get();
+	UMeleeScenarioSubsystem* scenario = UMeleeScenarioSubsystem::Get(world);
+	if (!scenario)
+	{
+		Test->AddError(TEXT("No scenario subsystem in the test world"));
+		return true;
+	}
+
+	if (!Context->bStarted)
+	{
+		Context->bStarted = true;
+		scenario->Run(FString(), Context->Weapon.Get());
+	}
+
+	for (int32 i = 0; i < FramesPerUpdate && scenario->IsRunning() && Context->Frames < MaxFrames; ++i)
+	{
+		world->Tick(LEVELTICK_All, scenario->GetFixedStep());
+		++Context->Frames;
+	}
+
+	if (!scenario->IsRunning())
+		return true;
+
+	if (Context->Frames >= MaxFrames)
+	{
+		Test->AddError(FString::Printf(TEXT("Scenarios did not finish in %d frames"), MaxFrames));
+		scenario->Stop();
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Checks every built-in scenario passed and the state sequences of parry and shield break.
+ */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FMeleeScenarioCheckCommand,
+	TSharedRef<MeleeScenarioTest::FContext>, Context, FAutomationTestBase*, Test);
+
+bool FMeleeScenarioCheckCommand::Update()
+{
+	using namespace MeleeScenarioTest;
+	using EFight = EWeaponFightingStatus;
+
+	const UMeleeScenarioSubsystem* scenario = UMeleeScenarioSubsystem::Get(Context->World.Get());
+	if (!scenario)
+		return true;
+
+	const TArray<FMeleeScenarioResult>& results = scenario->GetLastResults();
+	auto findResult = [&results](const TCHAR* InName) {
+		return results.FindByPredicate([InName](const FMeleeScenarioResult& InResult) {
+			return InResult.Name == InName;
+		});
+	};
+
+	for (const TCHAR* name : BuiltInNames)
+	{
+		const FMeleeScenarioResult* result = findResult(name);
+		if (!Test->TestNotNull(FString::Printf(TEXT("%s result"), name), result))
+			continue;
+
+		Test->TestFalse(FString::Printf(TEXT("%s skipped"), name), result->bSkipped);
+		Test->TestTrue(FString::Printf(TEXT("%s: %s"), name, *FString::Join(result->Errors, TEXT("; "))),
+			result->bPassed);
+	}
+
+	if (const FMeleeScenarioResult* parry = findResult(TEXT("ParryStun")))
+	{
+		Test->TestEqual(TEXT("ParryStun attacker"), GetSequence(*parry, 0), MakeSequence({
+			EFight::PreAttack, EFight::AttackCharging, EFight::Attacking, EFight::ParryStunned, EFight::Idle
+		}));
+		// Shield removal, block, parry charge
+		Test->TestEqual(TEXT("ParryStun defender"), GetSequence(*parry, 1), MakeSequence({
+			EFight::Busy, EFight::Idle, EFight::BlockCharging, EFight::AttackCharging
+		}));
+	}
+	if (const FMeleeScenarioResult* shield = findResult(TEXT("ShieldDurability")))
+	{
+		Test->TestEqual(TEXT("ShieldDurability attacker"), GetSequence(*shield, 0), MakeSequence({
+			EFight::PreAttack, EFight::AttackCharging, EFight::Attacking, EFight::PostAttack, EFight::Idle
+		}));
+		Test->TestEqual(TEXT("ShieldDurability defender"), GetSequence(*shield, 1), MakeSequence({
+			EFight::BlockCharging, EFight::PostBlock, EFight::Idle
+		}));
+	}
+	return true;
+}
+
+/**
+ * @brief Runs the built-in scenarios with a scripted attacker and defender in a standalone game world.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeleeScenarioBuiltInTest, "MeleeMaster.Scenario.BuiltIn",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMeleeScenarioBuiltInTest::RunTest(const FString& Parameters)
+{
+	const TSharedRef<MeleeScenarioTest::FContext> context = MakeShared<MeleeScenarioTest::FContext>();
+	context->World.Reset(MeleeScenarioTest::CreateWorld());
+	context->Weapon.Reset(MeleeScenarioTest::MakeWeapon());
+
+	ADD_LATENT_AUTOMATION_COMMAND(FMeleeScenarioRunCommand(context, this));
+	ADD_LATENT_AUTOMATION_COMMAND(FMeleeScenarioCheckCommand(context, this));
+	return true;
+}
+
+#endif
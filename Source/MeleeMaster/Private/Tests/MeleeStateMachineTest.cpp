@@ -0,0 +1,70 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+
+#include "Libs/MeleeStateMachine.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Misc/AutomationTest.h"
+
+namespace MeleeStateMachineTest
+{
+	template <typename TEnum>
+	static bool IsValidSequence(const TArray<TEnum>& InSequence)
+	{
+		for (int32 i = 1; i < InSequence.Num(); ++i)
+		{
+			if (!FMeleeStateMachine::IsValidTransition(InSequence[i - 1], InSequence[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeleeStateMachineTransitionTest, "MeleeMaster.StateMachine.Transitions",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMeleeStateMachineTransitionTest::RunTest(const FString& Parameters)
+{
+	using namespace MeleeStateMachineTest;
+	using EFight = EWeaponFightingStatus;
+	using EManage = EWeaponManagingStatus;
+
+	TestTrue(TEXT("Swing"), IsValidSequence<EFight>({
+		EFight::Idle, EFight::PreAttack, EFight::AttackCharging, EFight::Attacking, EFight::PostAttack, EFight::Idle
+	}));
+	TestTrue(TEXT("Charge to block"), IsValidSequence<EFight>({
+		EFight::Idle, EFight::PreAttack, EFight::AttackCharging, EFight::BlockCharging, EFight::PostBlock, EFight::Idle
+	}));
+	TestTrue(TEXT("Parried swing"), IsValidSequence<EFight>({
+		EFight::Idle, EFight::PreAttack, EFight::AttackCharging, EFight::Attacking, EFight::ParryStunned, EFight::Idle
+	}));
+	TestTrue(TEXT("Parry"), IsValidSequence<EFight>({
+		EFight::Idle, EFight::BlockCharging, EFight::AttackCharging, EFight::Attacking
+	}));
+	TestTrue(TEXT("Ranged block"), IsValidSequence<EFight>({
+		EFight::Idle, EFight::PreAttack, EFight::RangeCharging, EFight::BlockCharging
+	}));
+	TestTrue(TEXT("StopWork"), IsValidSequence<EFight>({EFight::Attacking, EFight::Busy, EFight::Idle}));
+
+	TestFalse(TEXT("Idle -> Attacking"), FMeleeStateMachine::IsValidTransition(EFight::Idle, EFight::Attacking));
+	TestFalse(TEXT("Idle -> PostBlock"), FMeleeStateMachine::IsValidTransition(EFight::Idle, EFight::PostBlock));
+	TestFalse(TEXT("PostAttack -> Attacking"),
+		FMeleeStateMachine::IsValidTransition(EFight::PostAttack, EFight::Attacking));
+	TestFalse(TEXT("ParryStunned -> AttackCharging"),
+		FMeleeStateMachine::IsValidTransition(EFight::ParryStunned, EFight::AttackCharging));
+
+	TestTrue(TEXT("Equip"), IsValidSequence<EManage>({
+		EManage::NoWeapon, EManage::Equipping, EManage::Idle, EManage::DeEquipping, EManage::NoWeapon
+	}));
+	TestTrue(TEXT("Shield"), IsValidSequence<EManage>({
+		EManage::Idle, EManage::ShieldRemoving, EManage::Idle, EManage::ShieldGetting, EManage::Idle
+	}));
+	TestFalse(TEXT("NoWeapon -> DeEquipping"),
+		FMeleeStateMachine::IsValidTransition(EManage::NoWeapon, EManage::DeEquipping));
+	TestFalse(TEXT("Equipping -> DeEquipping"),
+		FMeleeStateMachine::IsValidTransition(EManage::Equipping, EManage::DeEquipping));
+	return true;
+}
+
+#endif
@@ -0,0 +1,16 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Objects/MeleeWeapon.h"
+#include "MeleeTestWeapon.generated.h"
+
+/**
+ * @brief Melee weapon created by automation tests, UMeleeWeapon is abstract.
+ */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UMeleeTestWeapon : public UMeleeWeapon
+{
+	GENERATED_BODY()
+};
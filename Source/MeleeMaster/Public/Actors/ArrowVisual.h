@@ -3,11 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Data/Interfaces/PooledVisual.h"
 #include "GameFramework/Actor.h"
 #include "ArrowVisual.generated.h"
 
 UCLASS()
-class MELEEMASTER_API AArrowVisual : public AActor
+class MELEEMASTER_API AArrowVisual : public AActor, public IPooledVisual
 {
 	GENERATED_BODY()
 
@@ -27,6 +28,9 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual void OnAcquiredFromPool_Implementation() override;
+	virtual void OnReleasedToPool_Implementation() override;
+
 	void SetSkeletal(USkeletalMesh* InMesh);
 
 	void Show();
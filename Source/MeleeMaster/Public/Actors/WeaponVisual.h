@@ -4,16 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "Components/AdvancedWeaponManager.h"
+#include "Data/Interfaces/PooledVisual.h"
 #include "GameFramework/Actor.h"
 #include "WeaponVisual.generated.h"
 
+class UStaticMeshComponent;
+
 /**
  * @class AWeaponVisual
  * @brief Visual representation of a weapon in the game. 
  * Manages mesh, sockets, and replication for multiplayer.
  */
 UCLASS()
-class MELEEMASTER_API AWeaponVisual : public AActor
+class MELEEMASTER_API AWeaponVisual : public AActor, public IPooledVisual
 {
 	GENERATED_BODY()
 
@@ -38,6 +41,13 @@ protected:
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="WeaponVisual|Components")
 	USkeletalMeshComponent* SkeletalMeshComponent;
 
+	/**
+	 * @brief Static mesh drawn instead of the skeletal mesh while the weapon is on the back
+	 * of a distant fighter (EWeaponVisualLOD::Proxy). Leave its mesh empty to disable the swap.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="WeaponVisual|Components")
+	UStaticMeshComponent* ProxyMeshComponent;
+
 	/**
 	 * @brief Socket name for attaching the weapon to the character's hand.
 	 */
@@ -51,19 +61,54 @@ protected:
 	FName BackSocket;
 
 	/**
-	 * @brief Unique ID for multiplayer replication.
+	 * @brief Blade sockets of the skeletal mesh recorded by UTrailSubsystem.
+	 * If None (or no trail system is configured) ShowTrail/HideTrail events are used instead.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="WeaponVisual|Sockets")
+	FName TrailStartSocket;
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="WeaponVisual|Sockets")
+	FName TrailEndSocket;
+
+	/**
+	 * @brief Id of the running batched trail, INDEX_NONE if none.
+	 */
+	int32 BatchedTrailId{INDEX_NONE};
+
+	/**
+	 * @brief Handle of the owning weapon inside its weapon manager.
 	 * This is used to ensure each weapon instance can be properly identified in a multiplayer setting.
 	 */
-	UPROPERTY(Transient, ReplicatedUsing=OnRep_Guid, BlueprintReadOnly, Category="WeaponVisual|Replicated")
-	FString WeaponGuid;
+	UPROPERTY(Transient, ReplicatedUsing=OnRep_WeaponHandle, BlueprintReadOnly, Category="WeaponVisual|Replicated")
+	FWeaponHandle WeaponHandle;
+
+	/**
+	 * @brief Current visual LOD, driven by the owner weapon manager (client only).
+	 */
+	UPROPERTY(Transient, BlueprintReadOnly, Category="WeaponVisual|LOD")
+	EWeaponVisualLOD VisualLOD{EWeaponVisualLOD::Full};
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category="WeaponVisual|LOD")
+	bool bAttachedToBack{false};
+
+protected:
+	/**
+	 * @brief Applies shadows and proxy mesh swap for current VisualLOD.
+	 */
+	virtual void ApplyVisualLOD();
+
+	/**
+	 * @brief True if the static mesh proxy should be drawn instead of the skeletal mesh.
+	 */
+	bool ShouldUseProxyMesh() const;
 
 protected:
 	/**
-	 * @brief Called when the weapon GUID is replicated.
-	 * This function is triggered automatically when the GUID is updated on clients.
+	 * @brief Called when the weapon handle is replicated.
+	 * This function is triggered automatically when the handle is updated on clients.
 	 */
 	UFUNCTION()
-	virtual void OnRep_Guid();
+	virtual void OnRep_WeaponHandle();
 
 protected:
 	// Called when the game starts or when spawned
@@ -74,9 +119,27 @@ public:
 	virtual void Tick(float DeltaTime) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/**
+	 * @brief Includes mesh components in EstimatedTotal mode (render instance data, not mesh assets).
+	 */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void BP_PhysicsActivated();
+
+	virtual void OnAcquiredFromPool_Implementation() override;
+	virtual void OnReleasedToPool_Implementation() override;
 public:
+	/**
+	 * @brief Attaches to hand or back of the owner, depending on its current weapon.
+	 * Called on BeginPlay and when the visual is taken from the pool.
+	 */
+	void AttachToWeaponManager();
+
+	/**
+	 * @brief Stops physics of the dropped visual and restores mesh attachment and collision.
+	 */
+	virtual void ResetPhysics();
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="WeaponVisual")
 	bool IsLocalPlayer() const;
@@ -89,6 +152,21 @@ public:
 	
 	UFUNCTION(BlueprintCallable, Category="WeaponVisual")
 	virtual void Show();
+
+	/**
+	 * @brief Sets visual LOD, applied right away unless the visual is hidden.
+	 * @param InLOD New visual LOD.
+	 */
+	UFUNCTION(BlueprintCallable, Category="WeaponVisual|LOD")
+	void SetVisualLOD(EWeaponVisualLOD InLOD);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="WeaponVisual|LOD")
+	FORCEINLINE EWeaponVisualLOD GetVisualLOD() const { return VisualLOD; }
+
+	/**
+	 * @brief Called by the weapon manager when the visual is attached to the back or hand.
+	 */
+	void SetAttachedToBack(bool bInBack);
 	
 	/**
 	 * @brief Retrieves the visual index of the weapon.
@@ -98,18 +176,19 @@ public:
 	int32 GetVisualIndex() const;
 
 	/**
-	 * @brief Returns the weapon's unique GUID as a string.
-	 * @return The weapon's GUID string.
+	 * @brief Returns the handle of the owning weapon.
+	 * @return The weapon handle.
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="WeaponVisual")
-	FORCEINLINE FString GetGUIDString() const { return WeaponGuid; }
+	FORCEINLINE FWeaponHandle GetWeaponHandle() const { return WeaponHandle; }
 
 	/**
-	 * @brief Sets the weapon's GUID.
-	 * @param InGuid The new GUID to set.
+	 * @brief Sets the handle of the owning weapon.
+	 * Visual is dormant, so the change flushes dormancy to replicate it.
+	 * @param InHandle The new weapon handle.
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="WeaponVisual")
-	void SetGuidString(FString InGuid);
+	void SetWeaponHandle(FWeaponHandle InHandle);
 
 	/**
 	 * @brief Returns the skeletal mesh component of the weapon.
@@ -150,4 +229,16 @@ public:
 
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent)
 	void ShowTrail();
+
+	/**
+	 * @brief Starts weapon trail, batched by UTrailSubsystem if possible, ShowTrail event otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="WeaponVisual")
+	void StartTrail();
+
+	/**
+	 * @brief Ends batched trail and calls HideTrail event.
+	 */
+	UFUNCTION(BlueprintCallable, Category="WeaponVisual")
+	void StopTrail();
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
 #include "WeaponTypes.h"
 #include "Data/MeleeWeaponDataAsset.h"
 #include "Data/WeaponAnimationDataAsset.h"
@@ -12,6 +13,7 @@
 
 
 enum class EDamageReturn : uint8;
+struct FStreamableHandle;
 class AWeaponVisual;
 class UAbstractWeapon;
 class UWeaponDataAsset;
@@ -42,6 +44,24 @@ public:
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	FName SectionName{"None"};
+
+	/**
+	 * @brief Montages resolved from the manager montage cache, listeners do not need to load AnimSet.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	UAnimMontage* FirstPersonMontage{nullptr};
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	UAnimMontage* ThirdPersonMontage{nullptr};
+
+	/**
+	 * @brief Play rates fitting montage Length into Time.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float FirstPersonPlayRate{1.0f};
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float ThirdPersonPlayRate{1.0f};
 };
 
 USTRUCT(Blueprintable, BlueprintType)
@@ -62,8 +82,11 @@ public:
 	{
 	}
 
+	/**
+	 * @brief Hit location, quantized so the struct has a native Iris serializer.
+	 */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
-	FVector Location;
+	FVector_NetQuantize Location;
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	float BaseDamage;
@@ -115,6 +138,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FWeaponManagerMeleeCameraShake,
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAdvancedWeaponFloatDelegate,
 											 float, InValue);
+
+DECLARE_MULTICAST_DELEGATE_FourParams(FOnMeleeDamageDealt, UAdvancedWeaponManager*, AActor*, EDamageReturn, float);
 /**
  * @class UAdvancedWeaponManager
  * @brief Manages advanced weapon systems for characters.
@@ -134,10 +159,10 @@ public:
 public:
 #pragma region Local
 	/**
-	 * @brief GUID string used to save and identify weapon instances.
+	 * @brief Handle of the last animated weapon, used by attach anim notifies.
 	 */
 	UPROPERTY(BlueprintReadWrite)
-	FString SavedGuid;
+	FWeaponHandle SavedHandle;
 
 	UPROPERTY(Transient)
 	TWeakObjectPtr<UAbstractWeapon> NextEquip;
@@ -145,6 +170,13 @@ public:
 	UPROPERTY(BlueprintReadOnly)
 	int32 HitNum{0};
 
+	/**
+	 * @brief Victims damaged by the current swing.
+	 * @see UMeleeWeaponDataAsset::bDamageOncePerSwing
+	 */
+	UPROPERTY(Transient)
+	TSet<TWeakObjectPtr<AActor>> SwingHitActors; // Server only
+
 	UPROPERTY(BlueprintReadOnly)
 	float HitPower{1.0f}; // Server only
 
@@ -164,6 +196,74 @@ protected:
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Weapons")
 	TArray<TSoftObjectPtr<UWeaponDataAsset>> DefaultWeapons;
 
+	/**
+	 * @brief Drive owner net update frequency by fighting status (server only).
+	 * Charging and attacking phases replicate at CombatNetUpdateFrequency,
+	 * idle phase lets adaptive net update frequency fall down to IdleMinNetUpdateFrequency.
+	 * @note Idle rate needs net.UseAdaptiveNetUpdateFrequency, the owner rate is used without it.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Network")
+	bool bAdaptiveNetUpdateFrequency{true};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Network",
+		meta=(EditCondition="bAdaptiveNetUpdateFrequency", ClampMin="1.0"))
+	float CombatNetUpdateFrequency{60.0f};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Network",
+		meta=(EditCondition="bAdaptiveNetUpdateFrequency", ClampMin="0.1"))
+	float IdleMinNetUpdateFrequency{2.0f};
+
+	/**
+	 * @brief Spawn weapon visuals locally on every machine (not replicated).
+	 * Clients create them from replicated WeaponList/Data, dedicated server keeps no visual actors.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Network")
+	bool bClientSideVisuals{false};
+
+	/**
+	 * @brief Throttle client modifier charging updates by significance of the owner.
+	 * Local player is updated every frame, rendered fighters inside ModifierCullDistance
+	 * every ModifierReducedInterval, the rest receive only idle transitions.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Modifier")
+	bool bModifierSignificance{true};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Modifier",
+		meta=(EditCondition="bModifierSignificance", ClampMin="0.0"))
+	float ModifierReducedInterval{0.1f};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Modifier",
+		meta=(EditCondition="bModifierSignificance", ClampMin="0.0"))
+	float ModifierCullDistance{5000.0f};
+
+	/**
+	 * @brief Tick interval of simulated proxy managers. Tick is enabled only while charging.
+	 * 0 ticks every frame.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|Modifier",
+		meta=(ClampMin="0.0"))
+	float SimulatedProxyTickInterval{0.0f};
+
+	/**
+	 * @brief Drive weapon visual LOD by distance to the local view (client only).
+	 * Beyond VisualShadowDistance shadows and trails are dropped,
+	 * beyond VisualProxyDistance weapons on the back are swapped to static mesh proxies.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|VisualLOD")
+	bool bVisualLOD{true};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|VisualLOD",
+		meta=(EditCondition="bVisualLOD", ClampMin="0.05"))
+	float VisualLODInterval{0.25f};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|VisualLOD",
+		meta=(EditCondition="bVisualLOD", ClampMin="0.0"))
+	float VisualShadowDistance{2500.0f};
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="AdvancedWeaponManager|VisualLOD",
+		meta=(EditCondition="bVisualLOD", ClampMin="0.0"))
+	float VisualProxyDistance{5000.0f};
+
 
 #pragma endregion
 
@@ -247,6 +347,181 @@ protected:
 	FTimerHandle FightTimerHandle;
 
 	FTimerHandle HittingTimerHandle;
+
+	FTimerHandle VisualLODTimerHandle;
+#pragma endregion
+
+#pragma region Network
+
+protected:
+	/**
+	 * @brief Owner net update frequencies captured on BeginPlay, restored outside of combat phases.
+	 */
+	float OwnerNetUpdateFrequency{0.0f};
+	float OwnerMinNetUpdateFrequency{0.0f};
+
+	/**
+	 * @brief Applies owner net update frequency for the current fighting status.
+	 * @see bAdaptiveNetUpdateFrequency
+	 */
+	virtual void UpdateOwnerNetUpdateFrequency(EWeaponFightingStatus InPrevious);
+
+	/**
+	 * @brief Last allocated weapon handle (server only).
+	 */
+	uint16 LastWeaponHandle{0};
+
+	/**
+	 * @brief Handle to weapon lookup. Rebuilt from WeaponList when dirty.
+	 * @see WeaponByHandle
+	 */
+	mutable TMap<FWeaponHandle, TWeakObjectPtr<UAbstractWeapon>> WeaponHandleMap;
+
+	/**
+	 * @brief WeaponHandleMap is out of date, rebuilt on the next WeaponByHandle.
+	 * Set when WeaponList changes or a weapon handle is replicated.
+	 */
+	mutable bool bWeaponHandleMapDirty{true};
+
+	/**
+	 * @brief Allocates a new handle, unique inside this manager.
+	 */
+	FWeaponHandle MakeWeaponHandle();
+
+	/**
+	 * @brief Rebuilds WeaponHandleMap from WeaponList.
+	 */
+	void RebuildWeaponHandleMap() const;
+
+	/**
+	 * @brief Locally spawned visuals per weapon (bClientSideVisuals).
+	 * Kept by the manager, because replicated weapon object is gone when it is removed on the server.
+	 */
+	TMap<TObjectKey<UAbstractWeapon>, TArray<TWeakObjectPtr<AWeaponVisual>>> LocalVisualMap;
+
+	/**
+	 * @brief Creates local visuals for new weapons and destroys visuals of removed ones.
+	 * @see bClientSideVisuals
+	 */
+	virtual void SyncLocalVisuals();
+
+	/**
+	 * @brief Returns local visuals of the weapon to the visual pool and forgets it.
+	 */
+	void ReleaseLocalVisuals(const TObjectKey<UAbstractWeapon>& InWeaponKey);
+#pragma endregion
+
+#pragma region Significance
+
+protected:
+	/**
+	 * @brief Last evaluated significance, refreshed every ModifierReducedInterval (client only).
+	 */
+	UPROPERTY(Transient, BlueprintReadOnly)
+	EWeaponModifierSignificance ModifierSignificance{EWeaponModifierSignificance::Full};
+
+	float ModifierUpdateAccumulator{0.0f};
+
+	/**
+	 * @brief Last state sent to the modifier manager, used to send IdleState only on transition.
+	 */
+	bool bModifierCharging{false};
+	TWeakObjectPtr<UAbstractWeapon> LastModifierWeapon;
+
+	/**
+	 * @brief Evaluates how important the owner is for the local viewer.
+	 * @return Full for the local player, Reduced for rendered fighters inside ModifierCullDistance,
+	 * Insignificant otherwise.
+	 */
+	virtual EWeaponModifierSignificance EvaluateModifierSignificance() const;
+
+	/**
+	 * @brief Evaluates weapon visual LOD of the owner for the local viewer.
+	 */
+	virtual EWeaponVisualLOD EvaluateVisualLOD() const;
+
+	/**
+	 * @brief Applies EvaluateVisualLOD to every visual of owned weapons. Called by VisualLODTimerHandle.
+	 */
+	void UpdateVisualLOD();
+
+	/**
+	 * @brief Gets view location of the first local player.
+	 * @return False if there is no local player controller.
+	 */
+	bool GetLocalViewLocation(FVector& OutLocation) const;
+
+	/**
+	 * @brief Calls UpdateModifierCharging as often as current significance allows.
+	 * @see bModifierSignificance
+	 */
+	void TickModifierCharging(float DeltaTime);
+
+public:
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	FORCEINLINE EWeaponModifierSignificance GetModifierSignificance() const { return ModifierSignificance; }
+
+protected:
+	/**
+	 * @brief Enables component tick on entering charging statuses and disables it on leaving.
+	 * Sends the final modifier update on leaving. Never ticks on dedicated server.
+	 */
+	void UpdateChargingTick(EWeaponFightingStatus InPrevious);
+#pragma endregion
+
+#pragma region Animation
+
+protected:
+	/**
+	 * @brief Montages of owned weapons, resolved when a weapon is added or equipped.
+	 * Keeps them loaded and removes path lookups from the play path.
+	 * Value is null while the montage is loading or if it failed to load.
+	 */
+	UPROPERTY(Transient)
+	TMap<FSoftObjectPath, UAnimMontage*> MontageCache;
+
+	/**
+	 * @brief Montage paths of weapon data in MontageCache.
+	 * Collected by reflection once per data asset, weapons sharing data share the entry.
+	 */
+	TMap<TObjectKey<UWeaponDataAsset>, TArray<FSoftObjectPath>> MontagePathsByData;
+
+	/** Async loads of not yet loaded montages */
+	TArray<TSharedPtr<FStreamableHandle>> MontageLoadHandles;
+
+	/**
+	 * @brief Caches every montage of weapon data and animation data.
+	 * Loaded ones are cached at once, the rest are loaded async and cached when the load completes.
+	 * Failed loads are removed from MontageCache, so the next call for the weapon retries them.
+	 * Skipped on dedicated server, it does not play montages.
+	 */
+	void CacheWeaponMontages(UAbstractWeapon* InWeapon);
+
+	/**
+	 * @brief Caches montages of weapons with new data in WeaponList, drops montages of removed weapons.
+	 * Pending loads are kept, loads of dropped montages finish without being cached.
+	 */
+	void UpdateMontageCache();
+
+	/**
+	 * @brief Cancels pending montage loads and empties MontageCache and MontagePathsByData.
+	 */
+	void ResetMontageCache();
+
+	/**
+	 * @brief Fills resolved montages and play rates of the play data.
+	 */
+	void ResolveAnimPlayData(FAnimPlayData& InOutData) const;
+
+public:
+	/**
+	 * @brief Returns cached montage, falls back to resolving not cached and still loading ones.
+	 * @return Montage or nullptr if it is not loaded.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	UAnimMontage* GetCachedMontage(const TSoftObjectPtr<UAnimMontage>& InMontage) const;
+
+	FORCEINLINE const TMap<FSoftObjectPath, UAnimMontage*>& GetMontageCache() const { return MontageCache; }
 #pragma endregion
 
 #pragma region PrivateSet
@@ -277,10 +552,10 @@ protected:
 	virtual void SetDirection(EWeaponDirection InDirection);
 
 	/**
-	 * @brief Sets the saved GUID value.
-	 * @param Value The new GUID value.
+	 * @brief Sets the saved weapon handle.
+	 * @param Value The new handle value.
 	 */
-	virtual void SetSavedGuid(FString Value);
+	virtual void SetSavedHandle(FWeaponHandle Value);
 
 
 	virtual void SetChargingCurve(UCurveFloat* InCurve);
@@ -298,11 +573,61 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+public:
+	/**
+	 * @brief Manager containers only, weapons are reported by UAbstractWeapon.
+	 */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	/**
+	 * @brief Counts sent RPCs (FMeleeCounters::Rpcs), measures their size for melee.Net.Profile.
+	 */
+	virtual bool CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms,
+		FFrame* Stack) override;
+
+	/**
+	 * @brief Samples changed replicated properties for melee.Net.Profile.
+	 */
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+public:
+	/**
+	 * @brief Weapon manager of the actor from the registry filled on component registration.
+	 * Cheaper than FindComponentByClass for hot paths (anim notifies, visuals, damage).
+	 * @param InActor Owner of the manager.
+	 * @return Manager or nullptr.
+	 */
+	static UAdvancedWeaponManager* FindForActor(const AActor* InActor);
+
+	/**
+	 * @brief Manager of the actor, creates and registers a new one if the actor has none.
+	 * Used by benchmark and replay pawns spawned at runtime.
+	 */
+	static UAdvancedWeaponManager* FindOrAddForActor(AActor* InActor);
+
+	/**
+	 * @brief Calls InFunction for every registered manager (all worlds).
+	 */
+	static void ForEachRegistered(TFunctionRef<void(UAdvancedWeaponManager*)> InFunction);
+
+	/**
+	 * @brief Number of pending equip, fight, hitting, visual LOD and shield durability timers.
+	 * @param bInCombatOnly Skip the looping visual LOD and shield durability timers.
+	 */
+	int32 GetActiveTimerNum(bool bInCombatOnly = false) const;
 
 public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
 	                           FActorComponentTickFunction* ThisTickFunction) override;
+	/**
+	 * @brief Legacy subobject replication path.
+	 * Weapons are also registered in the replicated subobject list (see AddNewWeapon),
+	 * so owners with bReplicateUsingRegisteredSubObjectList (required by Iris) never call this.
+	 */
 	virtual bool ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
@@ -384,10 +709,17 @@ protected:
 protected:
 	/**
 	 * @brief Creates visual representations of the weapon.
+	 * Replicated actors are spawned on the server, or local ones if bClientSideVisuals is set.
 	 * @param InAbstractWeapon The weapon for which to create visuals.
 	 */
 	virtual void CreateVisuals(UAbstractWeapon* InAbstractWeapon);
 
+	/**
+	 * @brief Acquires non replicated visuals of the weapon on this machine from the visual pool.
+	 * @param InAbstractWeapon The weapon for which to create visuals.
+	 */
+	virtual void CreateLocalVisuals(UAbstractWeapon* InAbstractWeapon);
+
 	virtual void ProcessHits(UAbstractWeapon* InWeapon, const TArray<FHitResult>& InHits);
 
 
@@ -439,6 +771,7 @@ protected:
 #pragma region TryProxy
 
 public:
+	// Proxy methods run the input at once on the server, they are not rate limited there
 
 	/*UFUNCTION(BlueprintCallable, Category="AdvancedWeaponManager|Manage")
 	int32 GetEquippedWeaponIndex() const;*/
@@ -562,6 +895,44 @@ protected:
 	UFUNCTION(Server, Reliable)
 	void Server_CancelCharge();
 
+	/**
+	 * @brief Passes input received by server RPC to the combat recorder.
+	 */
+	void RecordInput_Internal(const FMeleeInputCommand& InCommand);
+
+	/**
+	 * @brief Entry of every server RPC implementation.
+	 * Input of a remote client goes through UMeleeRpcLimiterSubsystem, which drops it or queues it
+	 * to be coalesced and executed after the net tick. Local, AI, proxy methods on the server and
+	 * ExecuteInput calls run at once.
+	 * @return Whether the input runs now, recorded if so.
+	 */
+	bool AcceptInput_Internal(const FMeleeInputCommand& InCommand);
+
+	/** ExecuteInput is running, input is not limited */
+	bool bExecutingInput{false};
+
+	/**
+	 * @brief Sends input of a proxy method: server RPC on clients, ExecuteInput on the server.
+	 * Server calls for a remote player's pawn are server decisions and skip UMeleeRpcLimiterSubsystem.
+	 */
+	void SendInput_Internal(const FMeleeInputCommand& InCommand);
+
+	/**
+	 * @brief Whether the running RPC implementation was received from the network, see MELEE_SCOPE_RPC_INTERNAL.
+	 * Clients only run what the server sent. Server runs multicasts, host client RPCs and ExecuteInput locally,
+	 * its server RPCs are remote when the owner has a client connection.
+	 */
+	bool IsRemoteRpc_Internal(bool bInServerRpc) const;
+
+public:
+	/**
+	 * @brief Executes input as if its server RPC was received (authority only).
+	 * Used by combat replay and server side bots.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="AdvancedWeaponManager|Server")
+	virtual void ExecuteInput(const FMeleeInputCommand& InCommand);
+
 #pragma endregion
 
 #pragma region Client
@@ -595,6 +966,14 @@ protected:
 	UFUNCTION(NetMulticast, Reliable)
 	void Multi_RangeChargingFinished();
 
+	/**
+	 * @brief Replicates an arrow shot as launch record only, clients simulate the flight locally.
+	 * @param InWeaponHandle Handle of the firing long range weapon.
+	 * @param InRecord Quantized launch parameters.
+	 */
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multi_ArrowLaunched(FWeaponHandle InWeaponHandle, const FArrowLaunchRecord& InRecord);
+
 	UFUNCTION(NetMulticast, Reliable)
 	void Multi_RangeCanceled();
 
@@ -640,14 +1019,14 @@ protected:
 
 	/**
 	 * @brief Attaches the weapon to the character's back after de-equipping.
-	 * @param InWeaponGuid The GUID of the weapon being attached to the back.
+	 * @param InWeaponHandle The handle of the weapon being attached to the back.
 	 * @note Server is skipped
 	 */
 	UFUNCTION(NetMulticast, Reliable)
-	void Multi_AttachBack(const FString& InWeaponGuid);
+	void Multi_AttachBack(FWeaponHandle InWeaponHandle);
 
 	UFUNCTION(NetMulticast, Reliable)
-	void Multi_DropWeaponVisual(const FString& InWeaponGuid);
+	void Multi_DropWeaponVisual(FWeaponHandle InWeaponHandle);
 
 #pragma endregion
 
@@ -667,18 +1046,18 @@ public:
 	void AttachHand(AWeaponVisual* InVisual);
 
 	/**
-	 * @brief Attaches the weapon to the character's back based on the weapon's GUID and visual index.
-	 * @param WeaponGuid The GUID of the weapon.
+	 * @brief Attaches the weapon to the character's back based on the weapon's handle and visual index.
+	 * @param InWeaponHandle The handle of the weapon.
 	 * @param VisualIndex The index of the weapon visual.
 	 */
-	void AttachBack(const FString& WeaponGuid, int32 VisualIndex);
+	void AttachBack(FWeaponHandle InWeaponHandle, int32 VisualIndex);
 
 	/**
-	 * @brief Attaches the weapon to the character's hand based on the weapon's GUID and visual index.
-	 * @param WeaponGuid The GUID of the weapon.
+	 * @brief Attaches the weapon to the character's hand based on the weapon's handle and visual index.
+	 * @param InWeaponHandle The handle of the weapon.
 	 * @param VisualIndex The index of the weapon visual.
 	 */
-	void AttachHand(const FString& WeaponGuid, int32 VisualIndex);
+	void AttachHand(FWeaponHandle InWeaponHandle, int32 VisualIndex);
 #pragma endregion
 
 #pragma region Exposed
@@ -726,6 +1105,24 @@ public:
 	UFUNCTION()
 	void NotifyShieldDurabilityLost();
 
+	/**
+	 * @brief Called by weapon when its data is replicated (clients).
+	 * Creates local visuals, if data was not resolved on OnRep_WeaponList.
+	 */
+	void NotifyWeaponDataReplicated(UAbstractWeapon* InWeapon);
+
+	/**
+	 * @brief Called by weapon when its handle is replicated (clients).
+	 * Handle may arrive after OnRep_WeaponList, marks WeaponHandleMap dirty.
+	 */
+	void NotifyWeaponHandleReplicated(UAbstractWeapon* InWeapon);
+
+	/**
+	 * @brief Sends arrow launch record to clients (server).
+	 * @see Multi_ArrowLaunched
+	 */
+	void NotifyArrowLaunched(FWeaponHandle InWeaponHandle, const FArrowLaunchRecord& InRecord);
+
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="AdvancedWeaponManager|Misc")
 	virtual void NotifyShieldRuined();
 	
@@ -742,7 +1139,7 @@ public:
 	virtual void StopWork();
 
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="AdvancedWeaponManager|Weapon")
-	virtual void DropWeaponVisual(const FString& InWeaponGuid);
+	virtual void DropWeaponVisual(FWeaponHandle InWeaponHandle);
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="AdvancedWeaponManager|Weapon")
 	virtual bool IsShieldEquipped() const;
@@ -756,6 +1153,7 @@ public:
 
 	/**
 	 * @brief Removes a weapon from the weapon list.
+	 * Equipped weapon can not be removed, de-equip it first.
 	 * @param InIndex The index of the weapon to remove.
 	 * @return Whether the weapon was successfully removed.
 	 */
@@ -847,6 +1245,9 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="AdvancedWeaponManager|Charge")
 	FORCEINLINE float GetChargingFinishTime() const { return ChargeWillBeFinished; }
 
+	/** Curve value without a charging curve */
+	FORCEINLINE float GetMinimalCurveValue() const { return MinimalCurveValue; }
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="AdvancedWeaponManager|Weapon")
 	bool IsBlocking() const;
 
@@ -880,10 +1281,19 @@ public:
 	 * @brief Retrieves a weapon by its GUID.
 	 * @param InGuid The GUID of the weapon to retrieve.
 	 * @return The weapon with the specified GUID.
+	 * @note GUID is server only (persistence), use WeaponByHandle for runtime lookups.
 	 */
 	UFUNCTION(BlueprintCallable, Category="AdvancedWeaponManager|Weapon")
 	virtual UAbstractWeapon* WeaponByGuid(FString InGuid);
 
+	/**
+	 * @brief Retrieves a weapon by its handle.
+	 * @param InHandle The handle of the weapon to retrieve.
+	 * @return The weapon with the specified handle.
+	 */
+	UFUNCTION(BlueprintCallable, Category="AdvancedWeaponManager|Weapon")
+	virtual UAbstractWeapon* WeaponByHandle(FWeaponHandle InHandle) const;
+
 	/**
 	 * @brief Gets the number of weapons in the weapon list.
 	 * @return The number of weapons.
@@ -1073,6 +1483,11 @@ public:
 
 	UPROPERTY(BlueprintAssignable, Category="AdvancedWeaponManager|Events")
 	FAdvancedWeaponFloatDelegate OnAttackComboExpireTimeChanged;
+
+	/**
+	 * @brief Broadcast on server for every damage request of any manager hits.
+	 */
+	static FOnMeleeDamageDealt OnDamageDealt;
 	
 #pragma endregion
 };
@@ -0,0 +1,29 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "WeaponTrailNotifyState.generated.h"
+
+/**
+ * @brief Shows weapon trail for the duration of the state.
+ * Replaces a Show Trail / Hide Trail notify pair. Begin and end find the manager in the owner registry
+ * (UAdvancedWeaponManager::FindForActor), one map lookup each.
+ */
+UCLASS(Blueprintable, BlueprintType)
+class MELEEMASTER_API UWeaponTrailNotifyState : public UAnimNotifyState
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(ExposeOnSpawn, ClampMin=0), Category="SwordTrail")
+	int32 VisualIndex{0};
+
+public:
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration,
+	                         const FAnimNotifyEventReference& EventReference) override;
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+	                       const FAnimNotifyEventReference& EventReference) override;
+	virtual FString GetNotifyName_Implementation() const override;
+};
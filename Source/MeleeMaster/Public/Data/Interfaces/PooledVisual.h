@@ -0,0 +1,36 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PooledVisual.generated.h"
+
+// This class does not need to be modified.
+UINTERFACE()
+class MELEEMASTER_API UPooledVisual : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * @brief Reset hooks of actors managed by UVisualPoolSubsystem.
+ */
+class MELEEMASTER_API IPooledVisual
+{
+	GENERATED_BODY()
+
+	// Add interface functions to this class. This is the class that will be inherited to implement this interface.
+public:
+	/**
+	 * @brief Called when the actor is taken from the pool, after owner and transform are set.
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category="PooledVisual")
+	void OnAcquiredFromPool();
+
+	/**
+	 * @brief Called when the actor is returned to the pool. Must hide it and reset per-owner state.
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category="PooledVisual")
+	void OnReleasedToPool();
+};
@@ -32,6 +32,13 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Melee")
 	FMeleeCombinedData Base;
 
+	/**
+	 * @brief A victim takes damage once per swing, from the first hit path element that reaches it.
+	 * Off: every hit path element that reaches the victim deals damage (see bDamageForFullPath).
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Melee")
+	uint8 bDamageOncePerSwing : 1;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Shield")
 	uint8 bHasShield : 1;
 
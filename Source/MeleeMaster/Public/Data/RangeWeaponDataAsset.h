@@ -66,6 +66,87 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Visual")
 	FBowArrowData Arrow;
 
+	/**
+	 * @brief Visual of the flying and stuck arrow, Arrow.VisualActorClass if not set.
+	 * @note Taken from UVisualPoolSubsystem, not spawned on dedicated server.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Visual")
+	TSubclassOf<AActor> ProjectileVisualClass;
+
+	/**
+	 * @brief Arrow launch speed at the minimal hit power (cm/s).
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="1.0"))
+	float MinArrowSpeed{1500.0f};
+
+	/**
+	 * @brief Arrow launch speed at the full hit power (cm/s).
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="1.0"))
+	float MaxArrowSpeed{6000.0f};
+
+	/**
+	 * @brief Gravity acceleration along Z (cm/s^2), negative is down.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics")
+	float ArrowGravity{-980.0f};
+
+	/**
+	 * @brief Quadratic drag coefficient (1/cm), deceleration = Drag * speed^2.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="0.0"))
+	float ArrowDrag{0.00001f};
+
+	/**
+	 * @brief Half angle of the random arrow spread (degrees), seeded by the launch record.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="0.0", ClampMax="45.0"))
+	float ArrowSpread{0.0f};
+
+	/**
+	 * @brief Radius of the arrow sweep (cm), 0 for line trace.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="0.0"))
+	float ArrowRadius{2.0f};
+
+	/**
+	 * @brief Flight time before the arrow is dropped (sec).
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="0.1"))
+	float ArrowLifeTime{6.0f};
+
+	/**
+	 * @brief How long a stuck arrow stays visible (sec).
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics", meta=(ClampMin="0.0"))
+	float StuckArrowLifeTime{10.0f};
+
+	/**
+	 * @brief Trace channel of the arrow sweep.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics")
+	TEnumAsByte<ETraceTypeQuery> ArrowTraceQuery{TraceTypeQuery1};
+
+	/**
+	 * @brief Type of damage dealt by the arrow.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics")
+	TSubclassOf<UDamageType> ArrowDamageType;
+
+	/**
+	 * @brief Rewind targets by shooter latency when testing arrow hits (server).
+	 * @see melee.Projectile.LagCompensation
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics")
+	bool bArrowLagCompensation{true};
+
+	/**
+	 * @brief Maximum rewind time of lag compensation (sec).
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Range|Ballistics",
+		meta=(EditCondition="bArrowLagCompensation", ClampMin="0.0"))
+	float MaxArrowRewindTime{0.25f};
+
 public:
 	
 };
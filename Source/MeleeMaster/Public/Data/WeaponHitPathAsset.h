@@ -26,6 +26,8 @@ public:
 	 */
 	UWeaponHitPathAsset();
 
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 public:
 	/**
 	 * @brief Weapon hit data describing the shape and path of the weapon trace.
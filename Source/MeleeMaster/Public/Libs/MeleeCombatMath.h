@@ -0,0 +1,61 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponTypes.h"
+
+/**
+ * @brief Pure combat math of UAdvancedWeaponManager, free of UObject state.
+ * Kept separate to be measured by melee.Bench.Kernels.
+ */
+struct MELEEMASTER_API FMeleeCombatMath
+{
+	/**
+	 * @brief Whether block direction counters attack direction (no shield).
+	 * Forward and Backward must match, Right is blocked by Left and vice versa.
+	 */
+	static bool IsBlockDirectionMatched(EWeaponDirection InAttack, EWeaponDirection InBlock);
+
+	/**
+	 * @brief Block result of a matched block against a melee attack.
+	 * @param bInShield Blocking with shield.
+	 * @param InBlockTier Tier of the blocking weapon, parry is possible against the same tier or lower.
+	 * @param InAttackTier Tier of the attacking weapon.
+	 * @param InAttackValue Hit power of the attacker.
+	 * @param InBlockValue Current charging curve value of the blocker.
+	 */
+	static EBlockResult ResolveBlock(bool bInShield, EWeaponTier InBlockTier, EWeaponTier InAttackTier,
+		float InAttackValue, float InBlockValue);
+
+	/**
+	 * @brief Whether the damage source is inside the block angle (horizontal plane).
+	 * @param InForward Forward vector of the blocker.
+	 * @param InToSource Vector from the blocker to the damage source.
+	 * @param InBlockAngle Full block angle (degrees).
+	 */
+	static bool IsInBlockAngle(FVector InForward, FVector InToSource, float InBlockAngle);
+
+	/**
+	 * @brief Time on the charging curve.
+	 * @param InStartTime Charging start (server time).
+	 * @param InFinishTime Charging finish (server time).
+	 * @param InServerTime Current server time, must not be greater than InFinishTime.
+	 */
+	static float GetChargingCurveTime(float InStartTime, float InFinishTime, float InServerTime);
+
+	/**
+	 * @brief Damage with attack combo bonus.
+	 */
+	static float EvaluateComboDamage(float InDamage, float InComboSum);
+
+	/**
+	 * @brief World space segment and rotation of a hit path element.
+	 * @param InControlRotation Control rotation of the attacker.
+	 * @param InOwnerLocation Attacker location.
+	 * @param InZOffset Hit path Z offset.
+	 * @param InElement Hit path element (local space).
+	 */
+	static void TransformHitSegment(FRotator InControlRotation, FVector InOwnerLocation, float InZOffset,
+		const FWeaponHitDataElement& InElement, FVector& OutStart, FVector& OutEnd, FRotator& OutRotation);
+};
@@ -0,0 +1,124 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Combat phases timed by MELEE_SCOPE_CYCLE / MELEE_SCOPE_RPC / MELEE_SCOPE_SERVER_RPC.
+ */
+enum class EMeleePhase : uint8
+{
+	HitProcedure,
+	ProcessHits,
+	ProcessWeaponDamage,
+	CanBlockIncomingDamage,
+	EvaluateCurrentCurve,
+	ReplicateSubobjects,
+	CreateVisuals,
+	Rpc,
+	Num
+};
+
+/**
+ * @brief Log-linear duration histogram (nanoseconds), 4 buckets per power of two.
+ */
+struct MELEEMASTER_API FMeleeHistogram
+{
+	static constexpr int32 SubBucketBits = 2;
+	static constexpr int32 SubBucketNum = 1 << SubBucketBits;
+	/** Up to 2^40 ns */
+	static constexpr int32 BucketNum = SubBucketNum + (40 - SubBucketBits) * SubBucketNum;
+
+	uint64 Counts[BucketNum]{};
+
+	static int32 GetBucket(uint64 InNanoseconds);
+
+	/** Lower bound of the bucket (ns) */
+	static uint64 GetBucketMin(int32 InBucket);
+
+	uint64 Num() const;
+
+	/**
+	 * @brief Adds a sample, not thread safe (process wide histograms are written by FMeleeCounters).
+	 */
+	FORCEINLINE void Add(uint64 InNanoseconds) { ++Counts[GetBucket(InNanoseconds)]; }
+
+	/**
+	 * @brief Approximate percentile (middle of the bucket).
+	 * @param InPercent 0..1
+	 * @return Nanoseconds, 0 if empty.
+	 */
+	double GetPercentile(float InPercent) const;
+
+	/**
+	 * @brief Samples added since InEarlier snapshot.
+	 */
+	FMeleeHistogram operator-(const FMeleeHistogram& InEarlier) const;
+};
+
+/**
+ * @brief Snapshot of process wide combat counters, sampled by benchmarks, reports and melee.Stats.
+ * Writers increment per thread blocks without locks, Get() aggregates them.
+ * Values only grow, consumers diff two snapshots.
+ */
+struct MELEEMASTER_API FMeleeCounters
+{
+	/** Melee hit path traces and projectile sweeps */
+	int64 Traces{0};
+	/** Hit procedures finished without trace (no hit path element) */
+	int64 TracesSkipped{0};
+	/** Damageable actors found by melee traces */
+	int64 TraceTargets{0};
+	/** Weapon damage requests processed by victims */
+	int64 Hits{0};
+	int64 Blocks{0};
+	int64 Parries{0};
+	/** Remote function calls sent by weapon managers */
+	int64 Rpcs{0};
+	/** Time spent in every EMeleePhase (cycles) */
+	uint64 PhaseCycles[static_cast<int32>(EMeleePhase::Num)]{};
+	/** Duration of every EMeleePhase scope */
+	FMeleeHistogram PhaseHistograms[static_cast<int32>(EMeleePhase::Num)];
+
+	/**
+	 * @brief Sums counters of every thread.
+	 */
+	static FMeleeCounters Get();
+
+	// Increment counter and matching stat MeleeMaster / CSV value
+	static void AddTrace();
+	static void AddTraceSkipped();
+	static void AddTraceTargets(int32 InNum);
+	static void AddHit();
+	static void AddBlock();
+	static void AddParry();
+	static void AddRpc();
+
+	/**
+	 * @brief Adds phase scope duration.
+	 */
+	static void AddPhase(EMeleePhase InPhase, uint64 InCycles);
+
+	static const TCHAR* GetPhaseName(EMeleePhase InPhase);
+};
+
+/**
+ * @brief Adds scope time to FMeleeCounters phase cycles and histogram.
+ */
+struct FMeleePhaseScope
+{
+	explicit FMeleePhaseScope(EMeleePhase InPhase)
+		: Phase(InPhase), StartCycles(FPlatformTime::Cycles64())
+	{
+	}
+
+	~FMeleePhaseScope()
+	{
+		FMeleeCounters::AddPhase(Phase, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+	EMeleePhase Phase;
+	uint64 StartCycles;
+};
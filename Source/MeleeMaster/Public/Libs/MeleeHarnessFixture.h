@@ -0,0 +1,76 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+class FJsonObject;
+class UAdvancedWeaponManager;
+class UWeaponDataAsset;
+class UWorld;
+
+/**
+ * @brief Fighters and output shared by the benchmark, scenario and stress harnesses.
+ * Built from the config of the harness, see GetFixture of the harness subsystems.
+ */
+struct MELEEMASTER_API FMeleeHarnessFixture
+{
+	FMeleeHarnessFixture(const TSoftClassPtr<APawn>& InPawnClass, const TSoftObjectPtr<UWeaponDataAsset>& InWeapon,
+		const FVector& InOrigin, float InPairDistance, float InPairSpacing = 400.0f)
+		: PawnClass(InPawnClass), Weapon(InWeapon), Origin(InOrigin), PairDistance(InPairDistance),
+		  PairSpacing(InPairSpacing)
+	{
+	}
+
+	/** Fighter class, ACharacter if not set. Manager is added if the class has none */
+	TSoftClassPtr<APawn> PawnClass;
+
+	/** Weapon given to every fighter, manager DefaultWeapons are used if not set */
+	TSoftObjectPtr<UWeaponDataAsset> Weapon;
+
+	FVector Origin;
+
+	/** Distance between opponents of a pair */
+	float PairDistance;
+
+	/** Distance between pairs */
+	float PairSpacing;
+
+	/**
+	 * @brief Loads Weapon.
+	 * @return Nullptr if not set.
+	 */
+	UWeaponDataAsset* LoadWeapon() const;
+
+	/**
+	 * @brief Spawns InSize fighters (rounded down to pairs) in facing pairs on a square grid.
+	 * Every fighter gets a controller and a manager, weapons and equipping are up to the harness.
+	 * @param OutManagers Managers in spawn order, the first fighter of a pair faces the second.
+	 * @return False if a pawn failed to spawn, fighters spawned so far are in OutManagers.
+	 */
+	bool SpawnFighters(UWorld* InWorld, int32 InSize, TArray<UAdvancedWeaponManager*>& OutManagers) const;
+
+	/**
+	 * @brief Writes InJson to Saved/Profiling/InDirectory/InName_<date>.json.
+	 * @return Written file path.
+	 */
+	static FString WriteResults(const TSharedRef<FJsonObject>& InJson, const TCHAR* InDirectory,
+		const FString& InName);
+
+	/** Harnesses run on the server or standalone game */
+	static bool DoesSupportWorldType(const EWorldType::Type InWorldType);
+
+	template <typename TSubsystem>
+	static TSubsystem* GetSubsystem(const UObject* WorldContextObject)
+	{
+		if (!WorldContextObject)
+			return nullptr;
+
+		if (UWorld* world = WorldContextObject->GetWorld())
+		{
+			return world->GetSubsystem<TSubsystem>();
+		}
+		return nullptr;
+	}
+};
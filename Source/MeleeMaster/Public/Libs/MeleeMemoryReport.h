@@ -0,0 +1,15 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Memory owned by the plugin in a world: per pawn (manager, weapons, visuals), per weapon type,
+ * shared assets (hit paths, cached montages) and weapons/visuals not referenced by any manager.
+ * Sizes come from GetResourceSizeEx, console: melee.Mem.Report.
+ */
+struct MELEEMASTER_API FMeleeMemoryReport
+{
+	static void Dump(UWorld* InWorld, FOutputDevice& Ar);
+};
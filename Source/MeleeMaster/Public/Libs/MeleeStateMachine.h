@@ -0,0 +1,83 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponTypes.h"
+
+class UAdvancedWeaponManager;
+
+/**
+ * @brief Status change of a weapon manager.
+ * From and To are EWeaponManagingStatus if bManaging, EWeaponFightingStatus otherwise.
+ */
+struct FMeleeStateTransition
+{
+	/** World time (sec) */
+	double Time{0.0};
+	bool bManaging{false};
+	uint8 From{0};
+	uint8 To{0};
+	bool bValid{true};
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnMeleeStateTransition, UAdvancedWeaponManager*, const FMeleeStateTransition&);
+
+/**
+ * @brief Allowed transitions of EWeaponFightingStatus and EWeaponManagingStatus.
+ * Status changes of UAdvancedWeaponManager are checked and broadcast to OnTransition while it has listeners,
+ * invalid ones are logged while melee.Validate.StateMachine is on (off by default).
+ * Nothing is checked or broadcast in shipping builds.
+ */
+struct MELEEMASTER_API FMeleeStateMachine
+{
+	/**
+	 * @brief Whether the fighting flow can go from InFrom to InTo.
+	 * Setting the same status, falling back to Idle and StopWork (Busy) are always allowed.
+	 */
+	static bool IsValidTransition(EWeaponFightingStatus InFrom, EWeaponFightingStatus InTo);
+
+	/**
+	 * @brief Whether the managing flow can go from InFrom to InTo.
+	 * Setting the same status and StopWork (Busy) are always allowed.
+	 */
+	static bool IsValidTransition(EWeaponManagingStatus InFrom, EWeaponManagingStatus InTo);
+
+	/**
+	 * @brief Called by UAdvancedWeaponManager on every status change.
+	 * Broadcasts OnTransition if bound, logs and counts invalid transitions while melee.Validate.StateMachine is on.
+	 * Compiled out in shipping builds.
+	 */
+#if !UE_BUILD_SHIPPING
+	static void NotifyTransition(UAdvancedWeaponManager* InManager, EWeaponFightingStatus InFrom,
+		EWeaponFightingStatus InTo);
+	static void NotifyTransition(UAdvancedWeaponManager* InManager, EWeaponManagingStatus InFrom,
+		EWeaponManagingStatus InTo);
+#else
+	static FORCEINLINE void NotifyTransition(UAdvancedWeaponManager* InManager, EWeaponFightingStatus InFrom,
+		EWeaponFightingStatus InTo)
+	{
+	}
+
+	static FORCEINLINE void NotifyTransition(UAdvancedWeaponManager* InManager, EWeaponManagingStatus InFrom,
+		EWeaponManagingStatus InTo)
+	{
+	}
+#endif
+
+	/** Invalid transitions logged since start */
+	static int32 GetViolationNum();
+
+	static FString GetStatusName(const FMeleeStateTransition& InTransition, bool bInTo);
+
+	/** Game thread only, not broadcast in shipping builds */
+	static FOnMeleeStateTransition OnTransition;
+
+#if !UE_BUILD_SHIPPING
+private:
+	/** Whether status changes are checked at all, validation is on or OnTransition has listeners */
+	static bool IsNotifyEnabled_Internal();
+
+	static void Notify_Internal(UAdvancedWeaponManager* InManager, FMeleeStateTransition& InTransition);
+#endif
+};
@@ -4,9 +4,76 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Trace/Trace.h"
+#include "Libs/MeleeCounters.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogWeapon, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("MeleeMaster"), STATGROUP_MeleeMaster, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ReplicateSubobjects (legacy)"), STAT_MeleeReplicateSubobjects, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Weapon subobjects replicated"), STAT_MeleeSubobjectsReplicated, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile tick"), STAT_MeleeProjectileTick, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Projectiles in flight"), STAT_MeleeProjectilesInFlight, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Projectiles launched"), STAT_MeleeProjectilesLaunched, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cache weapon montages"), STAT_MeleeCacheMontages, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Trail tick"), STAT_MeleeTrailTick, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Trails active"), STAT_MeleeTrailsActive, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MeleeHitProcedure"), STAT_MeleeHitProcedure, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ProcessHits"), STAT_MeleeProcessHits, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ProcessWeaponDamage"), STAT_MeleeProcessWeaponDamage, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CanBlockIncomingDamage"), STAT_MeleeCanBlockIncomingDamage, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("EvaluateCurrentCurve"), STAT_MeleeEvaluateCurrentCurve, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CreateVisuals"), STAT_MeleeCreateVisuals, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RPC implementations"), STAT_MeleeRpc, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Traces"), STAT_MeleeTraces, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Traces skipped"), STAT_MeleeTracesSkipped, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hits"), STAT_MeleeHits, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Blocks"), STAT_MeleeBlocks, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Parries"), STAT_MeleeParries, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("RPCs sent"), STAT_MeleeRpcsSent, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("RPCs received"), STAT_MeleeRpcsReceived, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("RPCs dropped"), STAT_MeleeRpcsDropped, STATGROUP_MeleeMaster, MELEEMASTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("RPCs coalesced"), STAT_MeleeRpcsCoalesced, STATGROUP_MeleeMaster, MELEEMASTER_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(MELEEMASTER_API, MeleeMaster);
+
+/** LLM tag of weapons, visuals and caches, see -LLM and melee.Mem.Report */
+LLM_DECLARE_TAG_API(MeleeMaster, MELEEMASTER_API);
+
+/** Insights channel of combat scopes, enable with -trace=cpu,MeleeMaster */
+UE_TRACE_CHANNEL_EXTERN(MeleeMasterChannel, MELEEMASTER_API);
+
+/**
+ * Times a combat phase in stat MeleeMaster (STAT_Melee<Name>), CSV profiler, Insights and FMeleeCounters.
+ */
+#define MELEE_SCOPE_CYCLE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Melee##Name); \
+	FMeleePhaseScope PREPROCESSOR_JOIN(meleePhaseScope, __LINE__)(EMeleePhase::Name); \
+	CSV_SCOPED_TIMING_STAT(MeleeMaster, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Melee##Name, MeleeMasterChannel)
+
+/**
+ * Times an RPC implementation of UAdvancedWeaponManager: shared STAT_MeleeRpc and CSV stat, per function Insights event.
+ * STAT_MeleeRpcsReceived counts only calls that came from the network.
+ */
+#define MELEE_SCOPE_RPC_INTERNAL(Name, bServerRpc) \
+	SCOPE_CYCLE_COUNTER(STAT_MeleeRpc); \
+	FMeleePhaseScope PREPROCESSOR_JOIN(meleePhaseScope, __LINE__)(EMeleePhase::Rpc); \
+	CSV_SCOPED_TIMING_STAT(MeleeMaster, Rpc); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, MeleeMasterChannel); \
+	INC_DWORD_STAT_BY(STAT_MeleeRpcsReceived, IsRemoteRpc_Internal(bServerRpc) ? 1 : 0)
+
+/** Times a Client or NetMulticast RPC implementation, see MELEE_SCOPE_RPC_INTERNAL */
+#define MELEE_SCOPE_RPC(Name) MELEE_SCOPE_RPC_INTERNAL(Name, false)
+
+/** Times a Server RPC implementation, see MELEE_SCOPE_RPC_INTERNAL */
+#define MELEE_SCOPE_SERVER_RPC(Name) MELEE_SCOPE_RPC_INTERNAL(Name, true)
+
 class FMeleeMasterModule : public IModuleInterface
 {
 public:
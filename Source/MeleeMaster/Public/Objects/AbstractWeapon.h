@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Data/AdvancedReplicatedObject.h"
+#include "WeaponTypes.h"
 #include "AbstractWeapon.generated.h"
 
 class AWeaponVisual;
@@ -50,10 +51,30 @@ protected:
 	TArray<AWeaponVisual*> Visuals;
 
 	/**
-	 * @brief Unique id for multiplayer replication
+	 * @brief Visuals spawned on this machine only, used instead of Visuals when bLocalVisuals is set.
+	 * Kept apart from Visuals, so replication never sends them or overwrites them.
 	 */
-	UPROPERTY(Transient, ReplicatedUsing=OnRep_Guid, BlueprintReadOnly, Category="AbstractWeapon|Variables")
+	UPROPERTY(Transient)
+	TArray<AWeaponVisual*> LocalVisuals;
+
+	/**
+	 * @brief Visuals are spawned locally and must not be replicated.
+	 * @see UAdvancedWeaponManager::bClientSideVisuals
+	 */
+	bool bLocalVisuals{false};
+
+	/**
+	 * @brief Unique id for persistence (server only, not replicated)
+	 * @see Handle
+	 */
+	UPROPERTY(Transient, BlueprintReadOnly, Category="AbstractWeapon|Variables")
 	FString Guid;
+
+	/**
+	 * @brief Compact id inside the owning weapon manager, used for multiplayer replication
+	 */
+	UPROPERTY(Transient, ReplicatedUsing=OnRep_Handle)
+	FWeaponHandle Handle;
 	
 	UPROPERTY(Transient)
 	TWeakObjectPtr<class UAdvancedWeaponManager> WeaponManagerOwner;
@@ -76,10 +97,24 @@ protected:
 	virtual void OnRep_Visuals();
 
 	/**
-	 * @brief Called when Guid variable is replicated.
+	 * @brief Called when weapon handle is replicated.
 	 */
 	UFUNCTION()
-	virtual void OnRep_Guid();
+	virtual void OnRep_Handle();
+
+	/**
+	 * @brief Marks Visuals dirty, unless they are local.
+	 */
+	void MarkVisualsDirty();
+
+	/**
+	 * @brief LocalVisuals if visuals are local, Visuals otherwise.
+	 */
+	FORCEINLINE TArray<AWeaponVisual*>& GetVisualArray_Internal() { return bLocalVisuals ? LocalVisuals : Visuals; }
+	FORCEINLINE const TArray<AWeaponVisual*>& GetVisualArray_Internal() const
+	{
+		return bLocalVisuals ? LocalVisuals : Visuals;
+	}
 
 public:
 	virtual bool IsSupportedForNetworking() const override { return true; }
@@ -87,6 +122,11 @@ public:
 	virtual bool ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
 #pragma endregion Replication
 
+	/**
+	 * @brief Weapon instance memory, visual actors and data assets are reported separately.
+	 */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 #pragma region Data
 public:
 
@@ -125,6 +165,17 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="AbstractWeapon|Visual")
 	virtual void SetVisual(const TArray<AWeaponVisual*>& InVisuals);
 
+	/**
+	 * @brief Sets visuals spawned on this machine only. They are never replicated.
+	 * @param InVisuals Array of local weapon visual actors.
+	 */
+	virtual void SetLocalVisual(const TArray<AWeaponVisual*>& InVisuals);
+
+	/**
+	 * @return True if visuals are spawned locally.
+	 */
+	FORCEINLINE bool HasLocalVisuals() const { return bLocalVisuals; }
+
 	/**
 	 * @brief Clears visual array
 	 * @note Only references will be cleared. Actors will be still alive
@@ -180,10 +231,10 @@ public:
 
 	/**
 	 * @brief Retrieves the number of visuals for this weapon.
-	 * @return The number of visual components (Visuals.Num()).
+	 * @return The number of visual components.
 	 */
 	UFUNCTION(BlueprintCallable, Category="AbstractWeapon|Visual")
-	virtual int32 VisualNum() const { return Visuals.Num(); }
+	virtual int32 VisualNum() const { return GetVisualArray_Internal().Num(); }
 #pragma endregion Visual
 
 #pragma region GUID
@@ -194,7 +245,7 @@ public:
 	/**
 	 * @brief Gets the GUID string associated with this weapon.
 	 * @return The GUID string.
-	 * This function is BlueprintCallable and marked as FORCEINLINE for performance.
+	 * @note GUID is not replicated, use GetHandle to identify weapon on clients.
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="AbstractWeapon")
 	FORCEINLINE FString GetGUIDString() const { return Guid; }
@@ -214,6 +265,19 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category="AbstractWeapon")
 	virtual FString MakeRandomGuidString();
+
+	/**
+	 * @brief Gets the handle of this weapon inside the owning weapon manager.
+	 * @return The weapon handle, invalid until the weapon is added to a manager.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="AbstractWeapon")
+	FORCEINLINE FWeaponHandle GetHandle() const { return Handle; }
+
+	/**
+	 * @brief Sets the handle of this weapon.
+	 * @param InHandle Handle allocated by the owning weapon manager.
+	 */
+	virtual void SetHandle(FWeaponHandle InHandle);
 #pragma endregion GUID
 
 #pragma region IK
@@ -8,6 +8,7 @@
 
 class AArrowVisual;
 class URangeWeaponDataAsset;
+struct FProjectileImpact;
 /**
  * @brief Base class for long-range weapons in the MeleeMaster plugin.
  * 
@@ -91,6 +92,7 @@ public:
 public:
 	/**
 	 * @brief Retrieves the location and rotation for the arrow.
+	 * Native implementation uses owner eyes view point.
 	 * @param OutLoc The output location for the arrow.
 	 * @param OutRot The output rotation for the arrow.
 	 * This function is a BlueprintNativeEvent, allowing it to be overridden in Blueprints, and BlueprintAuthorityOnly, meaning it can only be called on the server.
@@ -100,10 +102,39 @@ public:
 
 	/**
 	 * @brief Fires an arrow with the specified power.
+	 * Native implementation launches a server arrow in UProjectileSubsystem (no projectile actor)
+	 * and multicasts its launch record, so clients simulate the same trajectory locally.
 	 * @param Power The power level of the arrow shot.
 	 * This function is a BlueprintNativeEvent, allowing it to be overridden in Blueprints, and BlueprintAuthorityOnly, meaning it can only be called on the server.
 	 */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, BlueprintNativeEvent)
 	void FireArrow(float Power);
+
+	/**
+	 * @brief Builds quantized launch record of the shot from GetArrowLocRot (server).
+	 * @param Power The power level of the arrow shot.
+	 */
+	virtual FArrowLaunchRecord MakeArrowLaunchRecord(float Power);
+
+	/**
+	 * @brief Simulates arrow flight from the launch record.
+	 * @param InRecord Replicated launch record.
+	 * @param bAuthority Server arrow applies damage and uses lag compensation, otherwise it is cosmetic.
+	 */
+	virtual void LaunchArrowFromRecord(const FArrowLaunchRecord& InRecord, bool bAuthority);
+
+protected:
+	/**
+	 * @brief Latency of the shooter to rewind targets by (server).
+	 * @return Rewind time in seconds, 0 if lag compensation is disabled.
+	 */
+	virtual float GetArrowRewindTime() const;
+
+	/**
+	 * @brief Applies arrow damage on the server.
+	 * Fighters receive UAdvancedWeaponManager::ProcessProjectileDamage, other damageable entities go through IDamageManager.
+	 * @param InImpact Impact reported by UProjectileSubsystem.
+	 */
+	virtual void OnArrowImpact(const FProjectileImpact& InImpact);
 #pragma endregion Arrow Mechanics
 };
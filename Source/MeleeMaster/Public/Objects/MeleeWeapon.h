@@ -150,6 +150,8 @@ public:
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	FORCEINLINE bool HasShieldDropped() const { return bShieldHasDropped; }
+
+	FORCEINLINE const FTimerHandle& GetShieldDurabilityTimerHandle() const { return ShieldDurabilityTimerHandle; }
 #pragma endregion Shield Management
 
 #pragma region Data
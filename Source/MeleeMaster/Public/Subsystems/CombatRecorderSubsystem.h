@@ -0,0 +1,202 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponTypes.h"
+#include "Libs/MeleeCounters.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRecorderSubsystem.generated.h"
+
+class UAdvancedWeaponManager;
+
+/**
+ * @brief Actor taking part in a recorded fight.
+ */
+struct FCombatRecordActor
+{
+	FString ClassPath;
+	FTransform Transform;
+	/** Weapon data assets of the weapon list */
+	TArray<FString> Weapons;
+	int32 CurrentWeaponIndex{INDEX_NONE};
+
+	friend FArchive& operator<<(FArchive& Ar, FCombatRecordActor& InActor);
+};
+
+/**
+ * @brief Input received by the server.
+ */
+struct FCombatRecordInput
+{
+	/** World time since record start */
+	float Time{0.0f};
+	uint16 Actor{0};
+	FMeleeInputCommand Command;
+	FVector3f Location{FVector3f::ZeroVector};
+	float Yaw{0.0f};
+
+	friend FArchive& operator<<(FArchive& Ar, FCombatRecordInput& InInput);
+};
+
+/**
+ * @brief Result of a damage request made by a weapon hit.
+ */
+struct FCombatRecordOutcome
+{
+	float Time{0.0f};
+	uint16 Causer{0};
+	uint16 Victim{0};
+	EDamageReturn Result{EDamageReturn::Failed};
+	float Damage{0.0f};
+
+	friend FArchive& operator<<(FArchive& Ar, FCombatRecordOutcome& InOutcome);
+};
+
+/**
+ * @brief Binary combat log (*.mmrec).
+ */
+struct FCombatRecord
+{
+	static constexpr uint32 Magic = 0x4345524D; // MREC
+	static constexpr uint32 Version = 1;
+
+	float Duration{0.0f};
+	int32 Frames{0};
+	/** Average frame time (ms) */
+	float FrameMs{0.0f};
+	/** Total time per EMeleePhase (ms) */
+	TArray<float> PhaseMs;
+
+	TArray<FCombatRecordActor> Actors;
+	TArray<FCombatRecordInput> Inputs;
+	TArray<FCombatRecordOutcome> Outcomes;
+
+	friend FArchive& operator<<(FArchive& Ar, FCombatRecord& InRecord);
+};
+
+UENUM()
+enum class ECombatRecorderMode : uint8
+{
+	None,
+	Recording,
+	Replaying
+};
+
+/**
+ * @brief Records server input of every weapon manager with pawn transforms and hit outcomes to a binary log,
+ * replays the log headless against the current build and reports outcome and per-phase timing differences.
+ * melee.Record.Start, melee.Record.Stop [Name], melee.Record.Replay Name.
+ * Logs: Saved/Profiling/MeleeRecords/*.mmrec, reports: Saved/Profiling/MeleeReplay/*.json.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UCombatRecorderSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/** Equip time of replay actors before the first input (sec) */
+	UPROPERTY(Config)
+	float ReplayWarmupTime{3.0f};
+
+	/** Damage difference treated as a mismatch */
+	UPROPERTY(Config)
+	float DamageTolerance{0.01f};
+
+	/** Mismatches written to the report */
+	UPROPERTY(Config)
+	int32 MaxReportedMismatches{32};
+#pragma endregion
+
+#pragma region Properties
+protected:
+	ECombatRecorderMode Mode{ECombatRecorderMode::None};
+
+	/** Record being written or replayed */
+	FCombatRecord Record;
+
+	/** Outcomes of the replay run */
+	TArray<FCombatRecordOutcome> ReplayOutcomes;
+
+	FString ReplayName;
+
+	TMap<TObjectKey<AActor>, uint16> ActorIds;
+
+	/** Spawned replay actors, index is the record actor id */
+	TArray<TWeakObjectPtr<AActor>> ReplayActors;
+
+	int32 NextInput{0};
+	double StartTime{0.0};
+	bool bReplayStarted{false};
+
+	FMeleeCounters StartCounters;
+	double FrameMsSum{0.0};
+	int32 Frames{0};
+
+	FDelegateHandle DamageDealtHandle;
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Recorder
+public:
+	bool StartRecording();
+
+	/**
+	 * @brief Stops recording and writes the log.
+	 * @return Written file path, empty on failure.
+	 */
+	FString StopRecording(const FString& InName);
+
+	/**
+	 * @brief Spawns record actors and re-drives recorded input.
+	 * @param InName Log name in Saved/Profiling/MeleeRecords or full path.
+	 */
+	bool StartReplay(const FString& InName);
+
+	void StopReplay();
+
+	/**
+	 * @brief Called by UAdvancedWeaponManager for every input received by server.
+	 */
+	void RecordInput(UAdvancedWeaponManager* InManager, const FMeleeInputCommand& InCommand);
+
+	/**
+	 * @brief Bound to UAdvancedWeaponManager::OnDamageDealt.
+	 */
+	void RecordOutcome(UAdvancedWeaponManager* InCauser, AActor* InVictim, EDamageReturn InResult, float InDamage);
+
+	FORCEINLINE ECombatRecorderMode GetMode() const { return Mode; }
+
+	static UCombatRecorderSubsystem* Get(const UObject* WorldContextObject);
+
+	static FString GetRecordPath(const FString& InName);
+
+protected:
+	uint16 GetActorId(AActor* InActor);
+	float GetRecordTime() const;
+
+	void ResetSampling();
+
+	/** Fills frame and phase timing of the finished run */
+	void FinishSampling(FCombatRecord& OutRecord) const;
+
+	bool SpawnReplayActors();
+	void FinishReplay();
+
+	/**
+	 * @brief Compares recorded and replayed outcomes and timing.
+	 * @return Written report path.
+	 */
+	FString WriteReport(const FCombatRecord& InReplayTiming) const;
+#pragma endregion
+};
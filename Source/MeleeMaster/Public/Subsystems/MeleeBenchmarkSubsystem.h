@@ -0,0 +1,171 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Libs/MeleeCounters.h"
+#include "Libs/MeleeHarnessFixture.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeBenchmarkSubsystem.generated.h"
+
+class UAdvancedWeaponManager;
+class UWeaponDataAsset;
+
+/**
+ * @brief Scripted fighter of a benchmark brawl.
+ */
+struct FMeleeBenchBot
+{
+	TWeakObjectPtr<APawn> Pawn;
+	TWeakObjectPtr<UAdvancedWeaponManager> Manager;
+	double NextActionTime{0.0};
+	uint8 Step{0};
+	bool bAttacker{false};
+};
+
+/**
+ * @brief Headless combat benchmark (server or standalone).
+ * Spawns N fighters with UAdvancedWeaponManager in facing pairs, drives scripted attack/block cycles
+ * through the request proxies and writes frame time, traces, hits, RPC and net traffic, memory
+ * to Saved/Profiling/MeleeBench/*.json. Meant for -nullrhi dedicated server runs:
+ * melee.Bench.Brawl N [Seconds], melee.Bench.Suite [Seconds] (N = 10, 50, 100, 250), melee.Bench.Stop.
+ * RPC and net traffic are null without connected clients, bots call the RPCs locally then.
+ * A run fails if no melee trace was done or busy time p95 is over BusyTimeBudgetMs.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UMeleeBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/**
+	 * @brief Fighter class, [/Script/MeleeMaster.MeleeBenchmarkSubsystem] in DefaultGame.ini.
+	 * ACharacter if not set. Manager is added if the class has none.
+	 */
+	UPROPERTY(Config)
+	TSoftClassPtr<APawn> PawnClass;
+
+	/**
+	 * @brief Weapon given to every fighter, manager DefaultWeapons are used if not set.
+	 */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UWeaponDataAsset> Weapon;
+
+	UPROPERTY(Config)
+	FVector Origin{0.0f, 0.0f, 200.0f};
+
+	/** Distance between opponents of a pair */
+	UPROPERTY(Config)
+	float PairDistance{150.0f};
+
+	/** Distance between pairs */
+	UPROPERTY(Config)
+	float PairSpacing{400.0f};
+
+	/** Equip time before sampling starts (sec) */
+	UPROPERTY(Config)
+	float WarmupTime{3.0f};
+
+	UPROPERTY(Config)
+	TArray<int32> SuiteSizes{10, 50, 100, 250};
+
+	/** Busy time p95 budget of a passed run (ms), 0 disables the check */
+	UPROPERTY(Config)
+	float BusyTimeBudgetMs{33.3f};
+
+	/**
+	 * @brief Fighter spawning built from the config above.
+	 */
+	FORCEINLINE FMeleeHarnessFixture GetFixture() const
+	{
+		return FMeleeHarnessFixture(PawnClass, Weapon, Origin, PairDistance, PairSpacing);
+	}
+#pragma endregion
+
+#pragma region Properties
+protected:
+	TArray<FMeleeBenchBot> Bots;
+
+	/** Sizes left to run after the current one */
+	TArray<int32> PendingSizes;
+
+	int32 RunSize{0};
+	float RunDuration{0.0f};
+	double RunStartTime{0.0};
+	double SampleStartTime{0.0};
+	bool bRunning{false};
+	bool bSampling{false};
+
+	FRandomStream Random;
+
+	// Samples (ms)
+	TArray<float> FrameTimes;
+	TArray<float> BusyTimes;
+
+	// Snapshots taken when sampling starts
+	FMeleeCounters StartCounters;
+	int64 StartOutBytes{0};
+	int64 StartInBytes{0};
+	uint64 StartUsedPhysical{0};
+	uint64 PeakUsedPhysical{0};
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Benchmark
+public:
+	/**
+	 * @brief Starts a brawl of InSize fighters for InDuration seconds of sampling.
+	 * @return False if a run is in progress or the world has no authority.
+	 */
+	bool StartBrawl(int32 InSize, float InDuration);
+
+	/**
+	 * @brief Runs SuiteSizes one after another.
+	 */
+	bool StartSuite(float InDuration);
+
+	/**
+	 * @brief Stops current run without writing results, drops pending suite runs.
+	 */
+	void Stop();
+
+	FORCEINLINE bool IsRunning() const { return bRunning; }
+
+	static UMeleeBenchmarkSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	bool SpawnBots(int32 InSize);
+	void DestroyBots();
+
+	/**
+	 * @brief Advances scripted attack/block cycle of the bot.
+	 */
+	void DriveBot(FMeleeBenchBot& InBot, double InNow);
+
+	void BeginSampling();
+	void FinishRun();
+
+	/**
+	 * @brief Writes results of the finished run to Saved/Profiling/MeleeBench.
+	 * @param bOutPassed False if the run is over budget or no combat happened.
+	 * @return Written file path.
+	 */
+	FString WriteResults(double InElapsed, bool& bOutPassed) const;
+
+	void GetNetTotals(int64& OutBytes, int64& InBytes) const;
+
+	/**
+	 * @brief Client connections of the net driver, RPC and traffic numbers are meaningless without them.
+	 */
+	int32 GetClientConnectionNum() const;
+#pragma endregion
+};
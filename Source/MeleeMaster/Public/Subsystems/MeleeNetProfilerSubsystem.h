@@ -0,0 +1,162 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/CoreNet.h"
+#include "MeleeNetProfilerSubsystem.generated.h"
+
+class UAdvancedWeaponManager;
+class UNetConnection;
+
+/**
+ * @brief Count and size of one combat message kind.
+ */
+struct FMeleeNetStat
+{
+	int64 Count{0};
+	int64 Bits{0};
+
+	void Add(int64 InBits)
+	{
+		++Count;
+		Bits += InBits;
+	}
+};
+
+/**
+ * @brief Messages sent through one connection.
+ */
+struct FMeleeNetConnectionStats
+{
+	FString Name;
+	FMeleeNetStat Total;
+	TMap<FName, FMeleeNetStat> Messages;
+};
+
+/**
+ * @brief Per second window of combat traffic.
+ */
+struct FMeleeNetWindow
+{
+	TMap<FName, FMeleeNetStat> Rpcs;
+	TMap<FName, FMeleeNetStat> Properties;
+	TMap<TObjectKey<UNetConnection>, FMeleeNetConnectionStats> Connections;
+
+	void Reset();
+};
+
+/**
+ * @brief Package map of parameter sizing, writes a placeholder NetGUID for every object reference.
+ * Keeps the real package maps untouched (no GUID assignment or export).
+ */
+UCLASS(Transient)
+class MELEEMASTER_API UMeleeNetSizePackageMap : public UPackageMap
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override;
+};
+
+/**
+ * @brief Outgoing bandwidth of weapon managers per RPC, replicated property and connection,
+ * aggregated per second, written to CSV (MeleeMaster category) and printed by melee.Net.Report.
+ * Enabled by melee.Net.Profile 1.
+ * - RPC sizes are measured from connection send buffers around CallRemoteFunction. Unreliable multicasts are
+ *   queued on the actor channel and sent with the next property update, they are sized by serializing parameters.
+ * - Weapon subobject sizes are measured from the bunch (legacy replication path).
+ * - Manager property sizes are estimated on change (PreReplication) for every connection with an open channel.
+ * Exact per property wire sizes are available in Insights with -NetTrace=1 -trace=net, names match.
+ * Measures the legacy replication path only. With Iris replication (SetupIrisSupport, net.Iris.UseIrisReplication 1)
+ * RPCs and subobjects bypass the measured buffers, so the profiler stays off and only Insights is available.
+ */
+UCLASS()
+class MELEEMASTER_API UMeleeNetProfilerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Properties
+protected:
+	/** Window being collected */
+	FMeleeNetWindow Current;
+
+	/** Last finished window, reported per second */
+	FMeleeNetWindow Last;
+
+	double WindowStartTime{0.0};
+	float LastWindowSeconds{1.0f};
+
+	/** Sent bits of connections the RPC goes to before it is called, see BeginRpc */
+	TArray<TPair<UNetConnection*, int64>> RpcConnectionBits;
+
+	UPROPERTY(Transient)
+	UMeleeNetSizePackageMap* SizePackageMap{nullptr};
+
+	/** Last seen values of manager replicated properties */
+	TMap<TObjectKey<UAdvancedWeaponManager>, TSharedPtr<class FMeleePropertyShadow>> ManagerShadows;
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Profiler
+public:
+	/**
+	 * @brief melee.Net.Profile is set and replication is not Iris.
+	 */
+	static bool IsEnabled();
+
+	/**
+	 * @brief Iris replication system is used, the profiler is not supported.
+	 */
+	static bool IsUsingIris();
+
+	static UMeleeNetProfilerSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * @brief Snapshots sent bits of connections the RPC goes to, must be followed by EndRpc.
+	 * Multicasts go to every connection with an open channel of the owner, other RPCs to the owner connection.
+	 */
+	void BeginRpc(const UAdvancedWeaponManager* InManager, const UFunction* InFunction);
+
+	/**
+	 * @brief Attributes bits sent since BeginRpc to InFunction, counted even if nothing was written.
+	 * @param InParameters Parameters of the call, serialized to size queued unreliable multicasts.
+	 */
+	void EndRpc(const UFunction* InFunction, void* InParameters);
+
+	/**
+	 * @brief Records a measured replicated message (weapon subobject).
+	 */
+	void RecordProperty(FName InName, UNetConnection* InConnection, int64 InBits);
+
+	/**
+	 * @brief Estimates changed replicated properties of the manager.
+	 */
+	void SampleManagerProperties(UAdvancedWeaponManager* InManager);
+
+	/**
+	 * @brief Prints last second of traffic.
+	 */
+	void Dump(FOutputDevice& Ar) const;
+
+protected:
+	void GatherConnections(TArray<UNetConnection*>& OutConnections) const;
+
+	/**
+	 * @brief Serialized size of the RPC parameters (bits), without bunch and function headers.
+	 */
+	int64 MeasureParameterBits(const UFunction* InFunction, void* InParameters);
+	void AddToConnection(UNetConnection* InConnection, FName InName, int64 InBits);
+	void FinishWindow();
+#pragma endregion
+};
@@ -0,0 +1,137 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeRpcLimiterSubsystem.generated.h"
+
+class UAdvancedWeaponManager;
+class UNetConnection;
+
+/**
+ * @brief Token bucket and input counters of a client connection.
+ */
+struct FMeleeRpcLimiterConnection
+{
+	float Tokens{0.0f};
+	double LastRefillTime{-1.0};
+	double LastWarnTime{-1.0};
+
+	int64 Accepted{0};
+	/** Dropped by the token bucket */
+	int64 Dropped{0};
+	/** Collapsed into a later duplicate or inverse command */
+	int64 Coalesced{0};
+};
+
+/**
+ * @brief Combat commands of a manager received in the current net tick.
+ */
+struct FMeleeRpcLimiterQueue
+{
+	TWeakObjectPtr<UAdvancedWeaponManager> Manager;
+	TArray<FMeleeInputCommand, TInlineAllocator<4>> Commands;
+};
+
+/**
+ * @brief Server protection against combat RPC floods.
+ * Every combat RPC of a client connection takes a token of the connection bucket (TokensPerSecond,
+ * BurstSize), input without a token is dropped, except release input (see IsReleaseInput).
+ * Accepted input is held until the net tick is dispatched and executed in arrival order,
+ * a queued command followed by its duplicate or its inverse is collapsed.
+ * melee.Net.RateLimit, melee.Net.Coalesce, melee.Net.Limiter prints counters per connection,
+ * melee.Stress.Limiter checks both with fake connections.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UMeleeRpcLimiterSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/** Bucket refill per connection (commands per second) */
+	UPROPERTY(Config)
+	float TokensPerSecond{15.0f};
+
+	/** Bucket size per connection (commands) */
+	UPROPERTY(Config)
+	float BurstSize{30.0f};
+
+	/** Minimal time between drop warnings of a connection (sec) */
+	UPROPERTY(Config)
+	float WarnInterval{5.0f};
+#pragma endregion
+
+#pragma region Properties
+protected:
+	TMap<TObjectKey<UNetConnection>, FMeleeRpcLimiterConnection> Connections;
+
+	TArray<FMeleeRpcLimiterQueue> Queues;
+
+	FDelegateHandle PostTickDispatchHandle;
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+#pragma endregion
+
+#pragma region Limiter
+public:
+	static UMeleeRpcLimiterSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * @brief Release input ends a charge or a block, it is never dropped.
+	 * Dropping it would leave the server charging or blocking while the client released.
+	 */
+	static bool IsReleaseInput(EMeleeInputType InType);
+
+	static bool IsSameInput(const FMeleeInputCommand& InA, const FMeleeInputCommand& InB);
+
+	/**
+	 * @brief Whether InNext undoes InPrevious (Block - UnBlock, StartAttack - CancelCharge,
+	 * Equip - DeEquip of the same index, GetShield - RemoveShield).
+	 */
+	static bool IsInverseInput(const FMeleeInputCommand& InPrevious, const FMeleeInputCommand& InNext);
+
+	/**
+	 * @brief Called by UAdvancedWeaponManager for combat RPCs of a client connection.
+	 * The new command is appended to the queue of the manager, so arrival order is kept.
+	 * The last queued command is removed if the new one repeats or undoes it (Block, UnBlock runs as UnBlock).
+	 * @return Whether the input runs now, false if it is dropped or queued.
+	 */
+	bool AcceptInput(UAdvancedWeaponManager* InManager, UNetConnection* InConnection,
+		const FMeleeInputCommand& InCommand);
+
+	/**
+	 * @brief Counters of the connection, nullptr if it sent no combat input.
+	 */
+	const FMeleeRpcLimiterConnection* FindConnection(const UNetConnection* InConnection) const;
+
+	/**
+	 * @brief Commands of the manager waiting for the end of the net tick, nullptr if none.
+	 */
+	const FMeleeRpcLimiterQueue* FindQueue(const UAdvancedWeaponManager* InManager) const;
+
+	/**
+	 * @brief Forgets counters and bucket of the connection.
+	 */
+	void RemoveConnection(const UNetConnection* InConnection);
+
+	FORCEINLINE float GetBurstSize() const { return BurstSize; }
+
+	void Dump(FOutputDevice& Ar) const;
+
+protected:
+	/**
+	 * @brief Executes queued input, called after the net driver dispatched received packets.
+	 */
+	void FlushQueues();
+
+	void RemoveClosedConnections();
+#pragma endregion
+};
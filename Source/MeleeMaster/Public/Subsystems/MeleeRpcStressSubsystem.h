@@ -0,0 +1,207 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponTypes.h"
+#include "Libs/MeleeCounters.h"
+#include "Libs/MeleeHarnessFixture.h"
+#include "Libs/MeleeStateMachine.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeRpcStressSubsystem.generated.h"
+
+class UAdvancedWeaponManager;
+class UWeaponDataAsset;
+
+/**
+ * @brief Server cost of one input type.
+ */
+struct FMeleeStressInputStat
+{
+	int64 Num{0};
+	uint64 Cycles{0};
+	uint64 MaxCycles{0};
+	FMeleeHistogram Histogram;
+};
+
+/**
+ * @brief Hits of the current swing of a stress fighter.
+ * A victim takes damage once per swing if the weapon has UMeleeWeaponDataAsset::bDamageOncePerSwing.
+ */
+struct FMeleeStressSwing
+{
+	TMap<TObjectKey<AActor>, int32> Hits;
+};
+
+UENUM()
+enum class EMeleeStressPhase : uint8
+{
+	None,
+	Warmup,
+	Flood,
+	Settle
+};
+
+/**
+ * @brief Stress mode of the server combat input (server or standalone).
+ * Spawns N fighters in facing pairs and floods every one of them with randomized, reordered and duplicated
+ * StartAttack, Attack, Block, UnBlock, Equip, Change, GetShield and RemoveShield input through ExecuteInput,
+ * the same path as a received server RPC. Measures server cost per input type and, after the flood settles,
+ * checks invariants: no manager stuck out of Idle, no combat timer left on an idle manager,
+ * no invalid state transition, no damage outside of a swing or twice to one victim per swing.
+ * ExecuteInput bypasses the RPC limiter, melee.Stress.Limiter checks it separately.
+ * melee.Stress.Rpc N [Seconds=20] [Seed], results: Saved/Profiling/MeleeStress/*.json.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UMeleeRpcStressSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/**
+	 * @brief Fighter class, [/Script/MeleeMaster.MeleeRpcStressSubsystem] in DefaultGame.ini.
+	 * ACharacter if not set. Manager is added if the class has none.
+	 */
+	UPROPERTY(Config)
+	TSoftClassPtr<APawn> PawnClass;
+
+	/** Weapon added twice to every fighter to make Change possible, DefaultWeapons are used if not set */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UWeaponDataAsset> Weapon;
+
+	UPROPERTY(Config)
+	FVector Origin{0.0f, 0.0f, 200.0f};
+
+	UPROPERTY(Config)
+	float PairDistance{150.0f};
+
+	UPROPERTY(Config)
+	float PairSpacing{400.0f};
+
+	/** Equip time before the flood (sec) */
+	UPROPERTY(Config)
+	float WarmupTime{3.0f};
+
+	/** Inputs per fighter per second */
+	UPROPERTY(Config)
+	float InputRate{60.0f};
+
+	/** Chance of an input to be sent twice */
+	UPROPERTY(Config)
+	float DuplicateChance{0.25f};
+
+	/** Time given to pending timers after the flood before invariants are checked (sec) */
+	UPROPERTY(Config)
+	float SettleTime{5.0f};
+
+	/** Invariant violations written to the report */
+	UPROPERTY(Config)
+	int32 MaxReportedViolations{32};
+
+	/**
+	 * @brief Fighter spawning built from the config above.
+	 */
+	FORCEINLINE FMeleeHarnessFixture GetFixture() const
+	{
+		return FMeleeHarnessFixture(PawnClass, Weapon, Origin, PairDistance, PairSpacing);
+	}
+#pragma endregion
+
+#pragma region Properties
+protected:
+	EMeleeStressPhase Phase{EMeleeStressPhase::None};
+
+	TArray<TWeakObjectPtr<UAdvancedWeaponManager>> Managers;
+
+	/** Input of the frame, shuffled before it is executed */
+	TArray<TPair<int32, FMeleeInputCommand>> Batch;
+
+	FMeleeStressInputStat InputStats[static_cast<int32>(EMeleeInputType::RemoveShield) + 1];
+
+	TMap<TObjectKey<UAdvancedWeaponManager>, FMeleeStressSwing> Swings;
+
+	TArray<FString> Violations;
+
+	FRandomStream Random;
+
+	FDelegateHandle TransitionHandle;
+
+	FDelegateHandle DamageDealtHandle;
+
+	double PhaseStartTime{0.0};
+
+	float FloodDuration{0.0f};
+
+	/** Fractional input of the previous frames */
+	double InputDebt{0.0};
+
+	int32 RunSize{0};
+
+	int32 Seed{0};
+
+	/** Invalid transitions of the own fighters */
+	int32 InvalidTransitionNum{0};
+
+	int64 StaleDamageNum{0};
+
+	/** Counted for weapons with UMeleeWeaponDataAsset::bDamageOncePerSwing only */
+	int64 DoubleDamageNum{0};
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Stress
+public:
+	bool Start(int32 InSize, float InDuration, int32 InSeed);
+
+	void Stop();
+
+	FORCEINLINE bool IsRunning() const { return Phase != EMeleeStressPhase::None; }
+
+	/**
+	 * @brief Feeds UMeleeRpcLimiterSubsystem from fake client connections within one frame.
+	 * Input above the burst must be dropped except release input, queued input must keep arrival order
+	 * with duplicates and inverses collapsed. melee.Net.RateLimit and melee.Net.Coalesce are forced on for the check.
+	 * @return True if the limiter behaved as expected.
+	 */
+	bool CheckLimiter();
+
+	static UMeleeRpcStressSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	bool SpawnFighters(int32 InSize);
+
+	void DestroyFighters();
+
+	FMeleeInputCommand MakeRandomInput(const UAdvancedWeaponManager* InManager);
+
+	void Flood(float InDeltaTime);
+
+	/**
+	 * @brief Releases held charges and blocks, Idle is reachable from every state afterwards.
+	 */
+	void Release();
+
+	void OnTransition(UAdvancedWeaponManager* InManager, const FMeleeStateTransition& InTransition);
+
+	void OnDamageDealt(UAdvancedWeaponManager* InCauser, AActor* InVictim, EDamageReturn InResult, float InDamage);
+
+	void AddViolation(const FString& InViolation);
+
+	void CheckInvariants();
+
+	/**
+	 * @brief Writes results.
+	 * @return Written file path.
+	 */
+	FString WriteResults() const;
+#pragma endregion
+};
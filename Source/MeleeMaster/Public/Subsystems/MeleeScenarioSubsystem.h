@@ -0,0 +1,275 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponTypes.h"
+#include "Libs/MeleeHarnessFixture.h"
+#include "Libs/MeleeStateMachine.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeScenarioSubsystem.generated.h"
+
+class FJsonValue;
+class UAdvancedWeaponManager;
+class UWeaponDataAsset;
+
+UENUM()
+enum class EMeleeScenarioAction : uint8
+{
+	/** Fighter executes Input */
+	Input,
+	/** Fighter takes a hit of Damage from the opponent's weapon, as the game damage manager passes it */
+	Hit
+};
+
+/**
+ * @brief Input given to a scenario fighter.
+ */
+USTRUCT()
+struct FMeleeScenarioStep
+{
+	GENERATED_BODY()
+
+	/** Time since scenario start (sec) */
+	UPROPERTY(Config)
+	float Time{0.0f};
+
+	/** 0 - attacker, 1 - defender */
+	UPROPERTY(Config)
+	int32 Actor{0};
+
+	UPROPERTY(Config)
+	EMeleeScenarioAction Action{EMeleeScenarioAction::Input};
+
+	UPROPERTY(Config)
+	FMeleeInputCommand Input;
+
+	/** Hit only */
+	UPROPERTY(Config)
+	float Damage{0.0f};
+};
+
+/**
+ * @brief Fighting status a scenario fighter must enter.
+ * Expectations of a fighter must match its fighting transitions in order.
+ */
+USTRUCT()
+struct FMeleeScenarioExpectation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	int32 Actor{0};
+
+	UPROPERTY(Config)
+	EWeaponFightingStatus Status{EWeaponFightingStatus::Idle};
+
+	/** Earliest time since scenario start the status is entered, not checked if < 0 */
+	UPROPERTY(Config)
+	float MinTime{-1.0f};
+
+	/** Latest time since scenario start the status is entered, not checked if < 0 */
+	UPROPERTY(Config)
+	float MaxTime{-1.0f};
+};
+
+USTRUCT()
+struct FMeleeScenario
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	FString Name;
+
+	UPROPERTY(Config)
+	TArray<FMeleeScenarioStep> Steps;
+
+	UPROPERTY(Config)
+	TArray<FMeleeScenarioExpectation> Expected;
+
+	/** Time since scenario start when transitions are compared (sec) */
+	UPROPERTY(Config)
+	float Duration{3.0f};
+
+	/** Set on built-in scenarios the weapon data can not run, the scenario is reported as skipped */
+	FString SkipReason;
+};
+
+/**
+ * @brief Transition of a scenario fighter, time is since scenario start.
+ */
+struct FMeleeScenarioTransition
+{
+	int32 Actor{0};
+	FMeleeStateTransition Transition;
+};
+
+/**
+ * @brief Outcome of a finished scenario.
+ */
+struct FMeleeScenarioResult
+{
+	FString Name;
+	bool bPassed{false};
+	bool bSkipped{false};
+	TArray<FString> Errors;
+	TArray<FMeleeScenarioTransition> Transitions;
+};
+
+UENUM()
+enum class EMeleeScenarioPhase : uint8
+{
+	None,
+	Equipping,
+	Running
+};
+
+/**
+ * @brief Functional check of the combat state machine (server or standalone).
+ * Spawns an attacker and a defender, equips Weapon, drives scripted input through ExecuteInput,
+ * records every status change and compares fighting transitions and their timing with the expectations.
+ * World time runs with a fixed step while scenarios run, with -benchmark the engine does not wait
+ * for real time, so timer-driven flow is fast-forwarded deterministically.
+ * Built-in scenarios (Swing, CancelCharge, BlockRelease, ChargeToBlock, ParryStun, ShieldDurability) take timing
+ * from the weapon data, ParryStun and ShieldDurability are skipped if the data can not parry or has no shield.
+ * Hits are given to the defender directly, the game damage manager is not involved.
+ * melee.Scenario.Run [Name], results: Saved/Profiling/MeleeScenario/*.json.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UMeleeScenarioSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/**
+	 * @brief Fighter class, [/Script/MeleeMaster.MeleeScenarioSubsystem] in DefaultGame.ini.
+	 * ACharacter if not set. Manager is added if the class has none.
+	 */
+	UPROPERTY(Config)
+	TSoftClassPtr<APawn> PawnClass;
+
+	/** Melee weapon of both fighters, manager DefaultWeapons are used if not set */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UWeaponDataAsset> Weapon;
+
+	UPROPERTY(Config)
+	FVector Origin{0.0f, 0.0f, 200.0f};
+
+	/** Distance between attacker and defender */
+	UPROPERTY(Config)
+	float PairDistance{150.0f};
+
+	/** World time step while scenarios run (sec) */
+	UPROPERTY(Config)
+	float FixedStep{1.0f / 60.0f};
+
+	/** Equip time limit before a scenario fails (sec) */
+	UPROPERTY(Config)
+	float EquipTimeout{5.0f};
+
+	UPROPERTY(Config)
+	TArray<FMeleeScenario> Scenarios;
+
+	/**
+	 * @brief Fighter spawning built from the config above.
+	 */
+	FORCEINLINE FMeleeHarnessFixture GetFixture() const
+	{
+		return FMeleeHarnessFixture(PawnClass, Weapon, Origin, PairDistance);
+	}
+#pragma endregion
+
+#pragma region Properties
+protected:
+	EMeleeScenarioPhase Phase{EMeleeScenarioPhase::None};
+
+	/** Scenarios left to run after the current one */
+	TArray<FString> PendingNames;
+
+	FMeleeScenario Current;
+
+	TWeakObjectPtr<UAdvancedWeaponManager> Managers[2];
+
+	TArray<FMeleeScenarioTransition> Transitions;
+
+	TArray<TSharedPtr<FJsonValue>> Results;
+
+	/** Outcome of the scenarios of the last run */
+	TArray<FMeleeScenarioResult> LastResults;
+
+	/** Weapon of both fighters given to Run, Weapon is used if null */
+	UPROPERTY(Transient)
+	UWeaponDataAsset* WeaponOverride{nullptr};
+
+	FDelegateHandle TransitionHandle;
+
+	double PhaseStartTime{0.0};
+
+	int32 NextStep{0};
+
+	int32 FailedNum{0};
+
+	bool bPreviousFixedTimeStep{false};
+
+	double PreviousFixedDeltaTime{0.0};
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Scenario
+public:
+	/**
+	 * @brief Runs scenarios one by one.
+	 * @param InName Scenario name, all if empty.
+	 * @param InWeapon Weapon of both fighters instead of the configured one.
+	 */
+	bool Run(const FString& InName, UWeaponDataAsset* InWeapon = nullptr);
+
+	void Stop();
+
+	FORCEINLINE bool IsRunning() const { return Phase != EMeleeScenarioPhase::None; }
+
+	FORCEINLINE float GetFixedStep() const { return FixedStep; }
+
+	/** Outcome of the scenarios of the last run, kept until the next one starts */
+	FORCEINLINE const TArray<FMeleeScenarioResult>& GetLastResults() const { return LastResults; }
+
+	static UMeleeScenarioSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	/**
+	 * @brief Scenarios with expected timing of the equipped melee weapon.
+	 */
+	void MakeBuiltInScenarios(const UAdvancedWeaponManager* InManager, TArray<FMeleeScenario>& OutScenarios) const;
+
+	bool FindScenario(const FString& InName, FMeleeScenario& OutScenario) const;
+
+	bool StartNext();
+
+	bool SpawnFighters();
+
+	void DestroyFighters();
+
+	/**
+	 * @brief Gives InVictim a hit of InDamage from the weapon of InCauser.
+	 */
+	void ApplyHit(UAdvancedWeaponManager* InVictim, UAdvancedWeaponManager* InCauser, float InDamage) const;
+
+	void OnTransition(UAdvancedWeaponManager* InManager, const FMeleeStateTransition& InTransition);
+
+	/**
+	 * @brief Compares recorded transitions with the expectations and adds the result.
+	 */
+	void FinishScenario(const FString& InError);
+
+	void FinishRun();
+#pragma endregion
+};
@@ -0,0 +1,76 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Libs/MeleeCounters.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeStatsSubsystem.generated.h"
+
+/**
+ * @brief One second of combat health.
+ */
+struct FMeleeStatsWindow
+{
+	float Seconds{0.0f};
+
+	// Rates (per second)
+	float Traces{0.0f};
+	float TracesSkipped{0.0f};
+	float Hits{0.0f};
+	float Blocks{0.0f};
+	float Parries{0.0f};
+	float Rpcs{0.0f};
+	float TargetsPerTrace{0.0f};
+
+	// Gauges
+	int32 Managers{0};
+	int32 ActiveSwings{0};
+	int32 ActiveTimers{0};
+	int32 WeaponVisuals{0};
+	int32 ModifierManagers{0};
+	/** Unacknowledged reliable bunches of the most loaded connection */
+	int32 MaxReliableQueue{0};
+	float AvgReliableQueue{0.0f};
+
+	/** Phase scope durations of the window */
+	FMeleeHistogram PhaseHistograms[static_cast<int32>(EMeleePhase::Num)];
+};
+
+/**
+ * @brief Live combat health: aggregates FMeleeCounters and world gauges once per second,
+ * prints them on melee.Stats and logs a summary every melee.Stats.LogInterval seconds.
+ */
+UCLASS()
+class MELEEMASTER_API UMeleeStatsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Properties
+protected:
+	FMeleeCounters PreviousCounters;
+	FMeleeStatsWindow Last;
+	double WindowStartTime{0.0};
+	double LastLogTime{0.0};
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+#pragma endregion
+
+#pragma region Stats
+public:
+	static UMeleeStatsSubsystem* Get(const UObject* WorldContextObject);
+
+	FORCEINLINE const FMeleeStatsWindow& GetLastWindow() const { return Last; }
+
+	void Dump(FOutputDevice& Ar) const;
+
+protected:
+	void FinishWindow(double InSeconds);
+	void SampleGauges(FMeleeStatsWindow& OutWindow) const;
+#pragma endregion
+};
@@ -0,0 +1,283 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectileSubsystem.generated.h"
+
+struct FProjectileImpact;
+
+DECLARE_DELEGATE_OneParam(FOnProjectileImpact, const FProjectileImpact&);
+
+/**
+ * @brief Parameters of a single projectile flight.
+ */
+struct MELEEMASTER_API FProjectileLaunchParams
+{
+	FVector Origin{FVector::ZeroVector};
+	FVector Velocity{FVector::ZeroVector};
+
+	/** Gravity acceleration along Z (cm/s^2), negative is down */
+	float Gravity{-980.0f};
+
+	/** Quadratic drag coefficient (1/cm), deceleration = Drag * |v|^2 */
+	float Drag{0.0f};
+
+	/** Sweep sphere radius (cm), 0 for line trace */
+	float Radius{0.0f};
+
+	/** Flight time before the projectile is dropped (sec) */
+	float LifeTime{5.0f};
+
+	/** How long stuck visual stays in the world (sec), 0 to release on impact */
+	float StuckLifeTime{10.0f};
+
+	ECollisionChannel TraceChannel{ECC_Visibility};
+
+	/** Sweeps and reports impacts. Cosmetic projectiles only move their visual */
+	bool bReportImpacts{true};
+
+	/** Rewind registered targets by this time (sec) when testing hits, 0 to disable lag compensation */
+	float RewindTime{0.0f};
+
+	/** Time already elapsed since the shot (sec), simulated immediately in fixed steps and swept in one pass */
+	float FastForwardTime{0.0f};
+
+	float Damage{0.0f};
+
+	/** Ignored by sweeps and passed to impact */
+	TWeakObjectPtr<AActor> Causer;
+
+	/** Pooled visual actor class, materialized on non dedicated machines only */
+	TSubclassOf<AActor> VisualClass;
+
+	FOnProjectileImpact OnImpact;
+};
+
+/**
+ * @brief Impact reported by UProjectileSubsystem.
+ */
+struct MELEEMASTER_API FProjectileImpact
+{
+	int32 ProjectileId{INDEX_NONE};
+	FHitResult Hit;
+	FVector Velocity{FVector::ZeroVector};
+	float Damage{0.0f};
+	TWeakObjectPtr<AActor> Causer;
+};
+
+/**
+ * @brief Cold data of in-flight projectile, touched on impact only.
+ */
+struct FProjectileInfo
+{
+	float StuckLifeTime{0.0f};
+	float Damage{0.0f};
+	float RewindTime{0.0f};
+	ECollisionChannel TraceChannel{ECC_Visibility};
+	bool bReportImpacts{true};
+	TWeakObjectPtr<AActor> Causer;
+	TWeakObjectPtr<AActor> Visual;
+	FOnProjectileImpact OnImpact;
+};
+
+/**
+ * @brief Transform history of a lag compensated target (server only).
+ */
+struct FProjectileRewindTarget
+{
+	TWeakObjectPtr<AActor> Actor;
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	float Radius{0.0f};
+	float HalfHeight{0.0f};
+
+	/** Ring buffer of sampled locations */
+	TArray<FVector> Locations;
+	TArray<double> Times;
+	int32 Head{0};
+
+	/**
+	 * @brief Interpolated location at the time, oldest sample if history is too short.
+	 */
+	bool GetLocationAt(double InTime, FVector& OutLocation) const;
+
+	void AddSample(const FVector& InLocation, double InTime, int32 InCapacity);
+};
+
+/**
+ * @brief World owned projectiles without per-projectile actors.
+ * State is kept in contiguous arrays, integrated in one (optionally parallel) batch per frame,
+ * then swept in one pass. Actors are materialized only for visuals and stuck arrows (from UVisualPoolSubsystem).
+ */
+UCLASS()
+class MELEEMASTER_API UProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Properties
+protected:
+	// Hot data, same index in every array
+	TArray<int32> Ids;
+	TArray<FVector> Positions;
+	TArray<FVector> PreviousPositions;
+	TArray<FVector> Velocities;
+	TArray<float> Gravities;
+	TArray<float> Drags;
+	TArray<float> Radii;
+	TArray<float> TimeLeft;
+
+	// Cold data
+	TArray<FProjectileInfo> Infos;
+
+	struct FStuckVisual
+	{
+		TWeakObjectPtr<AActor> Actor;
+		double ReleaseTime{0.0};
+	};
+	TArray<FStuckVisual> StuckVisuals;
+
+	TArray<FProjectileRewindTarget> RewindTargets;
+
+	/** In-flight projectiles with rewind time that report impacts */
+	int32 RewindProjectileNum{0};
+
+	/**
+	 * @brief Frames target history is still recorded.
+	 * Reset to one history window while lag compensated projectiles fly, so the next shot has history too.
+	 */
+	int32 RewindRecordFramesLeft{0};
+
+	/** Impacts found during a step, reported once the arrays are no longer iterated */
+	TArray<TPair<FOnProjectileImpact, FProjectileImpact>> PendingImpacts;
+
+	/** Not simulated time, less than one fixed step */
+	float StepAccumulator{0.0f};
+
+	int32 LastProjectileId{0};
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Projectiles
+public:
+	/**
+	 * @brief Starts a projectile flight.
+	 * @param InParams Launch parameters.
+	 * @return Projectile id, INDEX_NONE if failed.
+	 */
+	int32 Launch(const FProjectileLaunchParams& InParams);
+
+	/**
+	 * @brief Drops the projectile without impact.
+	 * @return True if projectile was in flight.
+	 */
+	bool Cancel(int32 InProjectileId);
+
+	/**
+	 * @brief Registers capsule of the actor for lag compensated hits (server only).
+	 * History is recorded only while lag compensated projectiles fly and one history window after.
+	 * @param InActor Target actor.
+	 * @param InComponent Component reported in hit results.
+	 * @param InRadius Capsule radius.
+	 * @param InHalfHeight Capsule half height.
+	 */
+	void RegisterRewindTarget(AActor* InActor, UPrimitiveComponent* InComponent, float InRadius, float InHalfHeight);
+
+	void UnregisterRewindTarget(AActor* InActor);
+
+	/**
+	 * @return Number of in-flight projectiles.
+	 */
+	FORCEINLINE int32 Num() const { return Ids.Num(); }
+
+	/**
+	 * @brief Projectile subsystem of the world, nullptr if not supported.
+	 */
+	static UProjectileSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	/**
+	 * @brief Single fixed step: integrate, sweep, impacts and expiration.
+	 */
+	void SimulateStep(float InStep);
+
+	/**
+	 * @brief Integrates velocity and position of every projectile.
+	 */
+	void Integrate(float InDeltaTime);
+
+public:
+	/**
+	 * @brief Deterministic projectile step, shared by every machine simulating the same launch.
+	 */
+	static void IntegrateStep(FVector& InOutPosition, FVector& InOutVelocity, float InGravity, float InDrag,
+		float InStep);
+
+protected:
+
+	/**
+	 * @brief Tests segment against rewound target capsules.
+	 * @param InStart Segment start.
+	 * @param InEnd Segment end.
+	 * @param InRadius Projectile radius.
+	 * @param InTime World time to rewind targets to.
+	 * @param InIgnore Actor to skip (causer).
+	 * @param OutHit Nearest hit, moved to the current target location.
+	 * @return True if any target was hit.
+	 */
+	bool SweepRewindTargets(const FVector& InStart, const FVector& InEnd, float InRadius, double InTime,
+		const AActor* InIgnore, FHitResult& OutHit) const;
+
+	/**
+	 * @brief Samples current location of every rewind target while history is needed.
+	 * @see RewindRecordFramesLeft
+	 */
+	void RecordRewindHistory();
+
+	/**
+	 * @brief Line trace, or sphere sweep if radius is positive, against the world.
+	 * @return True if a blocking hit was found.
+	 */
+	bool SweepWorld(const FVector& InStart, const FVector& InEnd, float InRadius, ECollisionChannel InChannel,
+		const FCollisionQueryParams& InQueryParams, FHitResult& OutHit) const;
+
+	/**
+	 * @brief Sweeps every projectile from previous to current position.
+	 * @param OutImpacts Indices and hits of projectiles that hit something.
+	 */
+	void Sweep(TArray<TPair<int32, FHitResult>>& OutImpacts) const;
+
+	/**
+	 * @brief Moves materialized visuals to projectile transforms.
+	 * @param InExtrapolation Time since the last fixed step.
+	 */
+	void UpdateVisuals(float InExtrapolation);
+
+	/**
+	 * @brief Queues impact report, sticks visual and removes the projectile.
+	 * @see ReportImpacts
+	 */
+	void HandleImpact(int32 InIndex, const FHitResult& InHit);
+
+	/**
+	 * @brief Executes queued impact callbacks, they are free to launch or cancel projectiles.
+	 */
+	void ReportImpacts();
+
+	/**
+	 * @brief Removes projectile data at index (swap), visual is released if not kept.
+	 */
+	void RemoveAtSwap(int32 InIndex, bool bReleaseVisual);
+
+	void ReleaseVisual(AActor* InVisual) const;
+	void ReleaseStuckVisuals();
+#pragma endregion
+};
@@ -0,0 +1,166 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TrailSubsystem.generated.h"
+
+class UNiagaraComponent;
+class UNiagaraSystem;
+
+/**
+ * @brief Slot of the shared trail ring buffer.
+ */
+struct FTrailSlot
+{
+	TWeakObjectPtr<USceneComponent> Mesh;
+	FName StartSocket;
+	FName EndSocket;
+	int32 TrailId{INDEX_NONE};
+	/** Index of the newest sample inside the slot */
+	int32 Head{INDEX_NONE};
+	/** Number of valid samples, shrinks after the trail is ended */
+	int32 Count{0};
+	bool bEnded{false};
+	/** Squared distance to the local view, local player trails are 0 */
+	float Priority{0.0f};
+
+	FORCEINLINE bool IsUsed() const { return TrailId != INDEX_NONE; }
+};
+
+/**
+ * @brief Weapon trails of the world, rendered by one Niagara system.
+ * Blade start/end socket positions of every active trail are recorded each frame into one shared
+ * ring buffer (SamplesPerTrail samples per slot) and pushed to TrailSystem through array data interfaces.
+ * Number of simultaneous trails is limited by MaxTrails, closest to the local view win.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UTrailSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/**
+	 * @brief Batched trail system, [/Script/MeleeMaster.TrailSubsystem] in DefaultGame.ini.
+	 * Must read the array user parameters below, use world space and fixed bounds.
+	 * Visuals fall back to their ShowTrail/HideTrail events if it is not set.
+	 */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UNiagaraSystem> TrailSystem;
+
+	UPROPERTY(Config)
+	int32 MaxTrails{24};
+
+	UPROPERTY(Config)
+	int32 SamplesPerTrail{12};
+
+	/** Vector array, MaxTrails * SamplesPerTrail blade start positions */
+	UPROPERTY(Config)
+	FName StartsParameter{TEXT("TrailStarts")};
+
+	/** Vector array, MaxTrails * SamplesPerTrail blade end positions */
+	UPROPERTY(Config)
+	FName EndsParameter{TEXT("TrailEnds")};
+
+	/** Int array, newest sample index per slot */
+	UPROPERTY(Config)
+	FName HeadsParameter{TEXT("TrailHeads")};
+
+	/** Int array, valid sample count per slot, 0 for free slots */
+	UPROPERTY(Config)
+	FName CountsParameter{TEXT("TrailCounts")};
+
+	/** Int, SamplesPerTrail */
+	UPROPERTY(Config)
+	FName SamplesParameter{TEXT("SamplesPerTrail")};
+#pragma endregion
+
+#pragma region Properties
+protected:
+	UPROPERTY(Transient)
+	UNiagaraComponent* TrailComponent{nullptr};
+
+	TArray<FTrailSlot> Slots;
+
+	// Shared ring buffer, slot i owns [i * SamplesPerTrail, (i + 1) * SamplesPerTrail)
+	TArray<FVector> StartSamples;
+	TArray<FVector> EndSamples;
+	TArray<int32> Heads;
+	TArray<int32> Counts;
+
+	int32 UsedSlots{0};
+	int32 LastTrailId{0};
+
+	/** Buffers changed since the last push */
+	bool bPushPending{false};
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+#pragma endregion
+
+#pragma region Trails
+public:
+	/**
+	 * @brief Starts recording trail between two sockets of the mesh.
+	 * @param InMesh Blade mesh.
+	 * @param InStartSocket Blade start socket.
+	 * @param InEndSocket Blade end socket.
+	 * @return Trail id, INDEX_NONE if batched trails are not available or the budget is taken by closer trails.
+	 */
+	int32 BeginTrail(USceneComponent* InMesh, FName InStartSocket, FName InEndSocket);
+
+	/**
+	 * @brief Stops recording, the trail fades out over SamplesPerTrail frames.
+	 */
+	void EndTrail(int32 InTrailId);
+
+	/**
+	 * @return True if the trail system is spawned.
+	 */
+	bool IsAvailable() const;
+
+	/**
+	 * @return Number of slots in use (active and fading).
+	 */
+	FORCEINLINE int32 Num() const { return UsedSlots; }
+
+	/**
+	 * @brief Trail subsystem of the world, nullptr if not supported.
+	 */
+	static UTrailSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	/**
+	 * @brief Effective trail budget, melee.Trail.MaxTrails overrides config.
+	 */
+	int32 GetMaxTrails() const;
+
+	/**
+	 * @brief Allocates buffers for the budget, frees every trail if it changed.
+	 */
+	void EnsureBuffers();
+
+	/**
+	 * @brief Squared distance from the local view, 0 for trails of the local player.
+	 */
+	float EvaluatePriority(const USceneComponent* InMesh) const;
+
+	/**
+	 * @brief Free slot index, or index of the least important slot if it is less important than InPriority.
+	 */
+	int32 FindSlot(float InPriority) const;
+
+	void RecordSample(FTrailSlot& InSlot, int32 InSlotIndex);
+	void FreeSlot(int32 InSlotIndex);
+	void PushToSystem();
+#pragma endregion
+};
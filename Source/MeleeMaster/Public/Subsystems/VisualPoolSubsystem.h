@@ -0,0 +1,170 @@
+﻿// © Artem Podorozhko. All Rights Reserved. This project, including all associated assets, code, and content, is the property of Artem Podorozhko. Unauthorized use, distribution, or modification is strictly prohibited.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VisualPoolSubsystem.generated.h"
+
+/**
+ * @brief Actors of the class spawned on map load.
+ */
+USTRUCT(BlueprintType)
+struct MELEEMASTER_API FVisualPoolPrewarm
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="VisualPool")
+	TSoftClassPtr<AActor> ActorClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="VisualPool", meta=(ClampMin="0"))
+	int32 Count{0};
+};
+
+/**
+ * @brief Pool usage counters, per class or total.
+ */
+USTRUCT(BlueprintType)
+struct MELEEMASTER_API FVisualPoolStats
+{
+	GENERATED_BODY()
+
+	/** Acquires served by a pooled actor */
+	UPROPERTY(BlueprintReadOnly, Category="VisualPool")
+	int32 Hits{0};
+
+	/** Acquires that had to spawn a new actor */
+	UPROPERTY(BlueprintReadOnly, Category="VisualPool")
+	int32 Misses{0};
+
+	/** Actors currently acquired */
+	UPROPERTY(BlueprintReadOnly, Category="VisualPool")
+	int32 InUse{0};
+
+	/** Maximum of InUse since the world started */
+	UPROPERTY(BlueprintReadOnly, Category="VisualPool")
+	int32 HighWater{0};
+
+	/** Actors waiting in the pool */
+	UPROPERTY(BlueprintReadOnly, Category="VisualPool")
+	int32 Free{0};
+
+	float GetHitRate() const
+	{
+		const int32 total = Hits + Misses;
+		return total > 0 ? static_cast<float>(Hits) / static_cast<float>(total) : 0.0f;
+	}
+};
+
+USTRUCT()
+struct FVisualPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<AActor*> FreeActors;
+
+	FVisualPoolStats Stats;
+};
+
+/**
+ * @brief World pool of cosmetic, non replicated actors (weapon and arrow visuals).
+ * Avoids actor spawn/destroy churn on respawn-heavy modes.
+ * Pooled actors may implement IPooledVisual to reset their state.
+ */
+UCLASS(Config=Game)
+class MELEEMASTER_API UVisualPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Config
+protected:
+	/**
+	 * @brief Actors spawned on map load, [/Script/MeleeMaster.VisualPoolSubsystem] in DefaultGame.ini
+	 */
+	UPROPERTY(Config)
+	TArray<FVisualPoolPrewarm> Prewarm;
+
+	/**
+	 * @brief Released actors above this count are destroyed instead of pooled.
+	 */
+	UPROPERTY(Config)
+	int32 MaxFreePerClass{64};
+#pragma endregion
+
+#pragma region Properties
+protected:
+	UPROPERTY(Transient)
+	TMap<UClass*, FVisualPoolBucket> Buckets;
+
+	/**
+	 * @brief Pooled actors currently acquired, to their class bucket.
+	 */
+	TMap<TObjectKey<AActor>, UClass*> AcquiredActors;
+#pragma endregion
+
+#pragma region Overrides
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+#pragma endregion
+
+#pragma region Pool
+public:
+	/**
+	 * @brief Takes a pooled actor of the class or spawns a new one.
+	 * Actor is not replicated, has already begun play and is moved to the transform.
+	 * @param InClass Actor class.
+	 * @param InTransform World transform.
+	 * @param InOwner New owner (and instigator, if pawn).
+	 * @return Actor, nullptr if class is invalid.
+	 */
+	AActor* Acquire(UClass* InClass, const FTransform& InTransform, AActor* InOwner);
+
+	template <class T>
+	T* Acquire(TSubclassOf<T> InClass, const FTransform& InTransform, AActor* InOwner)
+	{
+		AActor* actor = Acquire(InClass.Get(), InTransform, InOwner);
+		T* typed = Cast<T>(actor);
+		if (actor && !typed)
+		{
+			// Not usable by the caller, give it back instead of leaking it as in use
+			Release(actor);
+		}
+		return typed;
+	}
+
+	/**
+	 * @brief Returns an acquired actor to the pool. Actors not acquired from the pool are destroyed.
+	 * @param InActor Actor to release.
+	 */
+	void Release(AActor* InActor);
+
+	/**
+	 * @brief Spawns actors of the class into the pool.
+	 * @param InClass Actor class.
+	 * @param InCount Number of actors to add.
+	 */
+	void PrewarmClass(UClass* InClass, int32 InCount);
+
+	/**
+	 * @brief Gets pool counters.
+	 * @param InClass Class to get, nullptr for the total of all classes.
+	 */
+	FVisualPoolStats GetStats(UClass* InClass = nullptr) const;
+
+	/**
+	 * @brief Logs counters of every class.
+	 */
+	void DumpStats() const;
+
+	/**
+	 * @brief Pool of the actor's world, nullptr if not supported.
+	 */
+	static UVisualPoolSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	AActor* SpawnPooledActor(UClass* InClass, const FTransform& InTransform);
+#pragma endregion
+};
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
+#include "Engine/NetSerialization.h"
 #include "WeaponTypes.generated.h"
 
 class UWeaponHitPathAsset;
@@ -426,6 +427,22 @@ enum class EWeaponDirection : uint8
 	Left
 };
 
+UENUM(Blueprintable, BlueprintType)
+enum class EWeaponModifierSignificance : uint8
+{
+	Full, // Local player, modifier is updated every frame
+	Reduced, // On screen and near, updated every ModifierReducedInterval
+	Insignificant // Off screen or distant, only state transitions are sent
+};
+
+UENUM(Blueprintable, BlueprintType)
+enum class EWeaponVisualLOD : uint8
+{
+	Full, // Shadows and trails
+	Reduced, // No shadows, trails are skipped
+	Proxy // Reduced, weapons on the back are drawn with static mesh proxy
+};
+
 UENUM(Blueprintable, BlueprintType)
 enum class EBlockResult : uint8
 {
@@ -437,6 +454,78 @@ enum class EBlockResult : uint8
 	Invalid
 };
 
+/**
+ * @struct FWeaponHandle
+ * @brief Compact weapon identifier, unique inside a single weapon manager.
+ * Used for replication and lookups instead of the GUID string. Zero is invalid.
+ */
+USTRUCT(BlueprintType)
+struct MELEEMASTER_API FWeaponHandle
+{
+	GENERATED_BODY()
+
+public:
+	FWeaponHandle() {}
+
+	explicit FWeaponHandle(uint16 InValue) : Value(InValue) {}
+
+public:
+	UPROPERTY()
+	uint16 Value{0};
+
+public:
+	FORCEINLINE bool IsValid() const { return Value != 0; }
+
+	FORCEINLINE bool operator==(const FWeaponHandle& Other) const { return Value == Other.Value; }
+	FORCEINLINE bool operator!=(const FWeaponHandle& Other) const { return Value != Other.Value; }
+
+	friend FORCEINLINE uint32 GetTypeHash(const FWeaponHandle& InHandle) { return InHandle.Value; }
+};
+
+/**
+ * @struct FArrowLaunchRecord
+ * @brief Compact arrow shot, replicated instead of a moving projectile.
+ * Server and clients simulate the same trajectory from it with the fixed step projectile integrator.
+ */
+USTRUCT()
+struct MELEEMASTER_API FArrowLaunchRecord
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	/** Hit power quantized to 0..255 */
+	UPROPERTY()
+	uint8 Power{0};
+
+	/** Seed of the arrow spread */
+	UPROPERTY()
+	uint16 Seed{0};
+
+	/** Server world time of the shot, used by clients to catch up. Double, float loses milliseconds after hours */
+	UPROPERTY()
+	double ServerTime{0.0};
+
+public:
+	FORCEINLINE float GetPower() const { return Power / 255.0f; }
+
+	FORCEINLINE static uint8 QuantizePower(float InPower)
+	{
+		return static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(InPower, 0.0f, 1.0f) * 255.0f));
+	}
+
+	/**
+	 * @brief Rounds origin and direction the same way network serialization does,
+	 * so the server simulates exactly what clients receive.
+	 */
+	void Quantize();
+};
+
 
 class UAimOffsetBlendSpace1D;
 
@@ -764,3 +853,53 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	FGameplayTag Block;
 };
+
+/**
+ * @brief Client input received by server RPCs of UAdvancedWeaponManager.
+ */
+UENUM(Blueprintable, BlueprintType)
+enum class EMeleeInputType : uint8
+{
+	Equip,
+	DeEquip,
+	Change,
+	StartAttack,
+	StartAttackSimple,
+	Attack,
+	Block,
+	UnBlock,
+	CancelCharge,
+	GetShield,
+	RemoveShield
+};
+
+/**
+ * @brief Input command with arguments of the matching server RPC.
+ * Recorded by UCombatRecorderSubsystem, executed by UAdvancedWeaponManager::ExecuteInput.
+ */
+USTRUCT(Blueprintable, BlueprintType)
+struct MELEEMASTER_API FMeleeInputCommand
+{
+	GENERATED_BODY()
+
+public:
+	FMeleeInputCommand() {}
+
+	FMeleeInputCommand(EMeleeInputType InType, int32 InIndex = INDEX_NONE,
+		EWeaponDirection InDirection = EWeaponDirection::Forward)
+		: Type(InType), Index(InIndex), Direction(InDirection)
+	{
+	}
+
+public:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	EMeleeInputType Type{EMeleeInputType::Attack};
+
+	/** Weapon index of Equip, DeEquip, Change */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	int32 Index{INDEX_NONE};
+
+	/** Direction of StartAttack, Block */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	EWeaponDirection Direction{EWeaponDirection::Forward};
+};